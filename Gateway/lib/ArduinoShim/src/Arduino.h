@@ -0,0 +1,79 @@
+#ifndef ARDUINO_SHIM_H
+#define ARDUINO_SHIM_H
+
+// Subconjunto do core Arduino para compilar os módulos puros do Gateway
+// (codec, parser, dedup, outbox, bench) no host, no ambiente "native" do
+// platformio.ini. Só existe o que esses módulos e os testes usam: String
+// (com indexOf/substring para a referência do caminho antigo no bench),
+// Print/Serial escrevendo em stdout e o relógio (millis/micros/delay).
+// Não define ARDUINO, então o código específico do ESP32 continua de fora.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <string>
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+
+class String {
+private:
+    std::string text;
+
+public:
+    String() {}
+    String(const char *value) : text(value != nullptr ? value : "") {}
+    String(int value) : text(std::to_string(value)) {}
+    String(unsigned int value) : text(std::to_string(value)) {}
+    String(long value) : text(std::to_string(value)) {}
+    String(unsigned long value) : text(std::to_string(value)) {}
+
+    const char *c_str() const { return text.c_str(); }
+    unsigned int length() const { return (unsigned int)text.size(); }
+    bool reserve(unsigned int size) { text.reserve(size); return true; }
+    bool concat(const char *value) { text += value; return true; }
+    bool concat(char value) { text += value; return true; }
+
+    String &operator+=(const String &value) { text += value.text; return *this; }
+    String &operator+=(const char *value) { text += value; return *this; }
+    String &operator+=(char value) { text += value; return *this; }
+    bool operator==(const char *value) const { return text == value; }
+    bool operator==(const String &value) const { return text == value.text; }
+    char operator[](unsigned int index) const { return text[index]; }
+    char charAt(unsigned int index) const { return index < text.size() ? text[index] : 0; }
+    int indexOf(const char *value, unsigned int from = 0) const {
+        size_t index = text.find(value, from);
+        return index == std::string::npos ? -1 : (int)index;
+    }
+    String substring(unsigned int from) const { return substring(from, length()); }
+    String substring(unsigned int from, unsigned int to) const {
+        return from < to && from < text.size() ? String(text.substr(from, to - from).c_str()) : String();
+    }
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t byte) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+
+    size_t print(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+    size_t println(const char *text = "") { return print(text) + print("\n"); }
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void flush() { fflush(stdout); }
+    size_t write(uint8_t byte) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,110 @@
+#include "ack_tracker.h"
+#include <string.h>
+
+AckTracker::AckTracker() {
+    reset();
+}
+
+void AckTracker::reset() {
+    for (size_t i = 0; i < ACK_TRACKER_SLOTS; i++) {
+        slots[i].used = false;
+    }
+    memset(&stats, 0, sizeof(stats));
+}
+
+void AckTracker::record(uint16_t deviceAddr, uint16_t sequence, uint32_t nowMs) {
+    Slot *slot = nullptr;
+    Slot *free = nullptr;
+    Slot *oldest = nullptr;
+    for (size_t i = 0; i < ACK_TRACKER_SLOTS; i++) {
+        Slot &candidate = slots[i];
+        if (!candidate.used) {
+            if (free == nullptr) free = &candidate;
+            continue;
+        }
+        if (candidate.ack.device_addr == deviceAddr) {
+            slot = &candidate;
+            break;
+        }
+        if (oldest == nullptr || nowMs - candidate.lastMs > nowMs - oldest->lastMs) {
+            oldest = &candidate;
+        }
+    }
+
+    if (slot == nullptr) {
+        slot = free;
+        if (slot == nullptr) {
+            stats.evicted++;
+            slot = oldest;
+        }
+        slot->used = true;
+        slot->ack.device_addr = deviceAddr;
+        slot->ack.base = sequence;
+        slot->ack.bitmap = 0;
+        slot->lastMs = nowMs;
+    }
+
+    // A leitura pode ser marcada depois de outras mais novas do mesmo
+    // transmissor terem sido ouvidas (touch)
+    if ((int32_t)(nowMs - slot->lastMs) > 0) {
+        slot->lastMs = nowMs;
+    }
+    if (ackSet(slot->ack, sequence)) {
+        stats.recorded++;
+    } else {
+        stats.outOfWindow++;
+    }
+}
+
+void AckTracker::touch(uint16_t deviceAddr, uint32_t nowMs) {
+    for (size_t i = 0; i < ACK_TRACKER_SLOTS; i++) {
+        Slot &slot = slots[i];
+        if (slot.used && slot.ack.device_addr == deviceAddr) {
+            slot.lastMs = nowMs;
+            return;
+        }
+    }
+}
+
+bool AckTracker::takeDue(uint32_t nowMs, uint32_t delayMs, AckFrame &ack) {
+    Slot *due = nullptr;
+    for (size_t i = 0; i < ACK_TRACKER_SLOTS; i++) {
+        Slot &slot = slots[i];
+        if (slot.used && nowMs - slot.lastMs >= delayMs &&
+            (due == nullptr || nowMs - slot.lastMs > nowMs - due->lastMs)) {
+            due = &slot;
+        }
+    }
+    if (due == nullptr) {
+        return false;
+    }
+    ack = due->ack;
+    due->used = false;
+    return true;
+}
+
+uint32_t AckTracker::nextDueMs(uint32_t nowMs, uint32_t delayMs) const {
+    uint32_t next = UINT32_MAX;
+    for (size_t i = 0; i < ACK_TRACKER_SLOTS; i++) {
+        const Slot &slot = slots[i];
+        if (!slot.used) {
+            continue;
+        }
+        uint32_t elapsed = nowMs - slot.lastMs;
+        uint32_t wait = elapsed >= delayMs ? 0 : delayMs - elapsed;
+        if (wait < next) {
+            next = wait;
+        }
+    }
+    return next;
+}
+
+size_t AckTracker::pendingCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < ACK_TRACKER_SLOTS; i++) {
+        if (slots[i].used) {
+            count++;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,67 @@
+#ifndef ACK_TRACKER_H
+#define ACK_TRACKER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "frame.h"
+
+// Confirmações pendentes do Gateway para os transmissores (FRAME_TYPE_ACK,
+// ver frame.h).
+//
+// Cada transmissor que mandou leituras desde a última confirmação ocupa um
+// de ACK_TRACKER_SLOTS slots fixos, com a janela ancorada na primeira
+// sequência ouvida. A confirmação fica pronta quando o transmissor passa
+// delayMs sem mandar nada (terminou a rajada e está esperando); leituras
+// fora da janela não entram nela e são confirmadas quando o transmissor
+// as reenviar. Com todos os slots ocupados, o transmissor mais antigo
+// perde a confirmação e reenvia tudo.
+//
+// O Gateway só marca aqui leituras já gravadas no flash da outbox (ver
+// LoRaReceiver::collectStored). Exceções: sem LittleFS montado a outbox é
+// só RAM, e com AGGREGATION_MODE a leitura resumida vive só no resumo em
+// RAM; nos dois casos a confirmação não protege contra um reboot.
+//
+// Não faz alocação dinâmica e não depende do Arduino.
+
+#ifndef ACK_TRACKER_SLOTS
+#define ACK_TRACKER_SLOTS 8
+#endif
+
+struct AckTrackerStats {
+    uint32_t recorded;          // Leituras marcadas
+    uint32_t outOfWindow;       // Leituras fora da janela do slot
+    uint32_t evicted;           // Confirmações descartadas por falta de slot
+};
+
+class AckTracker {
+private:
+    struct Slot {
+        AckFrame ack;
+        uint32_t lastMs;        // Última leitura do transmissor
+        bool used;
+    };
+
+    Slot slots[ACK_TRACKER_SLOTS];
+    AckTrackerStats stats;
+
+public:
+    AckTracker();
+    void reset();
+
+    // Marca uma leitura recebida (ou já recebida antes) do transmissor
+    void record(uint16_t deviceAddr, uint16_t sequence, uint32_t nowMs);
+
+    // Transmissor ouvido agora: adia a confirmação pendente dele, se houver
+    void touch(uint16_t deviceAddr, uint32_t nowMs);
+
+    // Retira a confirmação mais antiga já pronta; false se nenhuma estiver
+    bool takeDue(uint32_t nowMs, uint32_t delayMs, AckFrame &ack);
+
+    // ms até a próxima confirmação ficar pronta (UINT32_MAX se não houver)
+    uint32_t nextDueMs(uint32_t nowMs, uint32_t delayMs) const;
+
+    size_t pendingCount() const;
+    const AckTrackerStats &getStats() const { return stats; }
+};
+
+#endif
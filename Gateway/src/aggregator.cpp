@@ -0,0 +1,102 @@
+#include "aggregator.h"
+#include <string.h>
+
+#define AGGREGATE_TABLE_MASK (AGGREGATE_TABLE_SIZE - 1)
+#define AGGREGATE_MAX_OPEN (AGGREGATE_TABLE_SIZE - AGGREGATE_TABLE_SIZE / 8)
+
+static inline void metricAdd(MetricSummary &metric, int16_t value, bool first) {
+    if (first) {
+        metric.sum = value;
+        metric.min = value;
+        metric.max = value;
+    } else {
+        metric.sum += value;
+        if (value < metric.min) metric.min = value;
+        if (value > metric.max) metric.max = value;
+    }
+    metric.last = value;
+}
+
+bool readingInBounds(const ReadingFrame &reading) {
+    return reading.heart_rate >= AGGREGATE_HR_MIN && reading.heart_rate <= AGGREGATE_HR_MAX &&
+           reading.oxygen_level >= AGGREGATE_SPO2_MIN &&
+           reading.temperature_centi >= AGGREGATE_TEMP_MIN_CENTI &&
+           reading.temperature_centi <= AGGREGATE_TEMP_MAX_CENTI;
+}
+
+Aggregator::Aggregator()
+    : openCount(0), windowStartMs(0), folded(0), excursions(0), droppedSummaries(0) {
+    memset(open, 0, sizeof(open));
+}
+
+bool Aggregator::add(const ReadingFrame &reading, uint32_t nowMs) {
+    // Procura o acumulador do transmissor (sondagem linear)
+    size_t index = ((uint32_t)reading.device_addr * 2654435769u >> 16) & AGGREGATE_TABLE_MASK;
+    AggregateSummary *summary = nullptr;
+    for (size_t probe = 0; probe < AGGREGATE_TABLE_SIZE; probe++) {
+        AggregateSummary &slot = open[(index + probe) & AGGREGATE_TABLE_MASK];
+        if (slot.count == 0) {
+            if (openCount >= AGGREGATE_MAX_OPEN) {
+                return false;   // Tabela cheia: segue como leitura individual
+            }
+            if (openCount == 0) {
+                windowStartMs = nowMs;
+            }
+            slot.device_addr = reading.device_addr;
+            openCount++;
+            summary = &slot;
+            break;
+        }
+        if (slot.device_addr == reading.device_addr) {
+            summary = &slot;
+            break;
+        }
+    }
+    if (summary == nullptr) {
+        return false;
+    }
+
+    bool first = summary->count == 0;
+    metricAdd(summary->heartRate, reading.heart_rate, first);
+    metricAdd(summary->oxygen, reading.oxygen_level, first);
+    metricAdd(summary->temperature, reading.temperature_centi, first);
+    if (summary->count < UINT16_MAX) {
+        summary->count++;
+    }
+    folded++;
+
+    if (!readingInBounds(reading)) {
+        excursions++;
+        return false;
+    }
+    return true;
+}
+
+bool Aggregator::windowDue(uint32_t nowMs) const {
+    return openCount > 0 && (nowMs - windowStartMs) >= (uint32_t)AGGREGATE_WINDOW_S * 1000;
+}
+
+uint32_t Aggregator::msUntilWindowEnd(uint32_t nowMs) const {
+    if (openCount == 0) {
+        return UINT32_MAX;
+    }
+    uint32_t elapsed = nowMs - windowStartMs;
+    uint32_t window = (uint32_t)AGGREGATE_WINDOW_S * 1000;
+    return elapsed >= window ? 0 : window - elapsed;
+}
+
+void Aggregator::closeWindow(uint32_t nowMs) {
+    for (size_t i = 0; i < AGGREGATE_TABLE_SIZE; i++) {
+        AggregateSummary &slot = open[i];
+        if (slot.count == 0) {
+            continue;
+        }
+        slot.windowEndMs = nowMs;
+        slot.windowMs = nowMs - windowStartMs;
+        if (!ready.push(slot)) {
+            droppedSummaries++;
+        }
+    }
+    memset(open, 0, sizeof(open));
+    openCount = 0;
+}
@@ -0,0 +1,101 @@
+#ifndef AGGREGATOR_H
+#define AGGREGATOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "frame.h"
+#include "ring_buffer.h"
+
+// Modo de agregação na borda (build flag AGGREGATION_MODE=1).
+//
+// Em vez de enviar cada leitura, o Gateway acumula por transmissor, numa
+// janela de AGGREGATE_WINDOW_S segundos, mínimo/máximo/média/última e a
+// contagem de HR, SpO2 e temperatura. Ao fim da janela só o resumo de cada
+// transmissor vai para a API. Leituras fora dos limites clínicos
+// configurados entram no resumo e também são enviadas individualmente.
+//
+// Os acumuladores ficam numa tabela de endereçamento aberto esvaziada a
+// cada janela; se ela encher, as leituras excedentes seguem como leituras
+// individuais. Os resumos prontos esperam o envio numa fila em RAM (não
+// vão para a outbox no flash).
+
+#ifndef AGGREGATION_MODE
+#define AGGREGATION_MODE 0
+#endif
+#ifndef AGGREGATE_WINDOW_S
+#define AGGREGATE_WINDOW_S 60
+#endif
+#ifndef AGGREGATE_TABLE_SIZE
+#define AGGREGATE_TABLE_SIZE 64       // Transmissores por janela (potência de 2, até 7/8 ocupados)
+#endif
+#ifndef AGGREGATE_QUEUE_SIZE
+#define AGGREGATE_QUEUE_SIZE 64       // Resumos aguardando envio (potência de 2)
+#endif
+
+// Limites clínicos: leituras fora deles são enviadas individualmente
+#ifndef AGGREGATE_HR_MIN
+#define AGGREGATE_HR_MIN 50
+#endif
+#ifndef AGGREGATE_HR_MAX
+#define AGGREGATE_HR_MAX 120
+#endif
+#ifndef AGGREGATE_SPO2_MIN
+#define AGGREGATE_SPO2_MIN 92
+#endif
+#ifndef AGGREGATE_TEMP_MIN_CENTI
+#define AGGREGATE_TEMP_MIN_CENTI 3500   // 35,00 °C
+#endif
+#ifndef AGGREGATE_TEMP_MAX_CENTI
+#define AGGREGATE_TEMP_MAX_CENTI 3800   // 38,00 °C
+#endif
+
+static_assert((AGGREGATE_TABLE_SIZE & (AGGREGATE_TABLE_SIZE - 1)) == 0, "AGGREGATE_TABLE_SIZE deve ser potência de 2");
+
+// Acumulador de uma grandeza (temperatura em 0,01 °C)
+struct MetricSummary {
+    int32_t sum;
+    int16_t min;
+    int16_t max;
+    int16_t last;
+};
+
+struct AggregateSummary {
+    MetricSummary heartRate;
+    MetricSummary oxygen;
+    MetricSummary temperature;
+    uint32_t windowEndMs;       // millis() do fechamento da janela
+    uint32_t windowMs;          // Duração da janela
+    uint16_t device_addr;
+    uint16_t count;             // 0 = posição livre na tabela
+};
+
+class Aggregator {
+private:
+    AggregateSummary open[AGGREGATE_TABLE_SIZE];
+    size_t openCount;
+    uint32_t windowStartMs;
+    RingBuffer<AggregateSummary, AGGREGATE_QUEUE_SIZE> ready;
+    uint32_t folded;            // Leituras absorvidas em resumos
+    uint32_t excursions;        // Leituras fora dos limites
+    uint32_t droppedSummaries;  // Resumos perdidos com a fila cheia
+
+public:
+    Aggregator();
+    // true se a leitura foi absorvida; false se deve ser enviada individualmente
+    bool add(const ReadingFrame &reading, uint32_t nowMs);
+    bool windowDue(uint32_t nowMs) const;
+    uint32_t msUntilWindowEnd(uint32_t nowMs) const;
+    void closeWindow(uint32_t nowMs);
+
+    size_t peek(AggregateSummary *summaries, size_t maxSummaries) const { return ready.peek(summaries, maxSummaries); }
+    void acknowledge(size_t count) { ready.discard(count); }
+    size_t pendingCount() const { return ready.size(); }
+
+    uint32_t foldedCount() const { return folded; }
+    uint32_t excursionCount() const { return excursions; }
+    uint32_t droppedCount() const { return droppedSummaries; }
+};
+
+bool readingInBounds(const ReadingFrame &reading);
+
+#endif
@@ -0,0 +1,546 @@
+#include "bench.h"
+#include <new>
+#include <string.h>
+#include <stdlib.h>
+#include <atomic>
+#include <vector>
+#include "frame.h"
+#include "frame_parser.h"
+#include "dedup.h"
+#include "device_table.h"
+#include "outbox.h"
+#include "uplink_codec.h"
+#include "gzip.h"
+#ifdef ARDUINO
+#include <ArduinoJson.h>
+#endif
+
+#define BENCH_BURST_FRAMES 10
+#define BENCH_BATCH_SIZE 20
+#define BENCH_CORPUS_SIZE 512
+#define BENCH_DEDUP_STREAM 64
+#define BENCH_TABLE_DEVICES 64
+
+#if BENCH_TRACK_ALLOCS
+// Contagem global de alocações
+static std::atomic<uint32_t> benchAllocations(0);
+
+#ifdef ARDUINO
+// No ESP32 via --wrap do linker
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    benchAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    benchAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    benchAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __real_realloc(ptr, size);
+}
+}
+#else
+// No host o malloc da libstdc++ não passa pelo --wrap: conta o operator new
+void *operator new(size_t size) {
+    benchAllocations.fetch_add(1, std::memory_order_relaxed);
+    void *ptr = malloc(size > 0 ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    free(ptr);
+}
+#endif
+#endif
+
+typedef size_t (*BenchFunction)();    // Retorna bytes processados na operação
+
+struct BenchResult {
+    unsigned long nsOp;
+    size_t bytes;
+};
+
+// Entradas dos casos, montadas uma vez por execução do bench
+static ReadingFrame benchReading;
+static uint8_t benchFrame[FRAME_READING_SIZE];
+static ReadingFrame benchBurst[BENCH_BURST_FRAMES];
+static uint8_t benchBurstFrame[FRAME_MAX_SIZE];
+static size_t benchBurstLength;
+static uint8_t benchCorpus[BENCH_CORPUS_SIZE];
+static size_t benchCorpusLength;
+static uint16_t benchSequences[BENCH_DEDUP_STREAM];
+static DeviceTable *benchTable;
+static uint16_t benchTableSequence;
+static Outbox *benchOutbox;
+static OutboxRecord benchRecords[BENCH_BATCH_SIZE];
+static ReceivedData benchBatch[BENCH_BATCH_SIZE];
+static uint8_t benchOutput[3 + BENCH_BATCH_SIZE * CBOR_READING_MAX_SIZE];
+static String benchJSON;
+static GzipCompressor *benchCompressor;
+static uint8_t *benchCompressed;
+#define BENCH_COMPRESSED_SIZE 2048
+
+static uint32_t benchFrames;
+static void benchOnFrame(const ParsedFrame &frame, void *context) {
+    benchFrames++;
+}
+static FrameParser benchParser(benchOnFrame, nullptr);
+
+static size_t benchEncodeReading() {
+    return encodeReadingFrame(benchReading, benchFrame, sizeof(benchFrame));
+}
+
+static size_t benchDecodeReading() {
+    ReadingFrame reading;
+    decodeReadingFrame(benchFrame, sizeof(benchFrame), reading);
+    return sizeof(benchFrame);
+}
+
+static size_t benchEncodeBurst() {
+    size_t encoded;
+    return encodeBurstFrame(benchBurst, BENCH_BURST_FRAMES, benchBurstFrame, sizeof(benchBurstFrame), encoded);
+}
+
+static size_t benchDecodeBurst() {
+    FrameHeader header;
+    const uint8_t *payload;
+    ReadingFrame readings[FRAME_BURST_MAX_READINGS];
+    size_t count;
+    decodeFrame(benchBurstFrame, benchBurstLength, header, payload);
+    decodeBurstPayload(header, payload, readings, FRAME_BURST_MAX_READINGS, count);
+    return benchBurstLength;
+}
+
+static size_t benchParseCorpus() {
+    benchParser.feed(benchCorpus, benchCorpusLength);
+    benchParser.flush();
+    return benchCorpusLength;
+}
+
+// Referência: o caminho de recepção anterior ao FrameParser, sem os
+// Serial.println que ele fazia a cada mensagem. Uma String por mensagem,
+// indexOf/substring para separar os JSON concatenados ("}{") e um
+// std::vector de leituras com o id em String
+struct BenchLegacyReading {
+    String device_id;
+    int heart_rate;
+    int oxygen_level;
+    float temperature;
+};
+
+static size_t benchLegacyFrames() {
+    // Como o antigo extractFrames(): tenta cada posição até achar um frame
+    std::vector<BenchLegacyReading> readings;
+    size_t pos = 0;
+    while (pos < benchCorpusLength) {
+        size_t frameSize = frameTotalSize(benchCorpus + pos, benchCorpusLength - pos);
+        ReadingFrame reading;
+        if (frameSize == 0 || frameSize > benchCorpusLength - pos ||
+            decodeReadingFrame(benchCorpus + pos, frameSize, reading) != FRAME_OK) {
+            pos++;
+            continue;
+        }
+        char deviceId[12];
+        snprintf(deviceId, sizeof(deviceId), "TR-%03u", reading.device_addr);
+        BenchLegacyReading data;
+        data.device_id = deviceId;
+        data.heart_rate = reading.heart_rate;
+        data.oxygen_level = reading.oxygen_level;
+        data.temperature = frameTemperatureFromCenti(reading.temperature_centi);
+        readings.push_back(data);
+        pos += frameSize;
+    }
+    benchFrames += readings.size();
+    return benchCorpusLength;
+}
+
+static bool benchLegacyParseJSON(const String &json, BenchLegacyReading &data) {
+#ifdef ARDUINO
+    // O antigo parseJSON(): documento ArduinoJson por mensagem
+    JsonDocument doc;
+    if (deserializeJson(doc, json)) {
+        return false;
+    }
+    data.device_id = doc["id"].as<String>();
+    data.heart_rate = doc["hr"] | -1;
+    data.oxygen_level = doc["ox"] | -1;
+    data.temperature = doc["temp"] | 14.0f;
+#else
+    // Sem ArduinoJson no host: os campos por indexOf, o que deixa a
+    // referência mais rápida do que ela era no ESP32
+    int id = json.indexOf("\"id\":\"");
+    int idEnd = id < 0 ? -1 : json.indexOf("\"", id + 6);
+    int hr = json.indexOf("\"hr\":");
+    int ox = json.indexOf("\"ox\":");
+    int temp = json.indexOf("\"temp\":");
+    if (idEnd < 0 || hr < 0 || ox < 0 || temp < 0) {
+        return false;
+    }
+    data.device_id = json.substring(id + 6, idEnd);
+    data.heart_rate = atoi(json.c_str() + hr + 5);
+    data.oxygen_level = atoi(json.c_str() + ox + 5);
+    data.temperature = (float)atof(json.c_str() + temp + 7);
+#endif
+    return data.device_id.length() > 0 && data.heart_rate != -1 && data.oxygen_level != -1;
+}
+
+static size_t benchLegacyJSON() {
+    // Como o antigo receiveMessages()/extractMultipleJSONs()
+    std::vector<BenchLegacyReading> readings;
+    String data((const char *)benchCorpus);
+    if (data.indexOf("}{") != -1) {
+        String cleanData = "";
+        for (unsigned int i = 0; i < data.length(); i++) {
+            char c = data.charAt(i);
+            if (c >= 32 && c <= 126) {
+                cleanData += c;
+            }
+        }
+        int pos = 0;
+        while (pos < (int)cleanData.length()) {
+            int start = cleanData.indexOf("{\"id\":", pos);
+            if (start == -1) {
+                break;
+            }
+            int nextJsonStart = cleanData.indexOf("{\"id\":", start + 1);
+            String possibleJson = nextJsonStart == -1 ? cleanData.substring(start)
+                                                      : cleanData.substring(start, nextJsonStart);
+            int braceCount = 0;
+            int jsonEnd = -1;
+            for (unsigned int i = 0; i < possibleJson.length() && jsonEnd == -1; i++) {
+                char c = possibleJson.charAt(i);
+                if (c == '{') {
+                    braceCount++;
+                } else if (c == '}' && --braceCount == 0) {
+                    jsonEnd = (int)i;
+                }
+            }
+            if (jsonEnd == -1) {
+                pos = start + 1;
+                continue;
+            }
+            String jsonString = possibleJson.substring(0, jsonEnd + 1);
+            BenchLegacyReading reading;
+            if (jsonString.indexOf("\"id\":") != -1 && jsonString.indexOf("\"hr\":") != -1 &&
+                jsonString.indexOf("\"ox\":") != -1 && jsonString.indexOf("\"temp\":") != -1 &&
+                benchLegacyParseJSON(jsonString, reading)) {
+                readings.push_back(reading);
+            }
+            pos = start + jsonEnd + 1;
+        }
+    } else {
+        BenchLegacyReading reading;
+        if (benchLegacyParseJSON(data, reading)) {
+            readings.push_back(reading);
+        }
+    }
+    benchFrames += readings.size();
+    return benchCorpusLength;
+}
+
+static size_t benchDedupStream() {
+    // Janela nova a cada operação: mesma sequência de aceites e duplicatas
+    SequenceWindow window = {};
+    for (size_t i = 0; i < BENCH_DEDUP_STREAM; i++) {
+        sequenceAccept(window, benchSequences[i]);
+    }
+    return sizeof(benchSequences);
+}
+
+static size_t benchTableRecord() {
+    // Uma leitura nova de cada dispositivo, com a tabela já populada
+    for (uint16_t i = 0; i < BENCH_TABLE_DEVICES; i++) {
+        ReadingFrame reading = benchReading;
+        reading.device_addr = (uint16_t)(i * 37 + 1);
+        reading.sequence = benchTableSequence;
+        benchTable->record(reading, true, benchTableSequence);
+    }
+    benchTableSequence++;
+    return BENCH_TABLE_DEVICES * FRAME_READING_SIZE;
+}
+
+static size_t benchOutboxRoundTrip() {
+    // Ciclo do uplink: guarda um lote, lê de volta e confirma
+    for (uint16_t i = 0; i < BENCH_BATCH_SIZE; i++) {
+        ReadingFrame reading = benchReading;
+        reading.sequence = i;
+        benchOutbox->append(reading, 0);
+    }
+    benchOutbox->flush();
+    size_t count = benchOutbox->peek(benchRecords, BENCH_BATCH_SIZE);
+    benchOutbox->acknowledge(count);
+    return count * sizeof(OutboxRecord);
+}
+
+static size_t benchReadingJSON() {
+    return createReadingJSON(benchBatch[0]).length();
+}
+
+static size_t benchBatchJSON() {
+    return createBatchJSON(benchBatch, BENCH_BATCH_SIZE).length();
+}
+
+static size_t benchBatchCBOR() {
+    return createReadingsCBOR(benchBatch, BENCH_BATCH_SIZE, true, benchOutput, sizeof(benchOutput));
+}
+
+static size_t benchGzipJSON() {
+    return benchCompressor->compress((const uint8_t *)benchJSON.c_str(), benchJSON.length(),
+                                     benchCompressed, BENCH_COMPRESSED_SIZE);
+}
+
+static BenchResult benchCase(Print &out, BenchFormat format, const char *name, BenchFunction function) {
+    // Dobra as iterações até o caso durar pelo menos BENCH_MIN_US
+    uint32_t iterations = 1;
+    uint32_t elapsed = 0;
+    uint32_t allocations = 0;
+    size_t bytes = 0;
+    for (;;) {
+#if BENCH_TRACK_ALLOCS
+        uint32_t allocationsBefore = benchAllocations.load(std::memory_order_relaxed);
+#endif
+        uint32_t start = micros();
+        for (uint32_t i = 0; i < iterations; i++) {
+            bytes = function();
+        }
+        elapsed = micros() - start;
+#if BENCH_TRACK_ALLOCS
+        allocations = benchAllocations.load(std::memory_order_relaxed) - allocationsBefore;
+#endif
+        if (elapsed >= BENCH_MIN_US || iterations >= BENCH_MAX_ITERATIONS) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    char allocs[16];
+#if BENCH_TRACK_ALLOCS
+    snprintf(allocs, sizeof(allocs), "%.2f", (float)allocations / iterations);
+#else
+    (void)allocations;
+    snprintf(allocs, sizeof(allocs), format == BENCH_FORMAT_JSON ? "null" : "na");
+#endif
+    unsigned long nsOp = (unsigned long)((uint64_t)elapsed * 1000 / iterations);
+    switch (format) {
+    case BENCH_FORMAT_JSON:
+        out.printf("{\"name\":\"%s\",\"iterations\":%lu,\"ns_op\":%lu,\"allocs_op\":%s,\"bytes_op\":%u}\n", name,
+                   (unsigned long)iterations, nsOp, allocs, (unsigned)bytes);
+        break;
+    case BENCH_FORMAT_CSV:
+        out.printf("%s,%lu,%lu,%s,%u\n", name, (unsigned long)iterations, nsOp, allocs, (unsigned)bytes);
+        break;
+    default:
+        out.printf("bench name=%s iterations=%lu ns_op=%lu allocs_op=%s bytes_op=%u\n", name,
+                   (unsigned long)iterations, nsOp, allocs, (unsigned)bytes);
+        break;
+    }
+
+    // Deixa as outras tarefas do núcleo rodarem entre os casos
+    delay(1);
+    return { nsOp, bytes };
+}
+
+static void buildBinaryBurst(bool corrupt) {
+    // Rajada de frames de leitura; a versão corrompida tem lixo entre os
+    // frames e CRC inválido em um a cada três
+    benchCorpusLength = 0;
+    for (uint16_t i = 0; i < BENCH_BURST_FRAMES; i++) {
+        ReadingFrame reading = benchReading;
+        reading.sequence = i;
+        size_t length = encodeReadingFrame(reading, benchCorpus + benchCorpusLength,
+                                           sizeof(benchCorpus) - benchCorpusLength);
+        if (corrupt && i % 3 == 0) {
+            benchCorpus[benchCorpusLength + length - 1] ^= 0x5A;
+        }
+        benchCorpusLength += length;
+        if (corrupt) {
+            static const uint8_t garbage[] = { 0x00, 0xFF, 0x7B, 0x13, 0x10 };
+            memcpy(benchCorpus + benchCorpusLength, garbage, sizeof(garbage));
+            benchCorpusLength += sizeof(garbage);
+        }
+    }
+}
+
+static void buildJSONBurst() {
+    // Formato legado: objetos concatenados ("}{")
+    benchCorpusLength = 0;
+    for (int i = 0; i < BENCH_BURST_FRAMES; i++) {
+        int written = snprintf((char *)benchCorpus + benchCorpusLength, sizeof(benchCorpus) - benchCorpusLength,
+                               "{\"id\":\"TR-002\",\"hr\":%d,\"ox\":97,\"temp\":36.%d}", 70 + i, i);
+        benchCorpusLength += written;
+    }
+}
+
+static void buildSequenceStream() {
+    // Em ordem, com uma retransmissão a cada 8 e uma troca de ordem a cada 16
+    for (uint16_t i = 0; i < BENCH_DEDUP_STREAM; i++) {
+        benchSequences[i] = i;
+        if (i % 8 == 7) benchSequences[i] = (uint16_t)(i - 3);
+        if (i % 16 == 15) {
+            benchSequences[i] = benchSequences[i - 1];
+            benchSequences[i - 1] = i;
+        }
+    }
+}
+
+static void buildVariedBatch() {
+    // Lote sintético menos repetitivo que o padrão: 20 transmissores
+    // diferentes e sinais espalhados (gerador congruente fixo)
+    uint32_t state = 12345;
+    for (size_t i = 0; i < BENCH_BATCH_SIZE; i++) {
+        state = state * 1103515245u + 12345u;
+        ReadingFrame reading = benchReading;
+        reading.device_addr = (uint16_t)(i * 211 + 1);
+        reading.heart_rate = (uint8_t)(50 + (state >> 8) % 90);
+        reading.oxygen_level = (uint8_t)(88 + (state >> 16) % 12);
+        reading.temperature_centi = (int16_t)(3500 + (state >> 20) % 300);
+        benchBatch[i] = toReceivedData(reading);
+    }
+}
+
+static void benchGzipCase(Print &out, BenchFormat format, const char *name) {
+    // Além da linha do caso: taxa de compressão e tempo por KB de entrada
+    BenchResult result = benchCase(out, format, name, benchGzipJSON);
+    if (format == BENCH_FORMAT_TEXT && result.bytes > 0) {
+        out.printf("# bench gzip name=%s in=%u out=%u ratio=%.2f us_kb=%.1f\n", name, benchJSON.length(),
+                   (unsigned)result.bytes, (double)result.bytes / benchJSON.length(),
+                   result.nsOp * 1.024 / benchJSON.length());
+    }
+}
+
+static void benchSkip(Print &out, BenchFormat format, const char *name, const char *reason) {
+    if (format == BENCH_FORMAT_TEXT) {
+        out.printf("# bench skip name=%s reason=%s\n", name, reason);
+    }
+}
+
+void benchRun(Print &out, BenchFormat format, const char *outboxPath) {
+    if (format == BENCH_FORMAT_TEXT) {
+        out.printf("# bench start min_us=%lu\n", (unsigned long)BENCH_MIN_US);
+    } else if (format == BENCH_FORMAT_CSV) {
+        out.printf("name,iterations,ns_op,allocs_op,bytes_op\n");
+    }
+
+    benchReading.device_addr = 0x0002;
+    benchReading.sequence = 1;
+    benchReading.heart_rate = 72;
+    benchReading.oxygen_level = 97;
+    benchReading.temperature_centi = 3650;
+    for (uint16_t i = 0; i < BENCH_BURST_FRAMES; i++) {
+        ReadingFrame reading = benchReading;
+        reading.sequence = (uint16_t)(benchReading.sequence + i);
+        reading.heart_rate = (uint8_t)(72 + i % 3);
+        reading.temperature_centi = (int16_t)(3650 + i * 2);
+        benchBurst[i] = reading;
+    }
+
+    benchCase(out, format, "frame.encode_reading", benchEncodeReading);
+    benchCase(out, format, "frame.decode_reading", benchDecodeReading);
+    benchBurstLength = benchEncodeBurst();
+    benchCase(out, format, "frame.encode_burst", benchEncodeBurst);
+    benchCase(out, format, "frame.decode_burst", benchDecodeBurst);
+
+    encodeReadingFrame(benchReading, benchCorpus, sizeof(benchCorpus));
+    benchCorpusLength = FRAME_READING_SIZE;
+    benchCase(out, format, "parser.single_frame", benchParseCorpus);
+    buildBinaryBurst(false);
+    benchCase(out, format, "parser.burst_frames", benchParseCorpus);
+    benchCase(out, format, "legacy.burst_frames", benchLegacyFrames);
+    buildBinaryBurst(true);
+    benchCase(out, format, "parser.corrupted", benchParseCorpus);
+    benchCase(out, format, "legacy.corrupted", benchLegacyFrames);
+    buildJSONBurst();
+    benchCase(out, format, "parser.json_burst", benchParseCorpus);
+    benchCase(out, format, "legacy.json_burst", benchLegacyJSON);
+
+    buildSequenceStream();
+    benchCase(out, format, "dedup.sequence_stream", benchDedupStream);
+
+    // A tabela só existe durante o bench (~16 KB)
+    benchTable = new (std::nothrow) DeviceTable();
+    if (benchTable != nullptr) {
+        benchTableSequence = 0;
+        benchTableRecord();
+        benchCase(out, format, "device_table.record", benchTableRecord);
+    } else {
+        benchSkip(out, format, "device_table.record", "heap");
+    }
+    delete benchTable;
+    benchTable = nullptr;
+
+    // A outbox grava arquivos de verdade: só roda com um diretório de teste
+    benchOutbox = outboxPath != nullptr ? new (std::nothrow) Outbox() : nullptr;
+    if (benchOutbox != nullptr && benchOutbox->begin(outboxPath, 0)) {
+        benchCase(out, format, "outbox.append_peek_ack", benchOutboxRoundTrip);
+    } else {
+        benchSkip(out, format, "outbox.append_peek_ack", outboxPath == nullptr ? "no_path" : "mount");
+    }
+    delete benchOutbox;
+    benchOutbox = nullptr;
+
+    for (size_t i = 0; i < BENCH_BATCH_SIZE; i++) {
+        ReadingFrame reading = benchReading;
+        reading.device_addr = (uint16_t)(i % 5 + 1);
+        reading.heart_rate = (uint8_t)(65 + i);
+        benchBatch[i] = toReceivedData(reading);
+    }
+    benchCase(out, format, "uplink.json_reading", benchReadingJSON);
+    BenchResult json = benchCase(out, format, "uplink.json_batch", benchBatchJSON);
+    BenchResult cbor = benchCase(out, format, "uplink.cbor_batch", benchBatchCBOR);
+    if (format == BENCH_FORMAT_TEXT && json.bytes > 0) {
+        // O mesmo lote nos dois formatos
+        out.printf("# bench compare readings=%u json_bytes=%u json_ns=%lu cbor_bytes=%u cbor_ns=%lu size_pct=%u\n",
+                   (unsigned)BENCH_BATCH_SIZE, (unsigned)json.bytes, json.nsOp, (unsigned)cbor.bytes, cbor.nsOp,
+                   (unsigned)(cbor.bytes * 100 / json.bytes));
+    }
+
+    // O compressor só existe durante o bench (~6 KB)
+    benchJSON = createBatchJSON(benchBatch, BENCH_BATCH_SIZE);
+    benchCompressor = new (std::nothrow) GzipCompressor();
+    benchCompressed = new (std::nothrow) uint8_t[BENCH_COMPRESSED_SIZE];
+    if (benchCompressor != nullptr && benchCompressed != nullptr) {
+        benchGzipCase(out, format, "uplink.gzip_json_batch");
+        buildVariedBatch();
+        benchJSON = createBatchJSON(benchBatch, BENCH_BATCH_SIZE);
+        benchGzipCase(out, format, "uplink.gzip_json_varied");
+    } else {
+        benchSkip(out, format, "uplink.gzip_json_batch", "heap");
+        benchSkip(out, format, "uplink.gzip_json_varied", "heap");
+    }
+    delete benchCompressor;
+    delete[] benchCompressed;
+    benchCompressor = nullptr;
+    benchCompressed = nullptr;
+    benchJSON = String();
+
+    if (format == BENCH_FORMAT_TEXT) {
+        out.printf("# bench done frames=%lu\n", (unsigned long)benchFrames);
+    }
+}
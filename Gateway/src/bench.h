@@ -0,0 +1,46 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <Arduino.h>
+
+// Micro-benchmarks dos caminhos quentes (codec de frames, parser, dedup,
+// tabela de dispositivos, outbox, serialização JSON/CBOR e gzip). No ESP32
+// rodam pelo comando "bench" da Serial; no host, pelo ambiente "native"
+// (pio run -e native -t exec, ver bench_native.cpp). Cada caso imprime uma
+// linha chave=valor:
+//
+//   bench name=parser.burst_frames iterations=4096 ns_op=41230 allocs_op=0.00 bytes_op=120
+//
+// ou, com BENCH_FORMAT_JSON/BENCH_FORMAT_CSV, um objeto JSON por linha ou
+// uma linha CSV (com cabeçalho) com os mesmos campos.
+//
+// Os casos legacy.* passam os corpora do parser pelo caminho de recepção
+// anterior ao FrameParser (String e indexOf), como referência.
+//
+// ns_op é o tempo médio por operação; bytes_op é o tamanho da entrada
+// (parser/decodificação) ou da saída (serialização). allocs_op conta
+// alocações por operação e só é medido com BENCH_TRACK_ALLOCS=1: no ESP32
+// exige "-Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc" nos
+// build_flags, no host conta o operator new; sem isso sai "na". O caso da
+// outbox grava arquivos e só roda quando recebe um diretório. No ESP32 as
+// tarefas de recepção e uplink seguem rodando durante o bench, então
+// compare resultados com o Gateway ocioso.
+
+#ifndef BENCH_TRACK_ALLOCS
+#define BENCH_TRACK_ALLOCS 0
+#endif
+#ifndef BENCH_MIN_US
+#define BENCH_MIN_US 200000         // Duração mínima de cada caso
+#endif
+#define BENCH_MAX_ITERATIONS (1u << 20)
+
+enum BenchFormat {
+    BENCH_FORMAT_TEXT,
+    BENCH_FORMAT_JSON,
+    BENCH_FORMAT_CSV
+};
+
+// outboxPath: diretório descartável para o caso da outbox (nullptr pula)
+void benchRun(Print &out, BenchFormat format = BENCH_FORMAT_TEXT, const char *outboxPath = nullptr);
+
+#endif
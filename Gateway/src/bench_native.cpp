@@ -0,0 +1,56 @@
+#if !defined(ARDUINO) && !defined(PIO_UNIT_TESTING)
+// Ponto de entrada do bench no host (ambiente "native" do platformio.ini):
+//
+//   pio run -e native -t exec                       # linhas chave=valor
+//   .pio/build/native/program --format=json > bench.jsonl
+//   .pio/build/native/program --format=csv > bench.csv
+//
+// O caso da outbox grava num diretório temporário, apagado no final.
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include "bench.h"
+
+static void removeDirectory(const char *path) {
+    DIR *dir = opendir(path);
+    if (dir == nullptr) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        char file[512];
+        snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+        unlink(file);
+    }
+    closedir(dir);
+    rmdir(path);
+}
+
+int main(int argc, char **argv) {
+    BenchFormat format = BENCH_FORMAT_TEXT;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format=json") == 0) {
+            format = BENCH_FORMAT_JSON;
+        } else if (strcmp(argv[i], "--format=csv") == 0) {
+            format = BENCH_FORMAT_CSV;
+        } else if (strcmp(argv[i], "--format=text") != 0) {
+            fprintf(stderr, "uso: %s [--format=text|json|csv]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    char outboxPath[] = "/tmp/gateway_bench_XXXXXX";
+    const char *path = mkdtemp(outboxPath);
+    benchRun(Serial, format, path);
+    Serial.flush();
+    if (path != nullptr) {
+        removeDirectory(path);
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,70 @@
+#include "cbor.h"
+#include <string.h>
+
+#define CBOR_MAJOR_UNSIGNED 0
+#define CBOR_MAJOR_NEGATIVE 1
+#define CBOR_MAJOR_TEXT 3
+#define CBOR_MAJOR_ARRAY 4
+#define CBOR_MAJOR_MAP 5
+
+CborWriter::CborWriter(uint8_t *buffer, size_t capacity)
+    : buffer(buffer), capacity(capacity), length(0), overflow(false) {
+}
+
+void CborWriter::put(uint8_t byte) {
+    if (length >= capacity) {
+        overflow = true;
+        return;
+    }
+    buffer[length++] = byte;
+}
+
+void CborWriter::writeHead(uint8_t majorType, uint32_t value) {
+    // Menor codificação possível do argumento (1, 2, 3 ou 5 bytes)
+    uint8_t major = (uint8_t)(majorType << 5);
+    if (value < 24) {
+        put(major | (uint8_t)value);
+    } else if (value <= 0xFF) {
+        put(major | 24);
+        put((uint8_t)value);
+    } else if (value <= 0xFFFF) {
+        put(major | 25);
+        put((uint8_t)(value >> 8));
+        put((uint8_t)(value & 0xFF));
+    } else {
+        put(major | 26);
+        put((uint8_t)(value >> 24));
+        put((uint8_t)(value >> 16));
+        put((uint8_t)(value >> 8));
+        put((uint8_t)(value & 0xFF));
+    }
+}
+
+void CborWriter::writeUnsigned(uint32_t value) {
+    writeHead(CBOR_MAJOR_UNSIGNED, value);
+}
+
+void CborWriter::writeSigned(int32_t value) {
+    if (value >= 0) {
+        writeHead(CBOR_MAJOR_UNSIGNED, (uint32_t)value);
+    } else {
+        // Negativos são codificados como -1 - n
+        writeHead(CBOR_MAJOR_NEGATIVE, (uint32_t)(-1 - value));
+    }
+}
+
+void CborWriter::writeArray(size_t count) {
+    writeHead(CBOR_MAJOR_ARRAY, (uint32_t)count);
+}
+
+void CborWriter::writeMap(size_t count) {
+    writeHead(CBOR_MAJOR_MAP, (uint32_t)count);
+}
+
+void CborWriter::writeText(const char *text) {
+    size_t textLength = strlen(text);
+    writeHead(CBOR_MAJOR_TEXT, (uint32_t)textLength);
+    for (size_t i = 0; i < textLength; i++) {
+        put((uint8_t)text[i]);
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef CBOR_H
+#define CBOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Escritor CBOR (RFC 8949) mínimo sobre um buffer fixo, sem alocação.
+// Cobre só o que o uplink usa: inteiros, textos UTF-8, arrays e mapas de
+// tamanho conhecido. Se o buffer acabar, ok() passa a ser false e o resto é ignorado.
+class CborWriter {
+private:
+    uint8_t *buffer;
+    size_t capacity;
+    size_t length;
+    bool overflow;
+
+public:
+    CborWriter(uint8_t *buffer, size_t capacity);
+
+    void writeUnsigned(uint32_t value);
+    void writeSigned(int32_t value);
+    void writeArray(size_t count);
+    void writeMap(size_t count);
+    void writeText(const char *text);
+
+    size_t size() const { return length; }
+    bool ok() const { return !overflow; }
+
+private:
+    void writeHead(uint8_t majorType, uint32_t value);
+    void put(uint8_t byte);
+};
+
+#endif
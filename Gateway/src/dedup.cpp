@@ -0,0 +1,44 @@
+#include "dedup.h"
+
+bool sequenceAccept(SequenceWindow &entry, uint16_t sequence) {
+    if (!entry.started) {
+        entry.started = true;
+        entry.highest = sequence;
+        entry.window = 1;
+        entry.accepted++;
+        return true;
+    }
+
+    int16_t diff = (int16_t)(uint16_t)(sequence - entry.highest);
+
+    if (diff > 0) {
+        // Sequência nova: desliza a janela e conta as puladas
+        entry.window = diff < DEDUP_WINDOW ? (entry.window << diff) | 1 : 1;
+        entry.gaps += diff - 1;
+        entry.highest = sequence;
+        entry.accepted++;
+        return true;
+    }
+
+    uint16_t offset = (uint16_t)(-diff);
+    if (offset < DEDUP_WINDOW) {
+        uint64_t bit = (uint64_t)1 << offset;
+        if (entry.window & bit) {
+            entry.duplicates++;
+            return false;
+        }
+        // Chegou fora de ordem: preenche uma lacuna
+        entry.window |= bit;
+        if (entry.gaps > 0) entry.gaps--;
+        entry.accepted++;
+        return true;
+    }
+
+    // Atrás da janela não há como saber se é repetida: o transmissor
+    // reiniciou a numeração
+    entry.resyncs++;
+    entry.highest = sequence;
+    entry.window = 1;
+    entry.accepted++;
+    return true;
+}
@@ -0,0 +1,30 @@
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include <stdint.h>
+
+// Janela de sequências de um dispositivo, no estilo da janela anti-replay
+// do IPsec: guarda a maior sequência vista e um bitmap das DEDUP_WINDOW
+// sequências anteriores para descartar retransmissões duplicadas.
+//
+// As sequências são de 16 bits e comparadas com aritmética circular. Um
+// salto para trás de DEDUP_WINDOW ou mais não cabe no bitmap e é tratado
+// como reinício do transmissor (NVS apagado, firmware novo): a janela
+// recomeça nessa sequência em vez de descartar as leituras como duplicadas.
+
+#define DEDUP_WINDOW 64
+
+struct SequenceWindow {
+    uint64_t window;        // Bit i = sequência (highest - i) já vista
+    uint32_t accepted;
+    uint32_t duplicates;    // Repetidas dentro da janela
+    uint32_t gaps;          // Sequências puladas que ainda não chegaram
+    uint32_t resyncs;
+    uint16_t highest;       // Maior sequência aceita
+    bool started;
+};
+
+// true se a sequência é nova (e a registra), false se é duplicata
+bool sequenceAccept(SequenceWindow &window, uint16_t sequence);
+
+#endif
@@ -0,0 +1,115 @@
+#include "device_table.h"
+#include <string.h>
+
+#define DEVICE_TABLE_MASK (DEVICE_TABLE_SIZE - 1)
+
+// Hash multiplicativo (Fibonacci): espalha endereços consecutivos
+static inline size_t deviceHash(uint16_t deviceAddr) {
+    return (size_t)(((uint32_t)deviceAddr * 2654435769u) >> 16) & DEVICE_TABLE_MASK;
+}
+
+// Média móvel exponencial com peso 1/8 em ponto fixo (x16)
+static inline void updateMean(int32_t &mean16, int32_t value, bool first) {
+    int32_t sample16 = value * 16;
+    mean16 = first ? sample16 : mean16 + (sample16 - mean16) / 8;
+}
+
+DeviceTable::DeviceTable() {
+    clear();
+}
+
+void DeviceTable::clear() {
+    memset(slots, 0, sizeof(slots));
+    deviceCount = 0;
+    maxProbe = 0;
+    untracked = 0;
+    full = false;
+}
+
+DeviceState *DeviceTable::find(uint16_t deviceAddr) {
+    // Nenhum inserido está além de maxProbe da sua posição ideal
+    size_t index = deviceHash(deviceAddr);
+    for (size_t probe = 0; probe <= maxProbe; probe++) {
+        DeviceState &slot = slots[(index + probe) & DEVICE_TABLE_MASK];
+        if (!slot.used) {
+            return nullptr;
+        }
+        if (slot.device_addr == deviceAddr) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+DeviceState *DeviceTable::findOrInsert(uint16_t deviceAddr) {
+    // Cheia: só os já conhecidos, com a busca limitada
+    if (full) {
+        return find(deviceAddr);
+    }
+
+    size_t index = deviceHash(deviceAddr);
+    for (size_t probe = 0; probe < DEVICE_TABLE_SIZE; probe++) {
+        DeviceState &slot = slots[(index + probe) & DEVICE_TABLE_MASK];
+        if (slot.used) {
+            if (slot.device_addr == deviceAddr) {
+                return &slot;
+            }
+            continue;
+        }
+
+        // Posição livre: a ocupação abaixo do limite garante que exista
+        slot.used = true;
+        slot.device_addr = deviceAddr;
+        deviceCount++;
+        full = deviceCount >= DEVICE_TABLE_MAX_DEVICES;
+        if (probe > maxProbe) {
+            maxProbe = probe;
+        }
+        return &slot;
+    }
+    return nullptr;
+}
+
+bool DeviceTable::record(const ReadingFrame &reading, bool hasSequence, uint32_t nowMs) {
+    DeviceState *device = findOrInsert(reading.device_addr);
+    if (device == nullptr) {
+        untracked++;
+        return true;
+    }
+
+    if (hasSequence && !sequenceAccept(device->sequence, reading.sequence)) {
+        return false;
+    }
+
+    bool first = device->readings == 0;
+    if (!first) {
+        uint32_t interval = nowMs - device->lastSeenMs;
+        device->meanIntervalMs = device->meanIntervalMs == 0 ? interval
+                               : device->meanIntervalMs - device->meanIntervalMs / 8 + interval / 8;
+    }
+    updateMean(device->meanHeartRate16, reading.heart_rate, first);
+    updateMean(device->meanOxygen16, reading.oxygen_level, first);
+    updateMean(device->meanTemperature16, reading.temperature_centi, first);
+    device->lastSeenMs = nowMs;
+    device->readings++;
+    return true;
+}
+
+DeviceTableSummary DeviceTable::summarize() const {
+    DeviceTableSummary summary = { deviceCount, 0, 0, untracked };
+    for (size_t i = 0; i < DEVICE_TABLE_SIZE; i++) {
+        if (slots[i].used) {
+            summary.duplicates += slots[i].sequence.duplicates;
+            summary.gaps += slots[i].sequence.gaps;
+        }
+    }
+    return summary;
+}
+
+uint8_t deviceLinkQuality(const DeviceState &device) {
+    uint32_t expected = device.sequence.accepted + device.sequence.gaps;
+    if (expected == 0) {
+        return 100;
+    }
+    return (uint8_t)((uint64_t)device.sequence.accepted * 100 / expected);
+}
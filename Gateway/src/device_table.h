@@ -0,0 +1,82 @@
+#ifndef DEVICE_TABLE_H
+#define DEVICE_TABLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "frame.h"
+#include "dedup.h"
+
+// Tabela de transmissores do Gateway, indexada pelo endereço LoRa de 16 bits.
+//
+// Endereçamento aberto com sondagem linear numa tabela de tamanho fixo
+// (potência de 2), sem alocação: a busca é O(1) em média enquanto a
+// ocupação fica abaixo de 7/8. Dispositivos nunca são removidos; quando a
+// tabela enche, as leituras de dispositivos novos passam sem filtro de
+// duplicatas e são contadas em untrackedCount().
+//
+// A busca para depois da maior sondagem já usada numa inserção, então um
+// endereço desconhecido com a tabela cheia custa no máximo isso, e não uma
+// volta inteira na tabela.
+
+#ifndef DEVICE_TABLE_SIZE
+#define DEVICE_TABLE_SIZE 256       // Posições (potência de 2), 64 bytes cada
+#endif
+// RAM da tabela = DEVICE_TABLE_SIZE x 64 bytes: 256 = 16 KB (224
+// transmissores), 1024 = 64 KB (896), 2048 = 128 KB (1792)
+#define DEVICE_TABLE_MAX_DEVICES (DEVICE_TABLE_SIZE - DEVICE_TABLE_SIZE / 8)
+
+static_assert((DEVICE_TABLE_SIZE & (DEVICE_TABLE_SIZE - 1)) == 0, "DEVICE_TABLE_SIZE deve ser potência de 2");
+static_assert(DEVICE_TABLE_SIZE <= 65536, "DEVICE_TABLE_SIZE maior que o espaço de endereços");
+
+struct DeviceState {
+    SequenceWindow sequence;    // Duplicatas e lacunas de sequência
+    uint32_t readings;          // Leituras aceitas (inclusive JSON legado)
+    uint32_t lastSeenMs;
+    uint32_t meanIntervalMs;    // Média móvel do intervalo entre leituras
+    // Médias móveis (peso 1/8) das leituras, em 1/16 da unidade
+    int32_t meanHeartRate16;
+    int32_t meanOxygen16;
+    int32_t meanTemperature16;  // Em 0,01 °C x 16
+    uint16_t device_addr;
+    bool used;
+};
+
+// Totais da tabela para o log de envio
+struct DeviceTableSummary {
+    size_t devices;
+    uint32_t duplicates;
+    uint32_t gaps;
+    uint32_t untracked;
+};
+
+class DeviceTable {
+private:
+    DeviceState slots[DEVICE_TABLE_SIZE];
+    size_t deviceCount;
+    size_t maxProbe;            // Maior distância da posição ideal entre os inseridos
+    uint32_t untracked;
+    bool full;                  // deviceCount chegou a DEVICE_TABLE_MAX_DEVICES
+
+public:
+    DeviceTable();
+    void clear();
+
+    // Registra uma leitura; false se for duplicata e deve ser descartada
+    bool record(const ReadingFrame &reading, bool hasSequence, uint32_t nowMs);
+
+    DeviceState *find(uint16_t deviceAddr);
+    DeviceState *findOrInsert(uint16_t deviceAddr);
+
+    size_t size() const { return deviceCount; }
+    static size_t capacity() { return DEVICE_TABLE_SIZE; }
+    bool isFull() const { return full; }
+    size_t longestProbe() const { return maxProbe; }
+    const DeviceState &slot(size_t index) const { return slots[index]; }
+    uint32_t untrackedCount() const { return untracked; }
+    DeviceTableSummary summarize() const;
+};
+
+// Qualidade do enlace em %: leituras recebidas sobre as esperadas pela sequência
+uint8_t deviceLinkQuality(const DeviceState &device);
+
+#endif
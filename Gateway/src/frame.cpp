@@ -0,0 +1,332 @@
+#include "frame.h"
+
+uint16_t frameCRC16(const uint8_t *data, size_t length) {
+    // CRC-16/CCITT-FALSE (polinômio 0x1021, valor inicial 0xFFFF)
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+uint8_t frameClampU8(int value) {
+    if (value < 0) return 0;
+    if (value > 255) return 255;
+    return (uint8_t)value;
+}
+
+int16_t frameTemperatureToCenti(float celsius) {
+    float scaled = celsius * 100.0f;
+    if (scaled > 32767.0f) return 32767;
+    if (scaled < -32768.0f) return -32768;
+    return (int16_t)(scaled >= 0 ? scaled + 0.5f : scaled - 0.5f);
+}
+
+float frameTemperatureFromCenti(int16_t centi) {
+    return centi / 100.0f;
+}
+
+static void putU16(uint8_t *out, uint16_t value) {
+    out[0] = (uint8_t)(value >> 8);
+    out[1] = (uint8_t)(value & 0xFF);
+}
+
+static uint16_t getU16(const uint8_t *in) {
+    return (uint16_t)((in[0] << 8) | in[1]);
+}
+
+size_t frameTotalSize(const uint8_t *data, size_t length) {
+    if (length < 2 || (data[0] >> 4) != FRAME_VERSION || data[1] > FRAME_MAX_PAYLOAD) {
+        return 0;
+    }
+    return FRAME_HEADER_SIZE + data[1] + FRAME_CRC_SIZE;
+}
+
+size_t encodeFrame(const FrameHeader &header, const uint8_t *payload, uint8_t *out, size_t capacity) {
+    size_t total = FRAME_HEADER_SIZE + header.payload_length + FRAME_CRC_SIZE;
+    if (header.payload_length > FRAME_MAX_PAYLOAD || capacity < total) {
+        return 0;
+    }
+
+    out[0] = (uint8_t)((FRAME_VERSION << 4) | (header.type & 0x0F));
+    out[1] = header.payload_length;
+    putU16(out + 2, header.device_addr);
+    putU16(out + 4, header.sequence);
+    for (uint8_t i = 0; i < header.payload_length; i++) {
+        out[FRAME_HEADER_SIZE + i] = payload[i];
+    }
+    putU16(out + total - FRAME_CRC_SIZE, frameCRC16(out, total - FRAME_CRC_SIZE));
+    return total;
+}
+
+FrameStatus decodeFrame(const uint8_t *data, size_t length, FrameHeader &header, const uint8_t *&payload) {
+    if (length < FRAME_HEADER_SIZE + FRAME_CRC_SIZE) {
+        return FRAME_TRUNCATED;
+    }
+    if ((data[0] >> 4) != FRAME_VERSION) {
+        return FRAME_BAD_VERSION;
+    }
+    if (data[1] > FRAME_MAX_PAYLOAD) {
+        return FRAME_BAD_LENGTH;
+    }
+
+    size_t total = FRAME_HEADER_SIZE + data[1] + FRAME_CRC_SIZE;
+    if (length < total) {
+        return FRAME_TRUNCATED;
+    }
+    if (frameCRC16(data, total - FRAME_CRC_SIZE) != getU16(data + total - FRAME_CRC_SIZE)) {
+        return FRAME_BAD_CRC;
+    }
+
+    header.type = data[0] & 0x0F;
+    header.payload_length = data[1];
+    header.device_addr = getU16(data + 2);
+    header.sequence = getU16(data + 4);
+    payload = data + FRAME_HEADER_SIZE;
+    return FRAME_OK;
+}
+
+size_t encodeReadingFrame(const ReadingFrame &reading, uint8_t *out, size_t capacity) {
+    uint8_t payload[FRAME_READING_PAYLOAD];
+    payload[0] = reading.heart_rate;
+    payload[1] = reading.oxygen_level;
+    putU16(payload + 2, (uint16_t)reading.temperature_centi);
+
+    FrameHeader header;
+    header.type = FRAME_TYPE_READING;
+    header.payload_length = FRAME_READING_PAYLOAD;
+    header.device_addr = reading.device_addr;
+    header.sequence = reading.sequence;
+    return encodeFrame(header, payload, out, capacity);
+}
+
+FrameStatus decodeReadingPayload(const FrameHeader &header, const uint8_t *payload, ReadingFrame &reading) {
+    if (header.type != FRAME_TYPE_READING) {
+        return FRAME_BAD_TYPE;
+    }
+    if (header.payload_length != FRAME_READING_PAYLOAD) {
+        return FRAME_BAD_LENGTH;
+    }
+
+    reading.device_addr = header.device_addr;
+    reading.sequence = header.sequence;
+    reading.heart_rate = payload[0];
+    reading.oxygen_level = payload[1];
+    reading.temperature_centi = (int16_t)getU16(payload + 2);
+    return FRAME_OK;
+}
+
+static bool fitsDelta(int delta) {
+    return delta >= -128 && delta <= 127;
+}
+
+size_t encodeBurstPayload(const ReadingFrame *readings, size_t count, uint8_t *out, size_t capacity, size_t &encoded) {
+    encoded = 0;
+    if (count == 0 || capacity < FRAME_BURST_BASE_SIZE) {
+        return 0;
+    }
+
+    uint8_t *payload = out;
+    const ReadingFrame &base = readings[0];
+    payload[1] = base.heart_rate;
+    payload[2] = base.oxygen_level;
+    putU16(payload + 3, (uint16_t)base.temperature_centi);
+    size_t length = FRAME_BURST_BASE_SIZE;
+    size_t included = 1;
+
+    // Para no primeiro delta fora de int8, na quebra de sequência, no fim
+    // do espaço ou no limite do contador de 8 bits
+    while (included < count && included < 255 && length + FRAME_BURST_DELTA_SIZE <= capacity) {
+        const ReadingFrame &previous = readings[included - 1];
+        const ReadingFrame &reading = readings[included];
+        int heartDelta = reading.heart_rate - previous.heart_rate;
+        int oxygenDelta = reading.oxygen_level - previous.oxygen_level;
+        int temperatureDelta = reading.temperature_centi - previous.temperature_centi;
+        if (reading.device_addr != base.device_addr || reading.sequence != (uint16_t)(base.sequence + included) ||
+            !fitsDelta(heartDelta) || !fitsDelta(oxygenDelta) || !fitsDelta(temperatureDelta)) {
+            break;
+        }
+        payload[length++] = (uint8_t)(int8_t)heartDelta;
+        payload[length++] = (uint8_t)(int8_t)oxygenDelta;
+        payload[length++] = (uint8_t)(int8_t)temperatureDelta;
+        included++;
+    }
+    payload[0] = (uint8_t)included;
+    encoded = included;
+    return length;
+}
+
+size_t encodeBurstFrame(const ReadingFrame *readings, size_t count, uint8_t *out, size_t capacity, size_t &encoded) {
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    size_t length = encodeBurstPayload(readings, count, payload, sizeof(payload), encoded);
+    if (length == 0) {
+        return 0;
+    }
+
+    FrameHeader header;
+    header.type = FRAME_TYPE_BURST;
+    header.payload_length = (uint8_t)length;
+    header.device_addr = readings[0].device_addr;
+    header.sequence = readings[0].sequence;
+    size_t written = encodeFrame(header, payload, out, capacity);
+    if (written == 0) {
+        encoded = 0;
+    }
+    return written;
+}
+
+FrameStatus decodeBurstPayload(const FrameHeader &header, const uint8_t *payload, ReadingFrame *readings,
+                               size_t capacity, size_t &count) {
+    count = 0;
+    if (header.type != FRAME_TYPE_BURST) {
+        return FRAME_BAD_TYPE;
+    }
+    return decodeBurstReadings(header.device_addr, header.sequence, payload, header.payload_length, readings,
+                               capacity, count);
+}
+
+FrameStatus decodeBurstReadings(uint16_t deviceAddr, uint16_t sequence, const uint8_t *payload, size_t length,
+                                ReadingFrame *readings, size_t capacity, size_t &count) {
+    count = 0;
+    if (length < FRAME_BURST_BASE_SIZE) {
+        return FRAME_BAD_LENGTH;
+    }
+    size_t readingCount = payload[0];
+    if (readingCount == 0 || readingCount > capacity ||
+        length != FRAME_BURST_BASE_SIZE + (readingCount - 1) * FRAME_BURST_DELTA_SIZE) {
+        return FRAME_BAD_LENGTH;
+    }
+
+    ReadingFrame reading;
+    reading.device_addr = deviceAddr;
+    reading.sequence = sequence;
+    reading.heart_rate = payload[1];
+    reading.oxygen_level = payload[2];
+    reading.temperature_centi = (int16_t)getU16(payload + 3);
+    readings[0] = reading;
+
+    const uint8_t *delta = payload + FRAME_BURST_BASE_SIZE;
+    for (size_t i = 1; i < readingCount; i++, delta += FRAME_BURST_DELTA_SIZE) {
+        reading.sequence++;
+        reading.heart_rate = (uint8_t)(reading.heart_rate + (int8_t)delta[0]);
+        reading.oxygen_level = (uint8_t)(reading.oxygen_level + (int8_t)delta[1]);
+        reading.temperature_centi = (int16_t)(reading.temperature_centi + (int8_t)delta[2]);
+        readings[i] = reading;
+    }
+    count = readingCount;
+    return FRAME_OK;
+}
+
+size_t encodeFragmentFrame(uint16_t deviceAddr, uint16_t sequence, const FragmentHeader &fragment,
+                           const uint8_t *data, size_t length, uint8_t *out, size_t capacity) {
+    if (length == 0 || length > FRAME_FRAGMENT_DATA_MAX || fragment.count == 0 ||
+        fragment.count > FRAME_FRAGMENT_MAX_COUNT || fragment.index >= fragment.count) {
+        return 0;
+    }
+
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    payload[0] = fragment.message_id;
+    payload[1] = fragment.message_type;
+    payload[2] = (uint8_t)((fragment.index << 4) | (fragment.count - 1));
+    for (size_t i = 0; i < length; i++) {
+        payload[FRAME_FRAGMENT_HEADER_SIZE + i] = data[i];
+    }
+
+    FrameHeader header;
+    header.type = FRAME_TYPE_FRAGMENT;
+    header.payload_length = (uint8_t)(FRAME_FRAGMENT_HEADER_SIZE + length);
+    header.device_addr = deviceAddr;
+    header.sequence = sequence;
+    return encodeFrame(header, payload, out, capacity);
+}
+
+FrameStatus decodeFragmentPayload(const FrameHeader &header, const uint8_t *payload, FragmentHeader &fragment,
+                                  const uint8_t *&data, size_t &length) {
+    if (header.type != FRAME_TYPE_FRAGMENT) {
+        return FRAME_BAD_TYPE;
+    }
+    if (header.payload_length <= FRAME_FRAGMENT_HEADER_SIZE) {
+        return FRAME_BAD_LENGTH;
+    }
+
+    fragment.message_id = payload[0];
+    fragment.message_type = payload[1];
+    fragment.index = payload[2] >> 4;
+    fragment.count = (uint8_t)((payload[2] & 0x0F) + 1);
+    data = payload + FRAME_FRAGMENT_HEADER_SIZE;
+    length = header.payload_length - FRAME_FRAGMENT_HEADER_SIZE;
+
+    // Só o último fragmento pode ser menor, senão o deslocamento não fecha
+    if (fragment.index >= fragment.count ||
+        (fragment.index + 1 < fragment.count && length != FRAME_FRAGMENT_DATA_MAX)) {
+        return FRAME_BAD_LENGTH;
+    }
+    return FRAME_OK;
+}
+
+size_t encodeAckFrame(const AckFrame &ack, uint8_t *out, size_t capacity) {
+    uint8_t payload[FRAME_ACK_PAYLOAD];
+    putU16(payload, (uint16_t)(ack.bitmap >> 16));
+    putU16(payload + 2, (uint16_t)(ack.bitmap & 0xFFFF));
+
+    FrameHeader header;
+    header.type = FRAME_TYPE_ACK;
+    header.payload_length = FRAME_ACK_PAYLOAD;
+    header.device_addr = ack.device_addr;
+    header.sequence = ack.base;
+    return encodeFrame(header, payload, out, capacity);
+}
+
+FrameStatus decodeAckPayload(const FrameHeader &header, const uint8_t *payload, AckFrame &ack) {
+    if (header.type != FRAME_TYPE_ACK) {
+        return FRAME_BAD_TYPE;
+    }
+    if (header.payload_length != FRAME_ACK_PAYLOAD) {
+        return FRAME_BAD_LENGTH;
+    }
+
+    ack.device_addr = header.device_addr;
+    ack.base = header.sequence;
+    ack.bitmap = ((uint32_t)getU16(payload) << 16) | getU16(payload + 2);
+    return FRAME_OK;
+}
+
+bool ackSet(AckFrame &ack, uint16_t sequence) {
+    // Diferença módulo 2^16: a janela continua certa quando a sequência dá a volta
+    uint16_t offset = (uint16_t)(sequence - ack.base);
+    if (offset >= FRAME_ACK_WINDOW) {
+        return false;
+    }
+    ack.bitmap |= (uint32_t)1 << offset;
+    return true;
+}
+
+bool ackHas(const AckFrame &ack, uint16_t sequence) {
+    uint16_t offset = (uint16_t)(sequence - ack.base);
+    return offset < FRAME_ACK_WINDOW && (ack.bitmap & ((uint32_t)1 << offset)) != 0;
+}
+
+FrameStatus decodeReadingFrame(const uint8_t *data, size_t length, ReadingFrame &reading) {
+    FrameHeader header;
+    const uint8_t *payload = nullptr;
+    FrameStatus status = decodeFrame(data, length, header, payload);
+    if (status != FRAME_OK) {
+        return status;
+    }
+    return decodeReadingPayload(header, payload, reading);
+}
+
+const char *frameStatusDescription(FrameStatus status) {
+    switch (status) {
+        case FRAME_OK: return "OK";
+        case FRAME_TRUNCATED: return "Frame incompleto";
+        case FRAME_BAD_VERSION: return "Versao desconhecida";
+        case FRAME_BAD_TYPE: return "Tipo nao suportado";
+        case FRAME_BAD_LENGTH: return "Tamanho invalido";
+        case FRAME_BAD_CRC: return "CRC invalido";
+    }
+    return "Desconhecido";
+}
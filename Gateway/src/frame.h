@@ -0,0 +1,184 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Frame binário de leitura trocado entre Transmitter e Gateway via LoRa.
+// Substitui o JSON compacto ({"id":"TR-001","hr":..}, ~45 bytes) por um
+// layout fixo de 12 bytes, todos os campos multi-byte em big-endian:
+//
+//   [0]      versão (nibble alto) | tipo (nibble baixo)
+//   [1]      tamanho do payload (bytes)
+//   [2..3]   endereço do dispositivo (ADDH << 8 | ADDL)
+//   [4..5]   número de sequência
+//   [6..]    payload (FRAME_TYPE_READING: hr, SpO2, temperatura em 0,01 °C)
+//   [..+2]   CRC-16/CCITT-FALSE sobre header + payload
+//
+// FRAME_TYPE_BURST leva várias leituras consecutivas do mesmo dispositivo
+// num frame só (um preâmbulo, um header e um CRC por rajada). A sequência
+// do header é a da primeira leitura; a leitura i tem sequência base + i.
+//
+//   [0]      número de leituras N
+//   [1..4]   primeira leitura completa (como em FRAME_TYPE_READING)
+//   [5..]    N-1 deltas de 3 bytes em relação à leitura anterior, com
+//            sinal: hr (bpm), SpO2 (%), temperatura (0,01 °C)
+//
+// Uma rajada de 10 leituras ocupa 40 bytes em vez de 10 frames de 12.
+// Quando um delta não cabe em int8 o codificador encerra o frame ali e a
+// próxima leitura abre outro.
+//
+// FRAME_TYPE_FRAGMENT leva um pedaço de uma mensagem maior que o payload
+// de um frame (até FRAME_MESSAGE_MAX_SIZE bytes). A sequência do header é
+// a da mensagem (numa rajada, a da primeira leitura) e se repete em todos
+// os fragmentos; o Gateway remonta a mensagem e a trata como o payload de
+// um frame do tipo indicado.
+//
+//   [0]      id da mensagem (contador do transmissor)
+//   [1]      tipo da mensagem (FRAME_TYPE_*)
+//   [2]      índice do fragmento (nibble alto) | total - 1 (nibble baixo)
+//   [3..]    dados: FRAME_FRAGMENT_DATA_MAX bytes em todos os fragmentos
+//            menos o último, então o deslocamento é índice * esse valor
+//
+// FRAME_TYPE_ACK vai no sentido contrário, do Gateway para o endereço fixo
+// do transmissor, e confirma as leituras recebidas numa janela de
+// FRAME_ACK_WINDOW sequências. O endereço do header é o do transmissor
+// confirmado e a sequência é a base da janela.
+//
+//   [0..3]   bitmap: bit i = leitura com sequência base + i recebida
+//
+// A confirmação é só positiva: bit zerado quer dizer "não ouvi", e o
+// transmissor reenvia apenas essas leituras.
+//
+// O primeiro byte nunca é '{', então o Gateway distingue frames binários
+// do formato JSON legado olhando apenas para ele.
+// IMPORTANTE: manter este arquivo idêntico no Gateway e no Transmitter.
+
+#define FRAME_VERSION 1
+
+#define FRAME_TYPE_READING 0x0
+#define FRAME_TYPE_BURST 0x1
+#define FRAME_TYPE_FRAGMENT 0x2
+#define FRAME_TYPE_ACK 0x3
+
+#define FRAME_HEADER_SIZE 6
+#define FRAME_CRC_SIZE 2
+#define FRAME_MAX_PAYLOAD 48
+#define FRAME_READING_PAYLOAD 4
+#define FRAME_READING_SIZE (FRAME_HEADER_SIZE + FRAME_READING_PAYLOAD + FRAME_CRC_SIZE)
+#define FRAME_MAX_SIZE (FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD + FRAME_CRC_SIZE)
+#define FRAME_BURST_BASE_SIZE (1 + FRAME_READING_PAYLOAD)
+#define FRAME_BURST_DELTA_SIZE 3
+#define FRAME_BURST_MAX_READINGS (1 + (FRAME_MAX_PAYLOAD - FRAME_BURST_BASE_SIZE) / FRAME_BURST_DELTA_SIZE)
+#define FRAME_FRAGMENT_HEADER_SIZE 3
+#define FRAME_FRAGMENT_DATA_MAX (FRAME_MAX_PAYLOAD - FRAME_FRAGMENT_HEADER_SIZE)
+#define FRAME_FRAGMENT_MAX_COUNT 16
+#define FRAME_MESSAGE_MAX_SIZE (FRAME_FRAGMENT_MAX_COUNT * FRAME_FRAGMENT_DATA_MAX)
+#define FRAME_ACK_PAYLOAD 4
+#define FRAME_ACK_WINDOW 32
+#define FRAME_ACK_SIZE (FRAME_HEADER_SIZE + FRAME_ACK_PAYLOAD + FRAME_CRC_SIZE)
+
+// Resultado da decodificação de um frame
+enum FrameStatus {
+    FRAME_OK = 0,
+    FRAME_TRUNCATED,      // Faltam bytes para completar o frame
+    FRAME_BAD_VERSION,    // Versão desconhecida
+    FRAME_BAD_TYPE,       // Tipo não suportado por este decodificador
+    FRAME_BAD_LENGTH,     // Tamanho de payload inválido para o tipo
+    FRAME_BAD_CRC         // CRC não confere
+};
+
+// Header comum a todos os tipos de frame
+struct FrameHeader {
+    uint8_t type;
+    uint8_t payload_length;
+    uint16_t device_addr;       // Endereço LoRa do transmitter
+    uint16_t sequence;          // Sequência do frame
+};
+
+// Campos de um frame FRAME_TYPE_FRAGMENT
+struct FragmentHeader {
+    uint8_t message_id;
+    uint8_t message_type;       // FRAME_TYPE_* da mensagem remontada
+    uint8_t index;              // 0 .. count - 1
+    uint8_t count;              // 1 .. FRAME_FRAGMENT_MAX_COUNT
+};
+
+// Confirmação de um frame FRAME_TYPE_ACK
+struct AckFrame {
+    uint16_t device_addr;       // Transmitter confirmado
+    uint16_t base;              // Sequência do bit 0
+    uint32_t bitmap;            // Bit i = sequência base + i recebida
+};
+
+// Leitura decodificada de um frame FRAME_TYPE_READING
+struct ReadingFrame {
+    uint16_t device_addr;       // Endereço LoRa do transmitter
+    uint16_t sequence;          // Sequência do frame
+    uint8_t heart_rate;         // bpm
+    uint8_t oxygen_level;       // %
+    int16_t temperature_centi;  // Temperatura em 0,01 °C
+};
+
+// Funções de CRC e montagem de endereço
+uint16_t frameCRC16(const uint8_t *data, size_t length);
+inline uint16_t frameAddress(uint8_t addh, uint8_t addl) {
+    return (uint16_t)((addh << 8) | addl);
+}
+
+// Conversões entre valores dos sensores e campos do frame
+uint8_t frameClampU8(int value);
+int16_t frameTemperatureToCenti(float celsius);
+float frameTemperatureFromCenti(int16_t centi);
+
+// Tamanho total do frame cujo header começa em data (0 se versão inválida)
+size_t frameTotalSize(const uint8_t *data, size_t length);
+
+// Codifica header + payload + CRC em out; retorna o número de bytes escritos
+// (0 se não couber ou se o payload exceder FRAME_MAX_PAYLOAD)
+size_t encodeFrame(const FrameHeader &header, const uint8_t *payload, uint8_t *out, size_t capacity);
+
+// Valida versão, tamanho e CRC; em caso de sucesso aponta payload para
+// dentro de data (sem cópia)
+FrameStatus decodeFrame(const uint8_t *data, size_t length, FrameHeader &header, const uint8_t *&payload);
+
+// Codifica uma leitura em out; retorna o número de bytes escritos (0 se não couber)
+size_t encodeReadingFrame(const ReadingFrame &reading, uint8_t *out, size_t capacity);
+
+// Decodifica um frame de leitura; não aloca memória
+FrameStatus decodeReadingFrame(const uint8_t *data, size_t length, ReadingFrame &reading);
+FrameStatus decodeReadingPayload(const FrameHeader &header, const uint8_t *payload, ReadingFrame &reading);
+
+// Codifica em um frame de rajada as primeiras leituras de readings (mesmo
+// dispositivo, sequências consecutivas). Retorna os bytes escritos e, em
+// encoded, quantas leituras couberam (as demais vão no próximo frame)
+size_t encodeBurstFrame(const ReadingFrame *readings, size_t count, uint8_t *out, size_t capacity, size_t &encoded);
+
+// Só o payload da rajada, para mensagens fragmentadas maiores que um frame
+size_t encodeBurstPayload(const ReadingFrame *readings, size_t count, uint8_t *out, size_t capacity, size_t &encoded);
+
+// Decodifica um frame de rajada em até capacity leituras; não aloca memória
+FrameStatus decodeBurstPayload(const FrameHeader &header, const uint8_t *payload, ReadingFrame *readings,
+                               size_t capacity, size_t &count);
+FrameStatus decodeBurstReadings(uint16_t deviceAddr, uint16_t sequence, const uint8_t *payload, size_t length,
+                                ReadingFrame *readings, size_t capacity, size_t &count);
+
+// Codifica um fragmento de length bytes (FRAME_FRAGMENT_DATA_MAX, ou menos no último)
+size_t encodeFragmentFrame(uint16_t deviceAddr, uint16_t sequence, const FragmentHeader &fragment,
+                           const uint8_t *data, size_t length, uint8_t *out, size_t capacity);
+
+// Valida os campos do fragmento e aponta data para dentro do payload (sem cópia)
+FrameStatus decodeFragmentPayload(const FrameHeader &header, const uint8_t *payload, FragmentHeader &fragment,
+                                  const uint8_t *&data, size_t &length);
+
+// Codifica uma confirmação (FRAME_ACK_SIZE bytes)
+size_t encodeAckFrame(const AckFrame &ack, uint8_t *out, size_t capacity);
+FrameStatus decodeAckPayload(const FrameHeader &header, const uint8_t *payload, AckFrame &ack);
+
+// Marca sequence na janela de ack; false se estiver fora dela
+bool ackSet(AckFrame &ack, uint16_t sequence);
+bool ackHas(const AckFrame &ack, uint16_t sequence);
+
+const char *frameStatusDescription(FrameStatus status);
+
+#endif
@@ -0,0 +1,281 @@
+#include "frame_parser.h"
+#include <string.h>
+
+static bool isFrameStart(uint8_t byte) {
+    return (byte >> 4) == FRAME_VERSION;
+}
+
+FrameParser::FrameParser(FrameHandler handler, void *context)
+    : length(0), jsonScanned(0), jsonDepth(0), jsonInString(false),
+      handler(handler), handlerContext(context) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+void FrameParser::reset() {
+    length = 0;
+    jsonScanned = 0;
+    jsonDepth = 0;
+    jsonInString = false;
+}
+
+void FrameParser::feed(const uint8_t *data, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        push(data[i]);
+    }
+}
+
+void FrameParser::flush() {
+    // Linha ociosa: o que sobrou no buffer não será completado. Descarta
+    // byte a byte reprocessando o restante, para aproveitar frames completos
+    // que ficaram atrás de um início falso.
+    while (length > 0) {
+        discard();
+        process();
+    }
+}
+
+void FrameParser::push(uint8_t byte) {
+    if (length > 0 && buffer[0] == '{') {
+        if (isFrameStart(byte)) {
+            // Frame binário no meio de um JSON: o JSON foi truncado
+            stats.jsonErrors++;
+            stats.discardedBytes += length;
+            reset();
+        } else if (byte < 32 || byte > 126) {
+            // Caracteres de controle não fazem parte do JSON compacto
+            stats.discardedBytes++;
+            return;
+        }
+    }
+
+    buffer[length++] = byte;
+    process();
+}
+
+void FrameParser::process() {
+    // Cada iteração consome um frame completo, descarta um byte ou
+    // para esperando mais dados
+    while (length > 0) {
+        bool progressed;
+        if (isFrameStart(buffer[0])) {
+            progressed = processBinary();
+        } else if (buffer[0] == '{') {
+            progressed = processJSON();
+        } else {
+            stats.discardedBytes++;
+            consume(1);
+            progressed = true;
+        }
+
+        if (!progressed) {
+            return;
+        }
+    }
+}
+
+bool FrameParser::processBinary() {
+    if (length < 2) {
+        return false;
+    }
+
+    size_t total = frameTotalSize(buffer, length);
+    if (total == 0) {
+        discard();
+        return true;
+    }
+    if (length < total) {
+        return false;
+    }
+
+    ParsedFrame frame;
+    FrameStatus status = decodeFrame(buffer, total, frame.header, frame.payload);
+    if (status != FRAME_OK) {
+        if (status == FRAME_BAD_CRC) {
+            stats.crcErrors++;
+        }
+        discard();
+        return true;
+    }
+
+    frame.legacy = false;
+    stats.frames++;
+    handler(frame, handlerContext);
+    consume(total);
+    return true;
+}
+
+bool FrameParser::processJSON() {
+    // Continua a varredura de onde parou (cada byte é visto uma vez)
+    while (jsonScanned < length) {
+        char c = (char)buffer[jsonScanned++];
+        if (jsonInString) {
+            if (c == '"') jsonInString = false;
+        } else if (c == '"') {
+            jsonInString = true;
+        } else if (c == '{') {
+            jsonDepth++;
+        } else if (c == '}') {
+            jsonDepth--;
+            if (jsonDepth == 0) {
+                break;
+            }
+        }
+    }
+
+    if (jsonDepth != 0) {
+        if (length >= PARSER_JSON_MAX_SIZE) {
+            stats.jsonErrors++;
+            discard();
+            return true;
+        }
+        return false;
+    }
+
+    size_t jsonLength = jsonScanned;
+    ReadingFrame reading;
+    if (parseLegacyJSON(buffer, jsonLength, reading)) {
+        legacyPayload[0] = reading.heart_rate;
+        legacyPayload[1] = reading.oxygen_level;
+        legacyPayload[2] = (uint8_t)((uint16_t)reading.temperature_centi >> 8);
+        legacyPayload[3] = (uint8_t)(reading.temperature_centi & 0xFF);
+
+        ParsedFrame frame;
+        frame.header.type = FRAME_TYPE_READING;
+        frame.header.payload_length = FRAME_READING_PAYLOAD;
+        frame.header.device_addr = reading.device_addr;
+        frame.header.sequence = 0;
+        frame.payload = legacyPayload;
+        frame.legacy = true;
+
+        stats.jsonMessages++;
+        handler(frame, handlerContext);
+        consume(jsonLength);
+    } else {
+        stats.jsonErrors++;
+        stats.discardedBytes += jsonLength;
+        consume(jsonLength);
+    }
+    return true;
+}
+
+void FrameParser::consume(size_t count) {
+    if (count >= length) {
+        length = 0;
+    } else {
+        memmove(buffer, buffer + count, length - count);
+        length -= count;
+    }
+    jsonScanned = 0;
+    jsonDepth = 0;
+    jsonInString = false;
+}
+
+void FrameParser::discard() {
+    // Descarta apenas o primeiro byte para tentar ressincronizar no seguinte
+    stats.discardedBytes++;
+    consume(1);
+}
+
+// Lê um inteiro (com sinal opcional) e, se houver, até duas casas decimais.
+// O resultado é multiplicado por 100 (centésimos).
+static bool parseCenti(const uint8_t *text, size_t textLength, size_t &pos, int32_t &centi) {
+    bool negative = false;
+    if (pos < textLength && text[pos] == '-') {
+        negative = true;
+        pos++;
+    }
+
+    size_t start = pos;
+    int32_t integer = 0;
+    while (pos < textLength && text[pos] >= '0' && text[pos] <= '9') {
+        if (integer > 100000) return false;
+        integer = integer * 10 + (text[pos++] - '0');
+    }
+    if (pos == start) {
+        return false;
+    }
+
+    int32_t fraction = 0;
+    if (pos < textLength && text[pos] == '.') {
+        pos++;
+        int digits = 0;
+        while (pos < textLength && text[pos] >= '0' && text[pos] <= '9') {
+            if (digits < 2) {
+                fraction = fraction * 10 + (text[pos] - '0');
+            } else if (digits == 2 && text[pos] >= '5') {
+                fraction++;   // Arredonda a terceira casa
+            }
+            digits++;
+            pos++;
+        }
+        if (digits == 1) {
+            fraction *= 10;
+        }
+    }
+
+    centi = integer * 100 + fraction;
+    if (negative) centi = -centi;
+    return true;
+}
+
+bool FrameParser::parseLegacyJSON(const uint8_t *json, size_t jsonLength, ReadingFrame &reading) {
+    // Parser mínimo para o objeto plano {"id":"TR-001","hr":72,"ox":97,"temp":36.5}
+    bool hasId = false, hasHr = false, hasOx = false, hasTemp = false;
+    size_t pos = 1;
+
+    while (pos < jsonLength) {
+        // Procura a próxima chave
+        while (pos < jsonLength && json[pos] != '"' && json[pos] != '}') pos++;
+        if (pos >= jsonLength || json[pos] == '}') break;
+
+        size_t keyStart = ++pos;
+        while (pos < jsonLength && json[pos] != '"') pos++;
+        size_t keyLength = pos - keyStart;
+        pos++;
+
+        while (pos < jsonLength && (json[pos] == ' ' || json[pos] == ':')) pos++;
+        if (pos >= jsonLength) return false;
+
+        const char *key = (const char *)json + keyStart;
+        if (keyLength == 2 && memcmp(key, "id", 2) == 0) {
+            if (json[pos] != '"') return false;
+            pos++;
+
+            // Usa os dígitos finais do ID ("TR-001" -> 1) como endereço
+            uint32_t number = 0;
+            bool hasDigits = false;
+            while (pos < jsonLength && json[pos] != '"') {
+                if (json[pos] >= '0' && json[pos] <= '9') {
+                    number = number * 10 + (json[pos] - '0');
+                    hasDigits = true;
+                } else {
+                    number = 0;
+                    hasDigits = false;
+                }
+                pos++;
+            }
+            pos++;
+            if (!hasDigits || number > 0xFFFF) return false;
+            reading.device_addr = (uint16_t)number;
+            hasId = true;
+        } else {
+            int32_t centi;
+            if (!parseCenti(json, jsonLength, pos, centi)) return false;
+
+            if (keyLength == 2 && memcmp(key, "hr", 2) == 0) {
+                reading.heart_rate = frameClampU8(centi / 100);
+                hasHr = true;
+            } else if (keyLength == 2 && memcmp(key, "ox", 2) == 0) {
+                reading.oxygen_level = frameClampU8(centi / 100);
+                hasOx = true;
+            } else if (keyLength == 4 && memcmp(key, "temp", 4) == 0) {
+                if (centi < -32768 || centi > 32767) return false;
+                reading.temperature_centi = (int16_t)centi;
+                hasTemp = true;
+            }
+        }
+    }
+
+    reading.sequence = 0;
+    return hasId && hasHr && hasOx && hasTemp;
+}
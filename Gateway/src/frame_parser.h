@@ -0,0 +1,68 @@
+#ifndef FRAME_PARSER_H
+#define FRAME_PARSER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "frame.h"
+
+// Tamanho máximo aceito para uma mensagem JSON legada
+// ({"id":"TR-001","hr":72,"ox":97,"temp":36.5} tem ~45 bytes)
+#define PARSER_JSON_MAX_SIZE 64
+#define PARSER_BUFFER_SIZE (FRAME_MAX_SIZE > PARSER_JSON_MAX_SIZE ? FRAME_MAX_SIZE : PARSER_JSON_MAX_SIZE)
+
+// Frame completo entregue pelo parser
+struct ParsedFrame {
+    FrameHeader header;
+    const uint8_t *payload;   // Válido apenas durante o callback
+    bool legacy;              // Convertido do JSON legado (sem sequência real)
+};
+
+typedef void (*FrameHandler)(const ParsedFrame &frame, void *context);
+
+// Contadores do parser
+struct ParserStats {
+    uint32_t frames;          // Frames binários válidos
+    uint32_t jsonMessages;    // Mensagens JSON legadas válidas
+    uint32_t crcErrors;       // Frames binários com CRC inválido
+    uint32_t jsonErrors;      // JSON incompleto ou malformado
+    uint32_t discardedBytes;  // Bytes descartados durante a ressincronização
+};
+
+// Parser incremental de frames LoRa.
+// Recebe bytes um a um (ou em blocos), reconhece frames binários (frame.h)
+// e o JSON legado, lida com pacotes concatenados ("}{") e lixo entre eles,
+// e chama o handler a cada frame completo. Não faz alocação dinâmica: todo
+// o estado fica no buffer fixo de PARSER_BUFFER_SIZE bytes.
+class FrameParser {
+private:
+    uint8_t buffer[PARSER_BUFFER_SIZE];
+    size_t length;
+
+    // Estado incremental da varredura do JSON
+    size_t jsonScanned;
+    int jsonDepth;
+    bool jsonInString;
+
+    uint8_t legacyPayload[FRAME_READING_PAYLOAD];
+    FrameHandler handler;
+    void *handlerContext;
+    ParserStats stats;
+
+public:
+    FrameParser(FrameHandler handler, void *context);
+    void push(uint8_t byte);
+    void feed(const uint8_t *data, size_t count);
+    void flush();
+    void reset();
+    const ParserStats &getStats() const { return stats; }
+
+private:
+    void process();
+    bool processBinary();
+    bool processJSON();
+    void consume(size_t count);
+    void discard();
+    bool parseLegacyJSON(const uint8_t *json, size_t jsonLength, ReadingFrame &reading);
+};
+
+#endif
@@ -0,0 +1,190 @@
+#include "gzip.h"
+#include <string.h>
+
+// Tabelas do deflate (RFC 1951, seção 3.2.5)
+static const uint16_t LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t DISTANCE_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t DISTANCE_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+#define GZIP_MIN_MATCH 3
+#define GZIP_MAX_MATCH 258
+
+uint32_t gzipCRC32(const uint8_t *data, size_t length) {
+    // CRC-32 (polinômio 0xEDB88320) com tabela de 16 entradas
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+static inline uint16_t hash3(const uint8_t *p) {
+    uint32_t value = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    return (uint16_t)((value * 2654435761u) >> (32 - GZIP_HASH_BITS));
+}
+
+GzipCompressor::GzipCompressor()
+    : out(nullptr), outCapacity(0), outLength(0), bitBuffer(0), bitCount(0), overflow(false) {
+}
+
+void GzipCompressor::putByte(uint8_t byte) {
+    if (outLength >= outCapacity) {
+        overflow = true;
+        return;
+    }
+    out[outLength++] = byte;
+}
+
+void GzipCompressor::putBits(uint32_t value, uint8_t count) {
+    bitBuffer |= value << bitCount;
+    bitCount += count;
+    while (bitCount >= 8) {
+        putByte((uint8_t)(bitBuffer & 0xFF));
+        bitBuffer >>= 8;
+        bitCount -= 8;
+    }
+}
+
+void GzipCompressor::flushBits() {
+    if (bitCount > 0) {
+        putByte((uint8_t)(bitBuffer & 0xFF));
+    }
+    bitBuffer = 0;
+    bitCount = 0;
+}
+
+void GzipCompressor::putHuffman(uint16_t code, uint8_t length) {
+    // Códigos de Huffman vão do bit mais significativo para o menos
+    uint16_t reversed = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        reversed = (uint16_t)((reversed << 1) | ((code >> i) & 1));
+    }
+    putBits(reversed, length);
+}
+
+void GzipCompressor::putLiteral(uint16_t symbol) {
+    // Códigos fixos (RFC 1951, seção 3.2.6)
+    if (symbol <= 143) {
+        putHuffman((uint16_t)(0x30 + symbol), 8);
+    } else if (symbol <= 255) {
+        putHuffman((uint16_t)(0x190 + symbol - 144), 9);
+    } else if (symbol <= 279) {
+        putHuffman((uint16_t)(symbol - 256), 7);
+    } else {
+        putHuffman((uint16_t)(0xC0 + symbol - 280), 8);
+    }
+}
+
+void GzipCompressor::putMatch(uint16_t length, uint16_t distance) {
+    uint8_t code = 28;
+    while (LENGTH_BASE[code] > length) code--;
+    putLiteral((uint16_t)(257 + code));
+    putBits(length - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+
+    code = 29;
+    while (DISTANCE_BASE[code] > distance) code--;
+    putHuffman(code, 5);
+    putBits(distance - DISTANCE_BASE[code], DISTANCE_EXTRA[code]);
+}
+
+size_t GzipCompressor::compress(const uint8_t *input, size_t length, uint8_t *output, size_t capacity) {
+    if (length > GZIP_MAX_INPUT) {
+        return 0;
+    }
+
+    out = output;
+    outCapacity = capacity;
+    outLength = 0;
+    bitBuffer = 0;
+    bitCount = 0;
+    overflow = false;
+    memset(head, 0, sizeof(head));
+
+    // Cabeçalho gzip: deflate, sem nome nem data, SO desconhecido
+    static const uint8_t header[10] = { 0x1F, 0x8B, 0x08, 0x00, 0, 0, 0, 0, 0x00, 0xFF };
+    for (size_t i = 0; i < sizeof(header); i++) {
+        putByte(header[i]);
+    }
+
+    // Um único bloco final com Huffman fixo
+    putBits(1, 1);
+    putBits(1, 2);
+
+    size_t pos = 0;
+    while (pos < length && !overflow) {
+        uint16_t bestLength = 0;
+        uint16_t bestDistance = 0;
+
+        if (pos + GZIP_MIN_MATCH <= length) {
+            uint16_t h = hash3(input + pos);
+            uint16_t candidate = head[h];
+            size_t maxLength = length - pos < GZIP_MAX_MATCH ? length - pos : GZIP_MAX_MATCH;
+
+            // Percorre a cadeia de posições anteriores com o mesmo hash
+            for (int chain = 0; chain < GZIP_MAX_CHAIN && candidate != 0; chain++) {
+                size_t start = candidate - 1;
+                size_t distance = pos - start;
+                if (distance > GZIP_WINDOW_SIZE) {
+                    break;
+                }
+                size_t matched = 0;
+                while (matched < maxLength && input[start + matched] == input[pos + matched]) {
+                    matched++;
+                }
+                if (matched > bestLength) {
+                    bestLength = (uint16_t)matched;
+                    bestDistance = (uint16_t)distance;
+                    if (matched == maxLength) break;
+                }
+                uint16_t next = prev[start & (GZIP_WINDOW_SIZE - 1)];
+                if (next == 0 || next >= candidate) break;
+                candidate = next;
+            }
+        }
+
+        size_t advance = bestLength >= GZIP_MIN_MATCH ? bestLength : 1;
+        if (advance > 1) {
+            putMatch(bestLength, bestDistance);
+        } else {
+            putLiteral(input[pos]);
+        }
+
+        // Insere no hash todas as posições consumidas
+        for (size_t i = 0; i < advance; i++, pos++) {
+            if (pos + GZIP_MIN_MATCH <= length) {
+                uint16_t h = hash3(input + pos);
+                prev[pos & (GZIP_WINDOW_SIZE - 1)] = head[h];
+                head[h] = (uint16_t)(pos + 1);
+            }
+        }
+    }
+
+    putLiteral(256);    // Fim do bloco
+    flushBits();
+
+    // Trailer: CRC-32 e tamanho original, little-endian
+    uint32_t crc = gzipCRC32(input, length);
+    for (int i = 0; i < 4; i++) putByte((uint8_t)(crc >> (8 * i)));
+    for (int i = 0; i < 4; i++) putByte((uint8_t)((uint32_t)length >> (8 * i)));
+
+    return overflow ? 0 : outLength;
+}
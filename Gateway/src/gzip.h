@@ -0,0 +1,54 @@
+#ifndef GZIP_H
+#define GZIP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Compressor gzip (RFC 1951/1952) com memória limitada, para corpos de
+// requisição. LZ77 guloso com cadeias de hash dentro de uma janela de
+// GZIP_WINDOW_SIZE bytes e blocos com códigos de Huffman fixos: não
+// precisa montar tabelas dinâmicas e cabe em ~2 x GZIP_WINDOW_SIZE bytes
+// de RAM além dos buffers de entrada e saída.
+
+#ifndef GZIP_WINDOW_SIZE
+#define GZIP_WINDOW_SIZE 2048      // Distância máxima das repetições (potência de 2, <= 32768)
+#endif
+#ifndef GZIP_MAX_CHAIN
+#define GZIP_MAX_CHAIN 8           // Candidatos examinados por posição
+#endif
+#define GZIP_HASH_BITS 10
+#define GZIP_MAX_INPUT 65535
+
+static_assert((GZIP_WINDOW_SIZE & (GZIP_WINDOW_SIZE - 1)) == 0, "GZIP_WINDOW_SIZE deve ser potência de 2");
+static_assert(GZIP_WINDOW_SIZE <= 32768, "Janela deflate limitada a 32 KB");
+
+class GzipCompressor {
+private:
+    uint16_t head[1 << GZIP_HASH_BITS];     // Última posição (+1) de cada hash
+    uint16_t prev[GZIP_WINDOW_SIZE];        // Posição anterior com o mesmo hash
+
+    // Saída de bits (LSB primeiro, como o deflate exige)
+    uint8_t *out;
+    size_t outCapacity;
+    size_t outLength;
+    uint32_t bitBuffer;
+    uint8_t bitCount;
+    bool overflow;
+
+public:
+    GzipCompressor();
+    // Retorna o tamanho do gzip gerado, ou 0 se não couber em capacity
+    size_t compress(const uint8_t *input, size_t length, uint8_t *output, size_t capacity);
+
+private:
+    void putByte(uint8_t byte);
+    void putBits(uint32_t value, uint8_t count);
+    void putHuffman(uint16_t code, uint8_t length);
+    void putLiteral(uint16_t symbol);
+    void putMatch(uint16_t length, uint16_t distance);
+    void flushBits();
+};
+
+uint32_t gzipCRC32(const uint8_t *data, size_t length);
+
+#endif
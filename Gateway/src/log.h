@@ -0,0 +1,96 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+
+// Log com nível definido em tempo de compilação (build flag LOG_LEVEL no
+// platformio.ini). Chamadas acima do nível configurado viram código vazio e
+// nem avaliam os argumentos. As chamadas habilitadas não formatam nada no
+// ponto de chamada: gravam um registro binário (ponteiro do formato +
+// argumentos de 32 bits) num buffer circular em RAM, que uma tarefa de
+// baixa prioridade formata e envia para a Serial depois.
+//
+// Argumentos aceitos: inteiros de até 32 bits, bool, char, float/double e
+// const char* apontando para literais (o texto é lido só na formatação,
+// então nunca passe String::c_str() ou buffers temporários).
+// IMPORTANTE: manter este arquivo idêntico no Gateway e no Transmitter.
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE 64            // Registros no buffer (potência de 2)
+#endif
+#define LOG_MAX_ARGS 4
+#define LOG_DRAIN_INTERVAL_MS 50    // Período da tarefa que esvazia o buffer
+#define LOG_LINE_SIZE 160
+
+struct LogRecord {
+    const char *format;             // Literal em flash, funciona como id do formato
+    uint32_t timestamp;             // millis() no momento do registro
+    uint8_t level;
+    uint8_t argCount;
+    uint32_t args[LOG_MAX_ARGS];
+};
+
+// Conversão de cada argumento para uma palavra de 32 bits
+inline uint32_t logArg(int value) { return (uint32_t)value; }
+inline uint32_t logArg(unsigned int value) { return value; }
+inline uint32_t logArg(long value) { return (uint32_t)value; }
+inline uint32_t logArg(unsigned long value) { return (uint32_t)value; }
+inline uint32_t logArg(const char *value) { return (uint32_t)(uintptr_t)value; }
+inline uint32_t logArg(double value) {
+    float f = (float)value;
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+void logInit(UBaseType_t priority, BaseType_t core);
+void logWrite(uint8_t level, const char *format, const uint32_t *args, uint8_t argCount);
+void logFlush();
+uint32_t logDroppedCount();
+
+template <typename... Args>
+inline void logRecord(uint8_t level, const char *format, Args... args) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "LOG: no maximo 4 argumentos por registro");
+    uint32_t words[sizeof...(Args) + 1] = { logArg(args)... };
+    logWrite(level, format, words, (uint8_t)sizeof...(Args));
+}
+
+// Nível desabilitado: o compilador elimina a chamada, mas ainda verifica
+// os argumentos (e não acusa variáveis usadas apenas no log)
+#define LOG_DISABLED(level, format, ...) do { if (0) logRecord(level, format, ##__VA_ARGS__); } while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(format, ...) logRecord(LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(format, ...) LOG_DISABLED(LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(format, ...) logRecord(LOG_LEVEL_WARN, format, ##__VA_ARGS__)
+#else
+#define LOG_WARN(format, ...) LOG_DISABLED(LOG_LEVEL_WARN, format, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(format, ...) logRecord(LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#else
+#define LOG_INFO(format, ...) LOG_DISABLED(LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(format, ...) logRecord(LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(format, ...) LOG_DISABLED(LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#endif
+
+#endif
@@ -1,470 +1,642 @@
 #include "lora.h"
+#include "log.h"
+#include "metrics.h"
 
-LoRaReceiver::LoRaReceiver() : serialLoRa(2), e32ttl(&serialLoRa, LORA_AUX_PIN, LORA_M0_PIN, LORA_M1_PIN), isInitialized(false) {
-    // Construtor
+#if LORA_RX_MODE == LORA_RX_MODE_EVENT
+// Sinalizado pelo evento de linha ociosa do UART e pela subida do AUX
+static SemaphoreHandle_t rxSignal = nullptr;
+#endif
+
+// Última subida do AUX ainda sem pacote entregue, em µs (0 = nenhuma).
+// Marca o fim do pacote nos dois modos, para lora.rx_latency_us
+static volatile uint32_t auxRiseUs = 0;
+
+static void IRAM_ATTR onAuxRising() {
+    // AUX volta a HIGH quando o E32 termina de entregar o pacote no UART
+    uint32_t now = micros();
+    auxRiseUs = now != 0 ? now : 1;
+#if LORA_RX_MODE == LORA_RX_MODE_EVENT
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    xSemaphoreGiveFromISR(rxSignal, &higherPriorityTaskWoken);
+    if (higherPriorityTaskWoken) {
+        portYIELD_FROM_ISR();
+    }
+#endif
+}
+
+LoRaReceiver::LoRaReceiver() : serialLoRa(2), e32ttl(&serialLoRa, LORA_AUX_PIN, LORA_M0_PIN, LORA_M1_PIN), isInitialized(false),
+    parser(onFrame, this), readingQueue(nullptr), reassembler(onMessage, this), storedReadings(0), storedSeen(0),
+    reportedMessages(0), reportedMessagesLost(0), reportedParseErrors(0), reportedDiscarded(0), uartPeak(0), lastRxTime(0),
+    lastHealthCheck(0), lastConfigCheck(0), auxLowSince(0) {
+    memset(&bootReport, 0, sizeof(bootReport));
+    devicesLock = portMUX_INITIALIZER_UNLOCKED;
 }
 
 bool LoRaReceiver::initLoRa() { 
+    unsigned long bootStart = millis();
+    memset(&bootReport, 0, sizeof(bootReport));
     Serial.println("Iniciando configuração do módulo LoRa E32...");
     
-    // Inicializa Serial para comunicação com E32 (igual ao código funcional)
+    // Inicializa Serial para comunicação com E32 (igual ao código funcional).
+    // O tamanho do buffer só vale se definido antes do begin()
+    serialLoRa.setRxBufferSize(LORA_UART_RX_BUFFER_SIZE);
+    serialLoRa.onReceiveError(onUartError);
     serialLoRa.begin(9600, SERIAL_8N1, LORA_RX_PIN, LORA_TX_PIN);
     Serial.println("Serial LoRa configurado (RX: " + String(LORA_RX_PIN) + ", TX: " + String(LORA_TX_PIN) + ")");
     
-    // Inicializa o módulo E32
+    // Inicializa o módulo E32; ele está pronto quando o AUX sobe
     e32ttl.begin();
+    bool auxReady = waitAuxReady(LORA_AUX_TIMEOUT_MS);
+    if (!auxReady) {
+        Serial.println("⚠️  AUX não subiu em " + String(LORA_AUX_TIMEOUT_MS) + " ms, seguindo mesmo assim");
+    }
+    bootReport.readyMs = millis() - bootStart;
     Serial.println("Módulo E32 inicializado");
     
-    // Aguarda estabilização inicial
-    Serial.println("Aguardando estabilização inicial...");
-    delay(2000);
-    
-    configureLoRaModule();
-
-    // Aguarda estabilização após configuração
-    Serial.println("Aguardando estabilização após configuração...");
-    delay(2000);
-
-    // Imprime configuração atual
-    printConfiguration();
+    Configuration configuration;
+    bool configured = configureLoRaModule(configuration);
+    if (configured) {
+        printConfiguration(configuration);
+    }
     
     // Limpa buffer que pode ter dados residuais
-    Serial.println("Limpando buffer de recepção...");
-    while (e32ttl.available() > 0) {
-        e32ttl.receiveMessage();
-        delay(100);
+    while (serialLoRa.available() > 0) {
+        serialLoRa.read();
     }
+    rxRing.clear();
+    parser.reset();
+    acks.reset();
+    
+    enableRxEvents();
     
+    // Mesmo com falha o UART fica escutando; a supervisão tenta de novo
     isInitialized = true;
-    Serial.println("Módulo LoRa E32 inicializado com sucesso!");
-    Serial.println("Gateway pronto para receber dados do Transmitter TR-001");
+    lastRxTime = millis();
+    lastHealthCheck = lastRxTime;
+    lastConfigCheck = lastRxTime;
+    auxLowSince = 0;
+    bootReport.totalMs = millis() - bootStart;
+    Serial.printf("⏱️  LoRa pronto em %lu ms (módulo %lu ms, leitura %lu ms, gravação %lu ms)\n",
+                  (unsigned long)bootReport.totalMs, (unsigned long)bootReport.readyMs,
+                  (unsigned long)bootReport.readMs, (unsigned long)bootReport.writeMs);
+    if (!auxReady || !configured) {
+        return false;
+    }
+    Serial.println("Gateway pronto para receber dados dos Transmitters");
     
     return true;
 }
 
-void LoRaReceiver::configureLoRaModule()
-{
-    // Configura o módulo
-    e32ttl.begin();
+bool LoRaReceiver::recover() {
+    // Reinicializa só o E32 e o seu UART; a fila, a tabela de transmissores
+    // e o WiFi não são tocados
+    detachInterrupt(digitalPinToInterrupt(LORA_AUX_PIN));
+    isInitialized = false;
+    serialLoRa.end();
+    return initLoRa();
+}
 
-    // Obtém configuração atual
+LoRaHealth LoRaReceiver::checkHealth(uint32_t now) {
+    if (now - lastHealthCheck < LORA_HEALTH_INTERVAL_MS) {
+        return LORA_HEALTH_PENDING;
+    }
+    lastHealthCheck = now;
+    
+    // AUX fica em LOW enquanto o E32 entrega um pacote; bem mais que isso é travamento
+    if (digitalRead(LORA_AUX_PIN) == LOW) {
+        if (auxLowSince == 0) {
+            auxLowSince = now;
+        }
+        return now - auxLowSince >= LORA_AUX_STUCK_MS ? LORA_HEALTH_AUX_STUCK : LORA_HEALTH_PENDING;
+    }
+    auxLowSince = 0;
+    
+    // Com tráfego chegando o módulo está vivo; só no silêncio vale a pena
+    // conferir a configuração (a leitura deixa o rádio surdo por alguns ms)
+    if (now - lastRxTime < LORA_RX_SILENCE_MS || now - lastConfigCheck < LORA_RX_SILENCE_MS) {
+        return LORA_HEALTH_OK;
+    }
+    
+    // Enquanto falhar, confere de novo na próxima verificação
     ResponseStructContainer c = e32ttl.getConfiguration();
-    Configuration configuration = *(Configuration *)c.data;
-    Serial.print("Status da configuração: ");
-    Serial.println(c.status.getResponseDescription());
+    if (c.status.code != 1) {
+        c.close();
+        return LORA_HEALTH_NO_RESPONSE;
+    }
+    Configuration current = *(Configuration *)c.data;
+    c.close();
+    lastConfigCheck = now;
+    
+    Configuration desired = current;
+    applyGatewayProfile(desired);
+    return configurationMatches(current, desired) ? LORA_HEALTH_OK : LORA_HEALTH_CONFIG_CHANGED;
+}
 
-    if (c.status.code == 1)
-    {
-        Serial.println("Configuração atual obtida com sucesso!");
-
-        // Define configurações específicas
-        configuration.ADDL = 0x01; // Endereço baixo do Gateway
-        configuration.ADDH = 0x00; // Endereço alto do Gateway
-        configuration.CHAN = 23;      // Canal 23
-        configuration.OPTION.fixedTransmission = FT_FIXED_TRANSMISSION;
-        configuration.OPTION.ioDriveMode = IO_D_MODE_PUSH_PULLS_PULL_UPS;
-        configuration.OPTION.wirelessWakeupTime = WAKE_UP_250;
-        configuration.OPTION.transmissionPower = POWER_20;
-
-        configuration.SPED.airDataRate = AIR_DATA_RATE_010_24;
-        configuration.SPED.uartBaudRate = UART_BPS_9600;
-        configuration.SPED.uartParity = MODE_00_8N1;
-
-        // Aplica as configurações
-        ResponseStatus rsConfig = e32ttl.setConfiguration(configuration, WRITE_CFG_PWR_DWN_LOSE);
-        Serial.print("Status da aplicação da configuração: ");
-        Serial.println(rsConfig.getResponseDescription());
+const char *loraHealthName(LoRaHealth health) {
+    switch (health) {
+        case LORA_HEALTH_PENDING: return "verificação pendente";
+        case LORA_HEALTH_OK: return "ok";
+        case LORA_HEALTH_AUX_STUCK: return "AUX preso em LOW";
+        case LORA_HEALTH_NO_RESPONSE: return "E32 não responde";
+        case LORA_HEALTH_CONFIG_CHANGED: return "configuração do E32 alterada";
+    }
+    return "?";
+}
 
-        if (rsConfig.code == 1)
-        {
-            Serial.println("Configurações aplicadas com sucesso!");
-        }
-        else
-        {
-            Serial.println("Erro ao aplicar configurações! Tentando novamente...");
-            delay(1000);
-            
-            // Segunda tentativa
-            ResponseStatus rsConfig2 = e32ttl.setConfiguration(configuration, WRITE_CFG_PWR_DWN_LOSE);
-            Serial.print("Status da segunda tentativa: ");
-            Serial.println(rsConfig2.getResponseDescription());
-            
-            if (rsConfig2.code == 1) {
-                Serial.println("Configurações aplicadas na segunda tentativa!");
-            } else {
-                Serial.println("ERRO: Falha nas duas tentativas de configuração!");
-            }
+bool LoRaReceiver::waitAuxReady(unsigned long timeoutMs) {
+    // AUX em LOW: módulo ocupado (auto-teste, troca de modo ou gravação)
+    unsigned long start = millis();
+    while (digitalRead(LORA_AUX_PIN) == LOW) {
+        if (millis() - start >= timeoutMs) {
+            return false;
         }
+        delay(1);
     }
-    else
+    delay(LORA_AUX_SETTLE_MS);
+    return true;
+}
+
+void LoRaReceiver::onUartError(hardwareSerial_error_t error) {
+    // Roda na tarefa de eventos do driver do UART, não na de recepção
+    switch (error) {
+        case UART_FIFO_OVF_ERROR:
+            // A FIFO de 128 bytes encheu antes da ISR esvaziá-la: o driver a descarta
+            metricUartFifoOverflows.add();
+            LOG_WARN("⚠️  UART do LoRa: FIFO transbordou, bytes perdidos");
+            break;
+        case UART_BUFFER_FULL_ERROR:
+            // Buffer do driver cheio: bytes chegando são perdidos até a tarefa ler
+            metricUartBufferFull.add();
+            LOG_WARN("⚠️  UART do LoRa: buffer de %u bytes cheio, bytes perdidos", LORA_UART_RX_BUFFER_SIZE);
+            break;
+        case UART_BREAK_ERROR:
+        case UART_FRAME_ERROR:
+        case UART_PARITY_ERROR:
+            metricUartErrors.add();
+            break;
+        default:
+            break;
+    }
+}
+
+void LoRaReceiver::enableRxEvents() {
+#if LORA_RX_MODE == LORA_RX_MODE_EVENT
+    if (rxSignal == nullptr) {
+        rxSignal = xSemaphoreCreateBinary();
+    }
+    
+    // Evento do driver do UART após LORA_RX_IDLE_SYMBOLS de silêncio na linha
+    serialLoRa.setRxTimeout(LORA_RX_IDLE_SYMBOLS);
+    serialLoRa.onReceive([]() { xSemaphoreGive(rxSignal); }, true);
+    
+    attachInterrupt(digitalPinToInterrupt(LORA_AUX_PIN), onAuxRising, RISING);
+    Serial.println("Recepção por eventos ativa (UART ocioso + AUX no GPIO " + String(LORA_AUX_PIN) + ")");
+#else
+    // O AUX não acorda a tarefa aqui, só marca o fim do pacote para a métrica
+    attachInterrupt(digitalPinToInterrupt(LORA_AUX_PIN), onAuxRising, RISING);
+    Serial.println("Recepção por polling ativa (intervalo de " + String(LORA_POLL_INTERVAL_MS) + " ms)");
+#endif
+}
+
+bool LoRaReceiver::waitForData(unsigned long timeoutMs) {
+    if (serialLoRa.available() > 0) {
+        return true;
+    }
+    
+#if LORA_RX_MODE == LORA_RX_MODE_EVENT
+    // CPU fica livre até o próximo pacote (ou até o timeout)
+    xSemaphoreTake(rxSignal, pdMS_TO_TICKS(timeoutMs));
+#else
+    delay(timeoutMs < LORA_POLL_INTERVAL_MS ? timeoutMs : LORA_POLL_INTERVAL_MS);
+#endif
+    metricLoRaRxWakeups.add();
+    
+    if (serialLoRa.available() > 0) {
+        return true;
+    }
+    // Subida do AUX sem bytes: pacote já entregue antes dela ou transmissão
+    // do próprio Gateway
+    auxRiseUs = 0;
+    return false;
+}
+
+void LoRaReceiver::applyGatewayProfile(Configuration &configuration) {
+    configuration.ADDL = GATEWAY_ADDL;
+    configuration.ADDH = GATEWAY_ADDH;
+    configuration.CHAN = CHANNEL;
+    configuration.OPTION.fixedTransmission = FT_FIXED_TRANSMISSION;
+    configuration.OPTION.ioDriveMode = IO_D_MODE_PUSH_PULLS_PULL_UPS;
+    configuration.OPTION.wirelessWakeupTime = WAKE_UP_250;
+    configuration.OPTION.transmissionPower = POWER_20;
+
+    configuration.SPED.airDataRate = AIR_DATA_RATE_010_24;
+    configuration.SPED.uartBaudRate = UART_BPS_9600;
+    configuration.SPED.uartParity = MODE_00_8N1;
+}
+
+bool LoRaReceiver::configurationMatches(const Configuration &a, const Configuration &b) {
+    // HEAD diz só como a configuração foi gravada; o resto precisa bater
+    return a.ADDH == b.ADDH && a.ADDL == b.ADDL && a.CHAN == b.CHAN &&
+           memcmp(&a.SPED, &b.SPED, sizeof(a.SPED)) == 0 && memcmp(&a.OPTION, &b.OPTION, sizeof(a.OPTION)) == 0;
+}
+
+bool LoRaReceiver::configureLoRaModule(Configuration &configuration)
+{
+    // Lê a configuração uma vez só
+    unsigned long readStart = millis();
+    ResponseStructContainer c = e32ttl.getConfiguration();
+    if (c.status.code != 1)
     {
         Serial.println("Erro ao obter configuração atual! Tentando reinicializar...");
-        delay(1000);
+        c.close();
         
-        // Reinicializa e tenta novamente
         e32ttl.begin();
-        delay(1000);
+        waitAuxReady(LORA_AUX_TIMEOUT_MS);
+        c = e32ttl.getConfiguration();
+    }
+    bootReport.readMs = millis() - readStart;
+    
+    if (c.status.code != 1)
+    {
+        Serial.println("ERRO CRÍTICO: Não foi possível comunicar com o módulo E32!");
+        c.close();
+        return false;
+    }
+    configuration = *(Configuration *)c.data;
+    c.close();
+
+    Configuration desired = configuration;
+    applyGatewayProfile(desired);
+    if (configurationMatches(configuration, desired))
+    {
+        Serial.println("Configuração do E32 já confere, gravação dispensada");
+        return true;
+    }
+
+    // Grava de forma permanente: os próximos boots encontram a configuração
+    // certa e pulam esta etapa
+    Serial.println("Configuração do E32 diferente do perfil do Gateway, gravando...");
+    unsigned long writeStart = millis();
+    bool written = false;
+    for (int attempt = 0; attempt < 2 && !written; attempt++)
+    {
+        ResponseStatus rsConfig = e32ttl.setConfiguration(desired, WRITE_CFG_PWR_DWN_SAVE);
+        Serial.print("Status da aplicação da configuração: ");
+        Serial.println(rsConfig.getResponseDescription());
+        written = rsConfig.code == 1;
         
-        ResponseStructContainer c2 = e32ttl.getConfiguration();
-        if (c2.status.code == 1) {
-            Serial.println("Configuração obtida na segunda tentativa!");
-            // Aplica configuração na segunda tentativa...
-        } else {
-            Serial.println("ERRO CRÍTICO: Não foi possível comunicar com o módulo E32!");
-        }
-        c2.close();
+        // Módulo volta a ficar pronto quando o AUX sobe
+        waitAuxReady(LORA_AUX_TIMEOUT_MS);
     }
+    bootReport.writeMs = millis() - writeStart;
+    bootReport.configWritten = written;
 
-    c.close();
+    if (written)
+    {
+        Serial.println("Configurações aplicadas com sucesso!");
+        configuration = desired;
+    }
+    else
+    {
+        Serial.println("ERRO: Falha nas duas tentativas de configuração!");
+    }
+    return written;
 }
 
-ReceivedData LoRaReceiver::listenForData() {
-    ReceivedData emptyData = {"", 0, 0, 0.0};
-    
+void LoRaReceiver::attachQueue(ReadingQueue *queue) {
+    readingQueue = queue;
+}
+
+size_t LoRaReceiver::receive() {
     if (!isInitialized) {
-        Serial.println("ERRO: Módulo LoRa não inicializado!");
-        return emptyData;
+        return 0;
     }
     
-    // Verifica se há dados disponíveis
-    if (e32ttl.available() > 0) {
-        Serial.println("\n[GATEWAY] Dados recebidos via LoRa!");
-        
-        // Recebe a mensagem
-        ResponseContainer rc = e32ttl.receiveMessage();
-        
-        Serial.print("Status da recepção: ");
-        Serial.println(rc.status.getResponseDescription());
-        
-        if (rc.status.code == 1) { // Sucesso
-            Serial.print("Dados brutos recebidos: ");
-            Serial.println(rc.data);
-
-            // Faz parse do JSON individual
-            ReceivedData parsedData;
-            int parseResult = parseJSON(rc.data, parsedData);
-            
-            if (parseResult == 0) {
-                Serial.println(String("=").substring(0,40) + " DADOS VÁLIDOS " + String("=").substring(0,40));
-                Serial.println("Device ID: " + parsedData.device_id);
-                Serial.println("Heart Rate: " + String(parsedData.heart_rate) + " BPM");
-                Serial.println("Oxygen Level: " + String(parsedData.oxygen_level) + "%");
-                Serial.println("Temperature: " + String(parsedData.temperature) + "°C");
-                Serial.println(String("=").substring(0,90));
-                return parsedData;
-            } else {
-                Serial.println("Erro no parse do JSON recebido");
-            }
-        } else {
-            Serial.println("Erro na recepção. Código: " + String(rc.status.code));
-        }
+    // Os frames completos vão para a fila dentro de onFrame
+    uint32_t startUs = micros();
+    uint32_t before = readingQueue != nullptr ? readingQueue->pushedCount() : 0;
+    size_t received = receiveBytes();
+    uint32_t after = readingQueue != nullptr ? readingQueue->pushedCount() : 0;
+    if (received > 0) {
+        lastRxTime = millis();
+        reportRxTiming(startUs, after != before);
     }
     
-    return emptyData;
+    // Erros de CRC e JSON do parser desde a última recepção
+    const ParserStats &stats = parser.getStats();
+    uint32_t parseErrors = stats.crcErrors + stats.jsonErrors;
+    metricLoRaParseErrors.add(parseErrors - reportedParseErrors);
+    reportedParseErrors = parseErrors;
+    metricLoRaDiscardedBytes.add(stats.discardedBytes - reportedDiscarded);
+    reportedDiscarded = stats.discardedBytes;
+    reportReassemblyStats();
+    if (readingQueue != nullptr) {
+        metricQueueDepth.set(readingQueue->size());
+        metricQueueDropped.set(readingQueue->droppedCount());
+    }
+    return after - before;
 }
 
-std::vector<ReceivedData> LoRaReceiver::listenForMultipleData() {
-    std::vector<ReceivedData> dataList;
+void LoRaReceiver::reportRxTiming(uint32_t startUs, bool delivered) {
+    // CPU da tarefa por acordada com bytes: UART, parser e fila
+    uint32_t nowUs = micros();
+    metricLoRaRxCpuUs.observe(nowUs - startUs);
+    if (!delivered) {
+        return;
+    }
     
+    // Do fim do pacote (subida do AUX) até as leituras estarem na fila; 0
+    // quando a tarefa entregou antes do AUX subir (evento de UART ocioso)
+    uint32_t riseUs = auxRiseUs;
+    auxRiseUs = 0;
+    metricLoRaRxLatencyUs.observe(riseUs != 0 ? nowUs - riseUs : 0);
+}
+
+void LoRaReceiver::flushPending() {
+    // UART ocioso: descarta restos de pacotes incompletos e mensagens
+    // fragmentadas vencidas
+    parser.flush();
+    reassembler.expire(millis());
+    reportReassemblyStats();
+}
+
+DeviceTableSummary LoRaReceiver::summarizeDevices() {
+    // Uma passada de DEVICE_TABLE_SIZE posições, sem log, dentro da trava
+    portENTER_CRITICAL(&devicesLock);
+    DeviceTableSummary summary = devices.summarize();
+    portEXIT_CRITICAL(&devicesLock);
+    return summary;
+}
+
+bool LoRaReceiver::copyDevice(size_t index, DeviceState &device) {
+    portENTER_CRITICAL(&devicesLock);
+    device = devices.slot(index);
+    portEXIT_CRITICAL(&devicesLock);
+    return device.used;
+}
+
+void LoRaReceiver::sendAcks() {
+#if LORA_ACK_ENABLED
     if (!isInitialized) {
-        Serial.println("ERRO: Módulo LoRa não inicializado!");
-        return dataList;
+        return;
     }
     
-    // Verifica se há dados disponíveis
-    if (e32ttl.available() > 0) {
-        Serial.println("\n[GATEWAY] Iniciando coleta de múltiplas mensagens LoRa...");
-        
-        // Coleta múltiplas mensagens durante um período
-        unsigned long startTime = millis();
-        const unsigned long COLLECT_TIMEOUT = 3000; // 3 segundos para coletar mensagens
-        int messageCount = 0;
-        
-        while ((millis() - startTime) < COLLECT_TIMEOUT) {
-            if (e32ttl.available() > 0) {
-                messageCount++;
-                Serial.println("\n[GATEWAY] Processando mensagem #" + String(messageCount));
-                
-                // Recebe cada mensagem individual
-                ResponseContainer rc = e32ttl.receiveMessage();
-                
-                Serial.print("Status da recepção: ");
-                Serial.println(rc.status.getResponseDescription());
-                
-                if (rc.status.code == 1) { // Sucesso
-                    Serial.print("Dados recebidos: ");
-                    Serial.println(rc.data);
-                    
-                    // DEBUG: Mostra dados em formato hex/decimal
-                    Serial.print("Dados em HEX: ");
-                    for (int i = 0; i < rc.data.length(); i++) {
-                        Serial.print(String(rc.data.charAt(i), HEX) + " ");
-                    }
-                    Serial.println();
-                    
-                    Serial.print("Dados em ASCII: ");
-                    for (int i = 0; i < rc.data.length(); i++) {
-                        char c = rc.data.charAt(i);
-                        if (c >= 32 && c <= 126) {
-                            Serial.print(c);
-                        } else {
-                            Serial.print("[" + String((int)c) + "]");
-                        }
-                    }
-                    Serial.println();
-
-                    // Filtra dados válidos (deve começar com '{' para ser JSON)
-                    if (rc.data.length() > 0 && (rc.data.charAt(0) == '{' || rc.data.indexOf("{") != -1)) {
-                        // Processa se for dados concatenados ou mensagem única
-                        if (rc.data.indexOf("}{") != -1) {
-                            // Dados concatenados - usar extração múltipla
-                            std::vector<ReceivedData> extractedList = extractMultipleJSONs(rc.data);
-                            for (size_t i = 0; i < extractedList.size(); i++) {
-                                dataList.push_back(extractedList[i]);
-                            }
-                        } else {
-                            // Mensagem única - parsing direto
-                            ReceivedData parsedData;
-                            if (parseJSON(rc.data, parsedData) == 0) {
-                                dataList.push_back(parsedData);
-                                Serial.println("✅ Mensagem #" + String(messageCount) + " processada!");
-                            } else {
-                                Serial.println("❌ Erro no parse da mensagem #" + String(messageCount));
-                            }
-                        }
-                        
-                        // Reset do timeout - continua coletando se há mais dados
-                        startTime = millis();
-                    } else {
-                        Serial.println("⚠️  Dados recebidos não são JSON válido, ignorando mensagem #" + String(messageCount));
-                    }
-                } else {
-                    Serial.println("❌ Erro na recepção da mensagem #" + String(messageCount));
-                }
-            }
-            delay(50); // Pequeno delay para dar tempo às mensagens chegarem
+    // Half-duplex: enquanto o E32 transmite a confirmação (~70 ms no ar) o
+    // Gateway não ouve o canal, por isso só depois que o transmissor parou
+    collectStored();
+    AckFrame ack;
+    while (acks.takeDue(millis(), LORA_ACK_DELAY_MS, ack)) {
+        uint8_t frame[FRAME_ACK_SIZE];
+        size_t length = encodeAckFrame(ack, frame, sizeof(frame));
+        ResponseStatus rs = e32ttl.sendFixedMessage((uint8_t)(ack.device_addr >> 8), (uint8_t)(ack.device_addr & 0xFF),
+                                                    CHANNEL, frame, (uint8_t)length);
+        if (rs.code == 1) {
+            metricLoRaAcks.add();
+            LOG_DEBUG("Ack para TR-%03u: base=%u bitmap=%08lx", ack.device_addr, ack.base, (unsigned long)ack.bitmap);
+        } else {
+            metricLoRaAckErrors.add();
+            LOG_WARN("⚠️  Falha ao enviar ack para TR-%03u", ack.device_addr);
         }
-        
-        Serial.println("\n📋 RESUMO DA COLETA:");
-        Serial.println("📨 Mensagens LoRa processadas: " + String(messageCount));
-        Serial.println("✅ JSONs válidos coletados: " + String(dataList.size()));
-        Serial.println("⏱️  Tempo de coleta: " + String(millis() - startTime + COLLECT_TIMEOUT) + "ms");
     }
-    
-    return dataList;
+#endif
 }
 
-int LoRaReceiver::parseJSON(const String &jsonData, ReceivedData &data) {
-    Serial.println("Fazendo parse do JSON recebido...");
-    Serial.println("JSON para parse: " + jsonData);
-    
-    // Inicializa dados com valores padrão
-    data.device_id = "";
-    data.heart_rate = -1;
-    data.oxygen_level = -1;
-    data.temperature = 14.0;
-    
-    // Cria documento JSON para parse
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, jsonData);
+uint32_t LoRaReceiver::nextAckMs() {
+#if LORA_ACK_ENABLED
+    collectStored();
+    return acks.nextDueMs(millis(), LORA_ACK_DELAY_MS);
+#else
+    return UINT32_MAX;
+#endif
+}
+
+void LoRaReceiver::reportReassemblyStats() {
+    const ReassemblyStats &stats = reassembler.getStats();
+    uint32_t lost = stats.expired + stats.evicted;
+    metricLoRaMessages.add(stats.completed - reportedMessages);
+    metricLoRaMessagesLost.add(lost - reportedMessagesLost);
+    reportedMessages = stats.completed;
+    reportedMessagesLost = lost;
+}
+
+size_t LoRaReceiver::receiveBytes() {
+    // Ocupação do buffer do driver ao acordar: a folga até
+    // LORA_UART_RX_BUFFER_SIZE mostra quão perto a recepção chegou de perder bytes
+    size_t pending = serialLoRa.available();
+    if (pending > uartPeak) {
+        uartPeak = pending;
+        metricUartRxPeak.set(uartPeak);
+    }
     
-    if (error) {
-        Serial.println("Erro no parse JSON: " + String(error.c_str()));
-        return 1;
+    uint8_t chunk[32];
+    size_t received = 0;
+    while (serialLoRa.available() > 0) {
+        // UART -> buffer circular
+        while (serialLoRa.available() > 0 && rxRing.available() > 0) {
+            size_t count = serialLoRa.available();
+            if (count > sizeof(chunk)) count = sizeof(chunk);
+            if (count > rxRing.available()) count = rxRing.available();
+            count = serialLoRa.readBytes(chunk, count);
+            rxRing.write(chunk, count);
+            received += count;
+        }
+        
+        // Buffer circular -> parser (os frames completos chegam em onFrame).
+        // Esvazia o anel a cada volta, então ele nunca transborda: o que não
+        // coube nele continua no buffer do driver
+        uint8_t byte;
+        while (rxRing.pop(byte)) {
+            parser.push(byte);
+        }
     }
     
-    Serial.println("JSON parseado com sucesso!");
+    return received;
+}
+
+void LoRaReceiver::onFrame(const ParsedFrame &frame, void *context) {
+    LoRaReceiver *receiver = static_cast<LoRaReceiver *>(context);
     
-    // Extrai dados (formato compacto do transmitter)
-    if (doc.containsKey("id")) {
-        data.device_id = doc["id"].as<String>();
-        Serial.println("ID encontrado: " + data.device_id);
+    // Rajada: as leituras do frame seguem uma a uma, cada uma com a sua sequência
+    if (frame.header.type == FRAME_TYPE_BURST) {
+        ReadingFrame readings[FRAME_BURST_MAX_READINGS];
+        size_t count = 0;
+        if (decodeBurstPayload(frame.header, frame.payload, readings, FRAME_BURST_MAX_READINGS, count) != FRAME_OK) {
+            metricLoRaParseErrors.add();
+            return;
+        }
+        metricLoRaFrames.add();
+        for (size_t i = 0; i < count; i++) {
+            receiver->deliverReading(readings[i], false);
+        }
+        return;
     }
     
-    if (doc.containsKey("hr")) {
-        data.heart_rate = doc["hr"];
-        Serial.println("Heart Rate encontrado: " + String(data.heart_rate));
+    // Fragmento: a mensagem segue para onMessage quando completar
+    if (frame.header.type == FRAME_TYPE_FRAGMENT) {
+        if (receiver->reassembler.push(frame.header, frame.payload, millis()) != FRAME_OK) {
+            metricLoRaParseErrors.add();
+            return;
+        }
+        metricLoRaFrames.add();
+        return;
     }
     
-    if (doc.containsKey("ox")) {
-        data.oxygen_level = doc["ox"];
-        Serial.println("Oxygen Level encontrado: " + String(data.oxygen_level));
+    ReadingFrame reading;
+    if (decodeReadingPayload(frame.header, frame.payload, reading) != FRAME_OK) {
+        metricLoRaParseErrors.add();
+        return;
     }
+    metricLoRaFrames.add();
+    receiver->deliverReading(reading, frame.legacy);
+}
+
+void LoRaReceiver::onMessage(const ReassembledMessage &message, void *context) {
+    LoRaReceiver *receiver = static_cast<LoRaReceiver *>(context);
     
-    if (doc.containsKey("temp")) {
-        data.temperature = doc["temp"];
-        Serial.println("Temperature encontrada: " + String(data.temperature));
+    if (message.type != FRAME_TYPE_BURST) {
+        LOG_DEBUG("Mensagem tipo %u de TR-%03u (%u bytes) sem tratamento", message.type, message.device_addr,
+                  message.length);
+        return;
     }
     
-    // Valida se todos os dados foram extraídos
-    if (data.device_id.length() == 0 || data.heart_rate == -1 || 
-        data.oxygen_level == -1 || data.temperature == 14.0) {
-        Serial.println("ERRO: Dados incompletos após parse JSON!");
-        return 1;
+    size_t count = 0;
+    if (decodeBurstReadings(message.device_addr, message.sequence, message.data, message.length,
+                            receiver->messageReadings, LORA_MESSAGE_MAX_READINGS, count) != FRAME_OK) {
+        metricLoRaParseErrors.add();
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        receiver->deliverReading(receiver->messageReadings[i], false);
     }
-    
-    return 0;
 }
 
-std::vector<ReceivedData> LoRaReceiver::extractMultipleJSONs(const String &rawData) {
-    std::vector<ReceivedData> dataList;
-    Serial.println("\n🔍 Extraindo múltiplos JSONs da mensagem...");
-    Serial.println("Dados brutos (" + String(rawData.length()) + " chars): " + rawData);
-    
-    // Primeiro, vamos limpar caracteres de controle mais agressivamente
-    String cleanData = "";
-    for (int i = 0; i < rawData.length(); i++) {
-        char c = rawData.charAt(i);
-        // Mantém apenas caracteres imprimíveis ASCII e alguns específicos do JSON
-        if ((c >= 32 && c <= 126) || c == '\n' || c == '\r' || c == '\t') {
-            cleanData += c;
-        }
+void LoRaReceiver::deliverReading(const ReadingFrame &reading, bool legacy) {
+    if (readingQueue == nullptr) {
+        return;
     }
     
-    Serial.println("Dados limpos (" + String(cleanData.length()) + " chars): " + cleanData);
-    
-    // Estratégia mais robusta: usar regex-like para encontrar padrões
-    int pos = 0;
-    int jsonCount = 0;
+    // Fila cheia: a leitura não entra na tabela nem na confirmação, então
+    // o reenvio do transmissor não é tomado por duplicata
+    if (readingQueue->full() || storePending.full()) {
+        readingQueue->countDropped();
+        LOG_WARN("⚠️  Fila de leituras cheia, leitura descartada (total: %u)", readingQueue->droppedCount());
+        return;
+    }
     
-    while (pos < cleanData.length()) {
-        // Procura pelo padrão {"id":"TR-001" mais específico
-        int start = cleanData.indexOf("{\"id\":\"TR-001\"", pos);
-        if (start == -1) {
-            // Se não encontrar o padrão específico, tenta o genérico
-            start = cleanData.indexOf("{\"id\":", pos);
-            if (start == -1) break;
-        }
-        
-        // Encontra a próxima ocorrência de {"id": para saber onde termina este JSON
-        int nextJsonStart = cleanData.indexOf("{\"id\":", start + 1);
-        
-        // Extrai o JSON considerando o próximo início ou fim da string
-        String possibleJson;
-        if (nextJsonStart == -1) {
-            // É o último JSON
-            possibleJson = cleanData.substring(start);
-        } else {
-            // Há outro JSON depois
-            possibleJson = cleanData.substring(start, nextJsonStart);
-        }
-        
-        // Agora procura por um JSON válido dentro desta substring
-        int braceCount = 0;
-        int jsonEnd = -1;
-        
-        for (int i = 0; i < possibleJson.length(); i++) {
-            char c = possibleJson.charAt(i);
-            if (c == '{') {
-                braceCount++;
-            } else if (c == '}') {
-                braceCount--;
-                if (braceCount == 0) {
-                    jsonEnd = i;
-                    break;
-                }
-            }
+    // Frames binários trazem sequência por dispositivo; o JSON legado não
+    // (nem espera confirmação)
+    uint32_t now = millis();
+    portENTER_CRITICAL(&devicesLock);
+    bool fresh = devices.record(reading, !legacy, now);
+    portEXIT_CRITICAL(&devicesLock);
+#if LORA_ACK_ENABLED
+    // A rajada continua: o ack de leituras já guardadas espera ela terminar
+    if (!legacy) {
+        acks.touch(reading.device_addr, now);
+    }
+#endif
+    if (!fresh) {
+        // O reenvio quer dizer que a confirmação anterior se perdeu: já
+        // guardada, é confirmada de novo; ainda na fila, o ack sai junto
+        // com o da original
+#if LORA_ACK_ENABLED
+        if (!legacy && !awaitingStore(reading.device_addr, reading.sequence)) {
+            acks.record(reading.device_addr, reading.sequence, now);
         }
-        
-        if (jsonEnd != -1) {
-            String jsonString = possibleJson.substring(0, jsonEnd + 1);
-            jsonCount++;
-            
-            Serial.println("\n📄 JSON #" + String(jsonCount) + " extraído:");
-            Serial.println("   Posição: " + String(start) + " - " + String(start + jsonEnd));
-            Serial.println("   Conteúdo: " + jsonString);
-            Serial.println("   Tamanho: " + String(jsonString.length()) + " chars");
-            
-            // Valida se parece com um JSON válido antes de tentar parse
-            if (jsonString.indexOf("\"id\":") != -1 && 
-                jsonString.indexOf("\"hr\":") != -1 && 
-                jsonString.indexOf("\"ox\":") != -1 && 
-                jsonString.indexOf("\"temp\":") != -1) {
-                
-                ReceivedData data;
-                if (parseJSON(jsonString, data) == 0) {
-                    dataList.push_back(data);
-                    Serial.println("   ✅ Processado e adicionado com sucesso!");
-                } else {
-                    Serial.println("   ❌ Parse falhou");
-                }
-            } else {
-                Serial.println("   ⚠️  JSON incompleto, pulando...");
-            }
-            
-            pos = start + jsonEnd + 1;
-        } else {
-            // Se não conseguir encontrar fim válido, avança
-            pos = start + 1;
+#endif
+        metricLoRaDuplicates.add();
+        LOG_DEBUG("Leitura TR-%03u seq=%u duplicada, descartada", reading.device_addr, reading.sequence);
+        return;
+    }
+    
+    // O ack só sai depois que a tarefa store gravar a leitura na outbox
+    // (collectStored); antes disso um reboot a perderia
+    PendingStore pending = { reading.device_addr, reading.sequence, now, legacy };
+    storePending.push(pending);
+    // Só esta tarefa produz na fila, então ela não enche entre full() e push()
+    readingQueue->push(reading);
+    LOG_DEBUG("Leitura TR-%03u seq=%u%s", reading.device_addr, reading.sequence, legacy ? " (JSON)" : "");
+}
+
+void LoRaReceiver::collectStored() {
+    // A tarefa store grava na ordem da fila, que é a de storePending
+    uint32_t stored = storedReadings.load();
+    PendingStore pending;
+    while (storedSeen != stored && storePending.pop(pending)) {
+        storedSeen++;
+#if LORA_ACK_ENABLED
+        if (pending.legacy) {
+            continue;
         }
-        
-        // Proteção contra loop infinito
-        if (pos <= start) {
-            Serial.println("⚠️  Proteção contra loop infinito ativada");
-            break;
+        // O atraso conta do último frame ouvido do transmissor, que pode ter
+        // mandado mais leituras enquanto esta esperava na fila
+        uint32_t heardMs = pending.receivedMs;
+        const DeviceState *device = devices.find(pending.device_addr);
+        if (device != nullptr) {
+            heardMs = device->lastSeenMs;
         }
+        acks.record(pending.device_addr, pending.sequence, heardMs);
+#endif
     }
-    
-    Serial.println("\n📊 Resultado final da extração:");
-    Serial.println("   Tamanho original: " + String(rawData.length()) + " chars");
-    Serial.println("   Tamanho limpo: " + String(cleanData.length()) + " chars");
-    Serial.println("   JSONs encontrados: " + String(jsonCount));
-    Serial.println("   JSONs válidos: " + String(dataList.size()));
-    
-    return dataList;
 }
 
+bool LoRaReceiver::awaitingStore(uint16_t deviceAddr, uint16_t sequence) const {
+    for (size_t i = 0; i < storePending.size(); i++) {
+        const PendingStore &pending = storePending.at(i);
+        if (pending.device_addr == deviceAddr && pending.sequence == sequence && !pending.legacy) {
+            return true;
+        }
+    }
+    return false;
+}
 
 void LoRaReceiver::printConfiguration() {
-    // if (!isInitialized) {
-    //     Serial.println("Módulo LoRa não inicializado!");
-    //     return;
-    // }
-    
     ResponseStructContainer c = e32ttl.getConfiguration();
     if (c.status.code == 1) {
-        Configuration configuration = *(Configuration*) c.data;
-        
-        Serial.println("========== CONFIGURAÇÃO ATUAL ==========");
-        Serial.println("Endereço Alto (ADDH): " + String(configuration.ADDH, HEX));
-        Serial.println("Endereço Baixo (ADDL): " + String(configuration.ADDL, HEX));
-        Serial.println("Canal (CHAN): " + String(configuration.CHAN));
-        
-        Serial.print("Taxa de dados do ar: ");
-        switch(configuration.SPED.airDataRate) {
-            case AIR_DATA_RATE_000_03: Serial.println("0.3 kbps"); break;
-            case AIR_DATA_RATE_001_12: Serial.println("1.2 kbps"); break;
-            case AIR_DATA_RATE_010_24: Serial.println("2.4 kbps"); break;
-            case AIR_DATA_RATE_011_48: Serial.println("4.8 kbps"); break;
-            case AIR_DATA_RATE_100_96: Serial.println("9.6 kbps"); break;
-            case AIR_DATA_RATE_101_192: Serial.println("19.2 kbps"); break;
-            default: Serial.println("Desconhecida");
-        }
-        
-        Serial.print("Baud rate UART: ");
-        switch(configuration.SPED.uartBaudRate) {
-            case UART_BPS_1200: Serial.println("1200"); break;
-            case UART_BPS_2400: Serial.println("2400"); break;
-            case UART_BPS_4800: Serial.println("4800"); break;
-            case UART_BPS_9600: Serial.println("9600"); break;
-            case UART_BPS_19200: Serial.println("19200"); break;
-            case UART_BPS_38400: Serial.println("38400"); break;
-            case UART_BPS_57600: Serial.println("57600"); break;
-            case UART_BPS_115200: Serial.println("115200"); break;
-        }
-        
-        Serial.print("Potência de transmissão: ");
-        switch(configuration.OPTION.transmissionPower) {
-            case POWER_20: Serial.println("20 dBm"); break;
-            case POWER_17: Serial.println("17 dBm"); break;
-            case POWER_14: Serial.println("14 dBm"); break;
-            case POWER_10: Serial.println("10 dBm"); break;
-        }
-        
-        Serial.println("========================================");
+        printConfiguration(*(Configuration *)c.data);
     } else {
         Serial.println("Erro ao obter configuração: " + c.status.getResponseDescription());
     }
     
     c.close();
 }
+
+void LoRaReceiver::printConfiguration(const Configuration &configuration) {
+    Serial.println("========== CONFIGURAÇÃO ATUAL ==========");
+    Serial.println("Endereço Alto (ADDH): " + String(configuration.ADDH, HEX));
+    Serial.println("Endereço Baixo (ADDL): " + String(configuration.ADDL, HEX));
+    Serial.println("Canal (CHAN): " + String(configuration.CHAN));
+    
+    Serial.print("Taxa de dados do ar: ");
+    switch(configuration.SPED.airDataRate) {
+        case AIR_DATA_RATE_000_03: Serial.println("0.3 kbps"); break;
+        case AIR_DATA_RATE_001_12: Serial.println("1.2 kbps"); break;
+        case AIR_DATA_RATE_010_24: Serial.println("2.4 kbps"); break;
+        case AIR_DATA_RATE_011_48: Serial.println("4.8 kbps"); break;
+        case AIR_DATA_RATE_100_96: Serial.println("9.6 kbps"); break;
+        case AIR_DATA_RATE_101_192: Serial.println("19.2 kbps"); break;
+        default: Serial.println("Desconhecida");
+    }
+    
+    Serial.print("Baud rate UART: ");
+    switch(configuration.SPED.uartBaudRate) {
+        case UART_BPS_1200: Serial.println("1200"); break;
+        case UART_BPS_2400: Serial.println("2400"); break;
+        case UART_BPS_4800: Serial.println("4800"); break;
+        case UART_BPS_9600: Serial.println("9600"); break;
+        case UART_BPS_19200: Serial.println("19200"); break;
+        case UART_BPS_38400: Serial.println("38400"); break;
+        case UART_BPS_57600: Serial.println("57600"); break;
+        case UART_BPS_115200: Serial.println("115200"); break;
+    }
+    
+    Serial.print("Potência de transmissão: ");
+    switch(configuration.OPTION.transmissionPower) {
+        case POWER_20: Serial.println("20 dBm"); break;
+        case POWER_17: Serial.println("17 dBm"); break;
+        case POWER_14: Serial.println("14 dBm"); break;
+        case POWER_10: Serial.println("10 dBm"); break;
+    }
+    
+    Serial.println("========================================");
+}
@@ -3,8 +3,15 @@
 
 #include <Arduino.h>
 #include <LoRa_E32.h>
-#include <ArduinoJson.h>
-#include <vector>
+#include <atomic>
+#include "frame.h"
+#include "frame_parser.h"
+#include "ring_buffer.h"
+#include "spsc_queue.h"
+#include "device_table.h"
+#include "reassembly.h"
+#include "ack_tracker.h"
+#include "lora_uart.h"
 
 // Definições de pinos para E32
 #define LORA_RX_PIN 16
@@ -18,31 +25,137 @@
 #define GATEWAY_ADDL 0x01    // Endereço baixo do Gateway (0x0001)
 #define CHANNEL 0x17         // Canal 23 (0x17 em hex)
 
-// Estrutura para dados recebidos
-struct ReceivedData {
-    String device_id;      // Identificador único do dispositivo
-    int heart_rate;
-    int oxygen_level;
-    float temperature;
+// Modo de recepção (build flag LORA_RX_MODE)
+#define LORA_RX_MODE_POLLING 0   // Consulta o UART em intervalos fixos (modo antigo)
+#define LORA_RX_MODE_EVENT 1     // Acorda com eventos do UART (linha ociosa) e com o AUX do E32
+#ifndef LORA_RX_MODE
+#define LORA_RX_MODE LORA_RX_MODE_EVENT
+#endif
+
+#define LORA_AUX_TIMEOUT_MS 1000    // Espera máxima pelo AUX em HIGH (módulo pronto)
+#define LORA_AUX_SETTLE_MS 2        // O E32 pede ~2 ms após a subida do AUX
+#define LORA_HEALTH_INTERVAL_MS 1000  // Intervalo entre verificações de saúde do E32
+#define LORA_AUX_STUCK_MS 5000      // AUX em LOW por mais que isso: módulo travado
+#define LORA_RX_SILENCE_MS 120000   // Canal mudo por esse tempo: confere a configuração do E32
+#define LORA_POLL_INTERVAL_MS 50    // Intervalo entre consultas no modo polling
+
+// Confirmações (FRAME_TYPE_ACK) para o endereço fixo de cada transmissor,
+// enviadas quando ele fica LORA_ACK_DELAY_MS sem mandar nada: maior que o
+// intervalo entre dois frames de uma rajada (um pacote de 58 bytes leva
+// ~220 ms no ar a 2,4 kbps), para não transmitir no meio dela
+#ifndef LORA_ACK_ENABLED
+#define LORA_ACK_ENABLED 1
+#endif
+#ifndef LORA_ACK_DELAY_MS
+#define LORA_ACK_DELAY_MS 400
+#endif
+
+// Maior rajada que cabe numa mensagem fragmentada
+#define LORA_MESSAGE_MAX_READINGS (1 + (FRAME_MESSAGE_MAX_SIZE - FRAME_BURST_BASE_SIZE) / FRAME_BURST_DELTA_SIZE)
+
+// Fila de leituras entre a tarefa de recepção LoRa e a store, que grava na outbox (potência de 2)
+#ifndef READING_QUEUE_SIZE
+#define READING_QUEUE_SIZE 64
+#endif
+
+typedef SpscQueue<ReadingFrame, READING_QUEUE_SIZE> ReadingQueue;
+
+// Leitura posta na fila e ainda sem confirmação da outbox. A tarefa store
+// avisa quantas leituras o flash aceitou (na ordem da fila) e só então a
+// recepção programa o ack; cabe a fila cheia mais o que espera em RAM por
+// uma nova tentativa de gravação. Cheio, a leitura é descartada sem ack
+#define LORA_STORE_PENDING_SIZE (2 * READING_QUEUE_SIZE)
+
+struct PendingStore {
+    uint16_t device_addr;
+    uint16_t sequence;
+    uint32_t receivedMs;    // Transmissor fora da tabela: o atraso do ack conta daqui
+    bool legacy;            // JSON legado: não recebe ack
+};
+
+// Duração das etapas do initLoRa, em ms
+struct LoRaBootReport {
+    uint32_t readyMs;       // Até o E32 ficar pronto (AUX em HIGH)
+    uint32_t readMs;        // Leitura da configuração
+    uint32_t writeMs;       // Gravação (0 quando a configuração já confere)
+    uint32_t totalMs;
+    bool configWritten;
+};
+
+// Resultado de LoRaReceiver::checkHealth
+enum LoRaHealth {
+    LORA_HEALTH_PENDING,          // Nada novo (fora do intervalo ou AUX ainda dentro do prazo)
+    LORA_HEALTH_OK,
+    LORA_HEALTH_AUX_STUCK,
+    LORA_HEALTH_NO_RESPONSE,      // E32 não respondeu à leitura da configuração
+    LORA_HEALTH_CONFIG_CHANGED    // Configuração diferente do perfil (ex.: volta ao padrão de fábrica)
 };
 
+const char *loraHealthName(LoRaHealth health);
+
 class LoRaReceiver {
 private:
     HardwareSerial serialLoRa;
     LoRa_E32 e32ttl;
     bool isInitialized;
+    RingBuffer<uint8_t, LORA_RX_RING_SIZE> rxRing;
+    FrameParser parser;
+    ReadingQueue *readingQueue;   // Destino das leituras decodificadas
+    DeviceTable devices;          // Estado por transmissor; descarta duplicatas antes da fila
+    portMUX_TYPE devicesLock;     // A tarefa de uplink lê a tabela para o log
+    Reassembler reassembler;      // Mensagens fragmentadas em andamento
+    AckTracker acks;              // Confirmações pendentes por transmissor
+    RingBuffer<PendingStore, LORA_STORE_PENDING_SIZE> storePending; // Na fila, ainda fora da outbox
+    std::atomic<uint32_t> storedReadings; // Guardadas na outbox, contadas pela tarefa store
+    uint32_t storedSeen;          // Parte de storedReadings já tirada de storePending
+    ReadingFrame messageReadings[LORA_MESSAGE_MAX_READINGS]; // Rajada de uma mensagem remontada
+    uint32_t reportedMessages;    // Mensagens remontadas já somadas às métricas
+    uint32_t reportedMessagesLost;
+    uint32_t reportedParseErrors; // Erros do parser já somados às métricas
+    uint32_t reportedDiscarded;   // Bytes descartados pelo parser já somados às métricas
+    size_t uartPeak;              // Maior ocupação vista no buffer do driver do UART
+    LoRaBootReport bootReport;
+    uint32_t lastRxTime;          // Último byte recebido do E32
+    uint32_t lastHealthCheck;
+    uint32_t lastConfigCheck;
+    uint32_t auxLowSince;         // 0 = AUX em HIGH na última verificação
     
 public:
     LoRaReceiver();
     bool initLoRa();
-    ReceivedData listenForData();
-    std::vector<ReceivedData> listenForMultipleData();
+    void attachQueue(ReadingQueue *queue);
+    bool waitForData(unsigned long timeoutMs);
+    size_t receive();
+    void flushPending();
     void printConfiguration();
+    // Só da tarefa de recepção, que é dona do UART do E32
+    LoRaHealth checkHealth(uint32_t now);
+    bool recover();
+    void sendAcks();
+    // Chamado pela tarefa store depois de gravar count leituras da fila
+    void readingsStored(uint32_t count) { storedReadings.fetch_add(count); }
+    uint32_t nextAckMs();     // ms até a próxima confirmação (UINT32_MAX se nenhuma)
+    // Leitura da tabela de transmissores por outra tarefa: cópias sob a trava
+    DeviceTableSummary summarizeDevices();
+    bool copyDevice(size_t index, DeviceState &device);
+    const LoRaBootReport &getBootReport() const { return bootReport; }
     
     private:
-    void configureLoRaModule();
-    int parseJSON(const String &jsonData, ReceivedData &data);
-    std::vector<ReceivedData> extractMultipleJSONs(const String &rawData);
+    bool configureLoRaModule(Configuration &configuration);
+    static void applyGatewayProfile(Configuration &configuration);
+    static bool configurationMatches(const Configuration &a, const Configuration &b);
+    bool waitAuxReady(unsigned long timeoutMs);
+    void printConfiguration(const Configuration &configuration);
+    void enableRxEvents();
+    static void onUartError(hardwareSerial_error_t error);
+    size_t receiveBytes();
+    static void onFrame(const ParsedFrame &frame, void *context);
+    void deliverReading(const ReadingFrame &reading, bool legacy);
+    void collectStored();
+    bool awaitingStore(uint16_t deviceAddr, uint16_t sequence) const;
+    static void onMessage(const ReassembledMessage &message, void *context);
+    void reportReassemblyStats();
+    void reportRxTiming(uint32_t startUs, bool delivered);
 };
 
 #endif
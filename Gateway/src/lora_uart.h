@@ -0,0 +1,25 @@
+#ifndef LORA_UART_H
+#define LORA_UART_H
+
+// Parâmetros do UART entre o E32 e o ESP32. Ficam fora de lora.h, que
+// depende do Arduino, para que tools/lora_sim.cpp use os mesmos valores.
+
+// Símbolos de silêncio no UART que encerram um pacote (modo por eventos)
+#ifndef LORA_RX_IDLE_SYMBOLS
+#define LORA_RX_IDLE_SYMBOLS 2
+#endif
+#define LORA_IDLE_WAIT_MS 250       // Espera máxima por dados antes de descartar pacotes incompletos
+
+// Buffer do driver do UART do E32, preenchido pela ISR independente das
+// tarefas. Cabe o buffer inteiro do E32 (512 bytes) despejado de uma vez,
+// com folga para a tarefa de recepção atrasar; o padrão do Arduino é 256
+#ifndef LORA_UART_RX_BUFFER_SIZE
+#define LORA_UART_RX_BUFFER_SIZE 1024
+#endif
+
+// Buffer circular entre o UART e o parser (potência de 2)
+#ifndef LORA_RX_RING_SIZE
+#define LORA_RX_RING_SIZE 512
+#endif
+
+#endif
@@ -1,134 +1,593 @@
 #include <Arduino.h>
-#include <vector>
+#include <LittleFS.h>
 #include "lora.h"
 #include "network.h"
+#include "outbox.h"
+#include "aggregator.h"
+#include "log.h"
+#include "metrics.h"
+#include "bench.h"
+#include "supervisor.h"
 
 // Instâncias dos gerenciadores
 LoRaReceiver loraReceiver;
 NetworkManager networkManager;
 
+// Fila lock-free entre a recepção LoRa (produtor) e o uplink (consumidor)
+ReadingQueue readingQueue;
+
+// Leituras pendentes de envio, persistidas no flash (sobrevivem a reboots)
+Outbox outbox;
+
+// Outbox e agregador: a tarefa store grava, a de uplink lê e confirma.
+// Ninguém segura a trava durante WiFi ou HTTP
+SemaphoreHandle_t storeLock = nullptr;
+
+#if AGGREGATION_MODE
+// Resumos por transmissor no lugar das leituras individuais
+Aggregator aggregator;
+#endif
+
 // Configurações
 #define LED_STATUS 2
 #define WIFI_RETRY_DELAY 30000 // 30 segundos entre tentativas de WiFi
+#define OUTBOX_PATH "/littlefs/outbox"
+#define SERIAL_COMMAND_SIZE 32
+#define SERIAL_POLL_MS 100
+
+// Supervisão: falhas seguidas até reinicializar o subsistema e espera entre tentativas
+#define LORA_FAULT_THRESHOLD 2
+#define LORA_BACKOFF_MIN_MS 1000
+#define LORA_BACKOFF_MAX_MS 60000
+#define NETWORK_FAULT_THRESHOLD 3
+#define NETWORK_BACKOFF_MAX_MS 300000
+#define API_BACKOFF_MAX_MS 3600000
+
+// Tarefas: recepção e gravação na outbox no APP_CPU (1), uplink no PRO_CPU
+// (0) junto da pilha WiFi
+#define LORA_TASK_CORE 1
+#define STORE_TASK_CORE 1
+#define UPLINK_TASK_CORE 0
+#define LORA_TASK_PRIORITY 3
+#define STORE_TASK_PRIORITY 2
+#define UPLINK_TASK_PRIORITY 2
+#define LOG_TASK_PRIORITY 1
+#define LORA_TASK_STACK 4096
+#define STORE_TASK_STACK 6144
+#define UPLINK_TASK_STACK 8192
+#define STORE_RETRY_MS 1000     // Nova tentativa de gravar no flash que recusou a escrita
+
+// As confirmações fora de ordem de uma rodada cabem no bitmap da outbox
+static_assert(UPLINK_WINDOW_SIZE <= OUTBOX_ACK_WINDOW, "UPLINK_WINDOW_SIZE maior que OUTBOX_ACK_WINDOW");
 
-unsigned long lastWiFiAttempt = 0;
-bool systemReady = false;
+TaskHandle_t loraTaskHandle = nullptr;
+TaskHandle_t storeTaskHandle = nullptr;
+TaskHandle_t uplinkTaskHandle = nullptr;
+
+// Saúde de cada subsistema, atualizada pela tarefa dona dele
+SubsystemHealth loraHealth("lora", LORA_FAULT_THRESHOLD, LORA_BACKOFF_MIN_MS, LORA_BACKOFF_MAX_MS);
+SubsystemHealth networkHealth("network", NETWORK_FAULT_THRESHOLD, WIFI_RETRY_DELAY, NETWORK_BACKOFF_MAX_MS);
+// A API recusando a chave ou o endpoint não se resolve reinicializando nada:
+// só espaça as tentativas enquanto a configuração não for corrigida
+SubsystemHealth apiHealth("api", UINT8_MAX, WIFI_RETRY_DELAY, API_BACKOFF_MAX_MS);
 
 void blinkLED(int times, int delayMs);
+void loraTask(void *parameter);
+void storeTask(void *parameter);
+void uplinkTask(void *parameter);
+void superviseLoRa();
+bool uploadPendingReadings();
+bool storeQueuedReadings();
+uint32_t storeWaitMs();
+void lockStore();
+void unlockStore();
+bool uploadPendingSummaries();
+size_t pendingUploads();
+void logDeviceSequenceStats();
+uint32_t uptimeSeconds();
+void pollSerialCommands();
+void runSerialCommand(const char *command);
 
 void setup() {
     Serial.begin(115200);
+    logInit(LOG_TASK_PRIORITY, UPLINK_TASK_CORE);
     Serial.println("\n" + String("=").substring(0,50));
     Serial.println("🩺 VitalSync Gateway Iniciando...");
     Serial.println("" + String("=").substring(0,50));
     
-    // Configura LED de status
+    // Configura LED de status (no GPIO do AUX o pino fica com a recepção LoRa)
+#if LED_STATUS != LORA_AUX_PIN
     pinMode(LED_STATUS, OUTPUT);
     digitalWrite(LED_STATUS, LOW);
+#endif
     
     Serial.println("\n[ETAPA 1] Inicializando módulo LoRa...");
     
     // Inicializa receptor LoRa
-    if (loraReceiver.initLoRa()) {
+    unsigned long phaseStart = millis();
+    bool loraReady = loraReceiver.initLoRa();
+    unsigned long loraMs = millis() - phaseStart;
+    if (loraReady) {
         Serial.println("✅ LoRa inicializado com sucesso!");
-        systemReady = true;
-        
-        blinkLED(2, 500);
     } else {
-        Serial.println("❌ Falha na inicialização do LoRa!");
-        systemReady = false;
+        // Sem reboot: a tarefa de recepção reinicializa só o módulo, com espera
+        // crescente, enquanto o resto do Gateway sobe normalmente
+        Serial.println("❌ Falha na inicialização do LoRa! Nova tentativa pela supervisão");
+        loraHealth.markDown("inicialização falhou", millis());
     }
     
+    loraReceiver.attachQueue(&readingQueue);
+    networkManager.begin();
+    
+    // Outbox no LittleFS (formata na primeira vez)
+    phaseStart = millis();
+    if (LittleFS.begin(true) && outbox.begin(OUTBOX_PATH, uptimeSeconds())) {
+        LOG_INFO("💾 Outbox: %u leitura(s) pendente(s) no flash", outbox.pendingCount());
+    } else {
+        LOG_ERROR("❌ Falha ao montar o LittleFS, outbox só em RAM (até %u leituras)", OUTBOX_RAM_RECORDS);
+    }
+    unsigned long outboxMs = millis() - phaseStart;
+    
+    // A recepção nunca espera pela rede: cada lado roda em um núcleo, e a
+    // gravação na outbox (de que depende o ack) fica fora da tarefa de uplink
+    storeLock = xSemaphoreCreateMutex();
+    xTaskCreatePinnedToCore(uplinkTask, "uplink", UPLINK_TASK_STACK, nullptr,
+                            UPLINK_TASK_PRIORITY, &uplinkTaskHandle, UPLINK_TASK_CORE);
+    xTaskCreatePinnedToCore(storeTask, "store", STORE_TASK_STACK, nullptr,
+                            STORE_TASK_PRIORITY, &storeTaskHandle, STORE_TASK_CORE);
+    xTaskCreatePinnedToCore(loraTask, "lora_rx", LORA_TASK_STACK, nullptr,
+                            LORA_TASK_PRIORITY, &loraTaskHandle, LORA_TASK_CORE);
+    
+    // Tempo desde o início do firmware até a escuta, por etapa
+    const LoRaBootReport &loraBoot = loraReceiver.getBootReport();
+    LOG_INFO("⏱️  Escutando %lu ms após o boot (LoRa %lu ms, outbox %lu ms)", millis(), loraMs, outboxMs);
+    LOG_INFO("⏱️  E32: pronto %lu ms, leitura %lu ms, gravação %lu ms", (unsigned long)loraBoot.readyMs,
+             (unsigned long)loraBoot.readMs, (unsigned long)loraBoot.writeMs);
+    
     Serial.println("\n[GATEWAY] Sistema pronto - Modo escuta LoRa ativo");
     Serial.println("Aguardando dados do Transmitter...\n");
+    
+    // Depois de a recepção já estar rodando, para não atrasar a escuta
+    blinkLED(2, 500);
 }
 
 void loop() {
-    if (!systemReady) {
-        Serial.println("Sistema não está pronto. Tentando reinicializar...");
-        delay(5000);
-        ESP.restart();
+    // O trabalho acontece nas tarefas loraTask e uplinkTask; aqui só os
+    // comandos de diagnóstico pela Serial
+    pollSerialCommands();
+    delay(SERIAL_POLL_MS);
+}
+
+void loraTask(void *parameter) {
+    for (;;) {
+        // Acorda a tempo da próxima confirmação, que o transmissor está esperando
+        uint32_t waitMs = loraReceiver.nextAckMs();
+        if (waitMs > LORA_IDLE_WAIT_MS) {
+            waitMs = LORA_IDLE_WAIT_MS;
+        }
+        if (loraReceiver.waitForData(waitMs)) {
+            // [ETAPA 1] Frames completos vão direto para a fila
+            if (loraReceiver.receive() > 0) {
+                xTaskNotifyGive(storeTaskHandle);
+            }
+        } else if (waitMs == LORA_IDLE_WAIT_MS) {
+            loraReceiver.flushPending();
+        }
+        loraReceiver.sendAcks();
+        superviseLoRa();
+    }
+}
+
+void superviseLoRa() {
+    uint32_t now = millis();
+    if (loraHealth.needsReinit()) {
+        if (!loraHealth.retryDue(now)) {
+            return;
+        }
+        LOG_WARN("🔧 Reinicializando o módulo LoRa (%s)...", loraHealth.getLastFault());
+        bool ok = loraReceiver.recover();
+        metricLoRaRecoveries.add();
+        loraHealth.reinitDone(ok, millis());
         return;
     }
     
-    // [ETAPA 1] Escuta dados via LoRa - agora processa múltiplos dados
-    std::vector<ReceivedData> receivedDataList = loraReceiver.listenForMultipleData();
+    LoRaHealth health = loraReceiver.checkHealth(now);
+    if (health == LORA_HEALTH_OK) {
+        loraHealth.reportHealthy();
+    } else if (health != LORA_HEALTH_PENDING) {
+        loraHealth.reportFault(loraHealthName(health), now);
+    }
+}
 
-    // Se dados válidos foram recebidos
-    if (!receivedDataList.empty()) {
-        Serial.println("\n[ETAPA 2] " + String(receivedDataList.size()) + " conjunto(s) de dados válidos recebidos!");
+void storeTask(void *parameter) {
+    for (;;) {
+        // Acorda com a recepção, para repetir uma gravação recusada e no fim
+        // da janela de agregação
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(storeWaitMs()));
+        if (storeQueuedReadings()) {
+            xTaskNotifyGive(uplinkTaskHandle);
+        }
+    }
+}
+
+void uplinkTask(void *parameter) {
+    for (;;) {
+        // Aguarda a primeira leitura de uma rajada
+        if (pendingUploads() == 0) {
+            // Acorda periodicamente para fechar a conexão HTTP ociosa
+            if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(HTTP_IDLE_TIMEOUT_MS)) == 0) {
+                networkManager.closeIdleConnection();
+            }
+            continue;
+        }
+        
+        // Junta leituras até completar um lote ou vencer o prazo de envio
+        unsigned long firstReading = millis();
+        for (;;) {
+            unsigned long elapsed = millis() - firstReading;
+            if (pendingUploads() >= UPLINK_BATCH_SIZE || elapsed >= UPLINK_FLUSH_MS) {
+                break;
+            }
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(UPLINK_FLUSH_MS - elapsed));
+        }
+        
+        // [ETAPA 2] Leituras recebidas
+        LOG_INFO("[ETAPA 2] %u conjunto(s) de dados válidos pendentes", pendingUploads());
         
         // Pisca LED para indicar recepção
         blinkLED(3, 300);
         
-        // [ETAPA 3] Conecta ao WiFi
-        Serial.println("\n[ETAPA 3] Conectando ao WiFi...");
+        // Falhas seguidas do WiFi: reinicia só a pilha WiFi (a recepção LoRa segue)
+        if (networkHealth.needsReinit()) {
+            networkManager.resetWiFi();
+            networkHealth.reinitDone(true, millis());
+        }
         
+        // [ETAPA 3] Conecta ao WiFi
+        uint32_t retryMs = WIFI_RETRY_DELAY;
         if (networkManager.connectWiFi()) {
-            Serial.println("✅ WiFi conectado!");
-         
-            // [ETAPA 4] Envia todos os dados para API
-            Serial.println("\n[ETAPA 4] Enviando " + String(receivedDataList.size()) + " conjunto(s) de dados para API...");
-            
-            int successCount = 0;
-            int errorCount = 0;
+            networkHealth.reportHealthy();
+            bool sent = uploadPendingReadings();
             
-            for (size_t i = 0; i < receivedDataList.size(); i++) {
-                ReceivedData currentData = receivedDataList[i];
-                
-                Serial.println("\n--- ENVIANDO DADOS #" + String(i + 1) + " ---");
-                Serial.println("Device ID: " + currentData.device_id);
-                Serial.println("Heart Rate: " + String(currentData.heart_rate) + " BPM");
-                Serial.println("Oxygen Level: " + String(currentData.oxygen_level) + "%");
-                Serial.println("Temperature: " + String(currentData.temperature) + "°C");
-                
-                if (networkManager.sendDataToAPI(currentData)) {
-                    Serial.println("✅ Dados #" + String(i + 1) + " enviados com sucesso!");
-                    successCount++;
-                } else {
-                    Serial.println("❌ Erro no envio dos dados #" + String(i + 1));
-                    errorCount++;
-                }
-                
-                // Pequeno delay entre envios para não sobrecarregar a API
-                delay(500);
+            // [ETAPA 5] Desconecta WiFi (ou mantém, se as rajadas forem frequentes)
+            networkManager.finishBurst();
+            if (sent) {
+                apiHealth.reportHealthy();
+                continue;
             }
-            
-            Serial.println("\n📊 RESUMO DO ENVIO:");
-            Serial.println("✅ Sucessos: " + String(successCount));
-            Serial.println("❌ Erros: " + String(errorCount));
-            Serial.println("📦 Total processado: " + String(receivedDataList.size()));
-            
-            if (successCount > 0) {
-                blinkLED(5, 100); // LED rápido = sucesso
+            if (networkManager.getConfigError() != 0) {
+                apiHealth.reportFault("API recusou a configuração (401/403/404)", millis());
+                retryMs = apiHealth.retryDelayMs(millis());
             }
-            if (errorCount > 0) {
-                blinkLED(10, 50); // LED muito rápido = erro
+        } else {
+            LOG_WARN("❌ Falha na conexão WiFi");
+            networkHealth.reportFault("WiFi não conectou", millis());
+            retryMs = networkHealth.retryDelayMs(millis());
+        }
+        
+        // As leituras ficam no flash até a próxima tentativa; a tarefa store
+        // continua gravando as novas enquanto isso
+        lockStore();
+        uint32_t pending = outbox.pendingCount();
+        uint32_t oldestAge = outbox.oldestAgeSeconds(uptimeSeconds());
+        unlockStore();
+        LOG_WARN("Nova tentativa em %u s (%u leituras pendentes, mais antiga há %u s)", retryMs / 1000, pending,
+                 oldestAge);
+        vTaskDelay(pdMS_TO_TICKS(retryMs));
+    }
+}
+
+bool uploadPendingReadings() {
+    // [ETAPA 4] Envia todos os dados para API (inclusive os que chegarem durante o envio)
+    LOG_INFO("[ETAPA 4] Enviando %u conjunto(s) de dados para API...", pendingUploads());
+    
+    int successCount = 0;
+    int errorCount = 0;
+    bool sent = true;
+    uint32_t connectionsBefore = networkManager.getConnectionsOpened();
+    OutboxRecord records[UPLINK_WINDOW_SIZE];
+    ReceivedData batch[UPLINK_WINDOW_SIZE];
+    uint8_t position[UPLINK_WINDOW_SIZE];     // Índice no peek() de cada item do lote
+    bool delivered[UPLINK_WINDOW_SIZE];
+    bool answered[UPLINK_WINDOW_SIZE];
+    bool done[UPLINK_WINDOW_SIZE];
+    int sentBefore = 0;
+    int rejectedBefore = 0;
+    
+    for (;;) {
+        // Um POST por lote de até UPLINK_BATCH_SIZE leituras, das mais antigas
+        // para as mais novas; com UPLINK_CONNECTIONS > 1, vários lotes em paralelo
+        lockStore();
+        size_t count = outbox.peek(records, UPLINK_WINDOW_SIZE);
+        // Pula as já respondidas numa rodada anterior (lote paralelo que
+        // completou enquanto outro falhou)
+        for (size_t i = 0; i < count; i++) {
+            done[i] = outbox.isAcknowledged(i);
+        }
+        uint32_t droppedBefore = outbox.droppedCount() + outbox.ramDroppedCount();
+        unlockStore();
+        if (count == 0) {
+            break;
+        }
+        size_t pending = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (!done[i]) {
+                position[pending] = (uint8_t)i;
+                batch[pending++] = toReceivedData(records[i].reading);
             }
-           
-            // [ETAPA 5] Desconecta WiFi
-            Serial.println("\n[ETAPA 5] Desconectando WiFi...");
-            networkManager.disconnectWiFi();
+        }
         
-        } else {
-            Serial.println("❌ Falha na conexão WiFi!");
-            Serial.println("Tentativa de WiFi adiada por 30 segundos...");
-            lastWiFiAttempt = millis();
+        // Só sai da outbox o que o servidor respondeu de forma definitiva
+        size_t processed = networkManager.sendBatchToAPI(batch, pending, delivered, answered);
+        for (size_t i = 0; i < pending; i++) {
+            if (!answered[i]) {
+                continue;
+            }
+            done[position[i]] = true;
+            if (delivered[i]) {
+                successCount++;
+            } else {
+                errorCount++;
+            }
+        }
+        // Registros descartados durante o envio (flash ou anel em RAM cheios)
+        // mudam as posições do peek(): sem confirmar, o lote sai de novo
+        lockStore();
+        bool shifted = outbox.droppedCount() + outbox.ramDroppedCount() != droppedBefore;
+        if (!shifted) {
+            outbox.acknowledge(done, count);
+        }
+        unlockStore();
+        if (shifted) {
+            LOG_WARN("⚠️  Outbox descartou registros durante o envio, lote será reenviado");
         }
-      
-        Serial.println("\n[GATEWAY] Retornando ao modo escuta LoRa...");
-        Serial.println("" + String("-").substring(0,50) + "\n");
+        metricReadingsSent.add(successCount - sentBefore);
+        metricReadingsRejected.add(errorCount - rejectedBefore);
+        sentBefore = successCount;
+        rejectedBefore = errorCount;
+        
+        if (processed < pending) {
+            sent = false;
+            break;
+        }
+    }
+    if (sent) {
+        sent = uploadPendingSummaries();
     }
     
-    // Pequeno delay para não sobrecarregar o sistema
-    delay(100);
+    LOG_INFO("📊 Envio: %d sucesso(s), %d recusada(s), %u pendente(s)", successCount, errorCount, pendingUploads());
+    LOG_INFO("🔌 Conexões TCP abertas nesta rajada: %u", networkManager.getConnectionsOpened() - connectionsBefore);
+    const WiFiStats &wifi = networkManager.getWiFiStats();
+    LOG_INFO("📶 WiFi: última conexão %lu ms, máx %lu ms", wifi.lastConnectMs, wifi.maxConnectMs);
+    LOG_INFO("📶 WiFi: %u rápida(s), %u completa(s), %u reaproveitada(s)",
+             wifi.fastConnects, wifi.fullConnects, wifi.reusedLinks);
+    LOG_INFO("🗑️  Fila: %u descartadas, pico %u/%u", readingQueue.droppedCount(),
+             readingQueue.highWatermark(), ReadingQueue::capacity());
+    uint32_t uartOverflows = metricUartFifoOverflows.get() + metricUartBufferFull.get();
+    LOG_INFO("📻 UART LoRa: pico %ld/%u bytes, %u transbordo(s), %u byte(s) descartados",
+             (long)metricUartRxPeak.get(), LORA_UART_RX_BUFFER_SIZE, uartOverflows, metricLoRaDiscardedBytes.get());
+#if UPLINK_COMPRESSION
+    const CompressionStats &compression = networkManager.getCompressionStats();
+    if (compression.bytesIn > 0) {
+        LOG_INFO("🗜️  Compressão: %lu -> %lu bytes em %u corpo(s), %lu us de CPU",
+                 (unsigned long)compression.bytesIn, (unsigned long)compression.bytesOut,
+                 compression.bodies, (unsigned long)compression.cpuMicros);
+    }
+#endif
+    lockStore();
+    uint32_t flashPending = outbox.flashPendingCount();
+    uint32_t ramPending = outbox.ramPendingCount();
+    uint32_t dropped = outbox.droppedCount();
+    uint32_t ramDropped = outbox.ramDroppedCount();
+    uint32_t writeErrors = outbox.writeErrorCount();
+    unlockStore();
+    LOG_INFO("💾 Outbox: %u no flash, %u só em RAM, %u descartadas por falta de espaço", flashPending, ramPending,
+             dropped);
+    if (ramDropped > 0 || writeErrors > 0) {
+        LOG_WARN("⚠️  Outbox: %u leitura(s) perdidas no anel em RAM, %u escrita(s) no flash falharam", ramDropped,
+                 writeErrors);
+    }
+    logDeviceSequenceStats();
+    
+#if METRICS_PUSH
+    metricsSampleHeap();
+    networkManager.sendMetricsToAPI();
+#endif
+    
+    if (successCount > 0) {
+        blinkLED(5, 100); // LED rápido = sucesso
+    }
+    if (errorCount > 0 || !sent) {
+        blinkLED(10, 50); // LED muito rápido = erro
+    }
+    return sent;
+}
+
+void logDeviceSequenceStats() {
+    // Resumo de todos os transmissores; detalhe por transmissor só em debug.
+    // A tabela é da tarefa de recepção: aqui só cópias feitas sob a trava
+    DeviceTableSummary summary = loraReceiver.summarizeDevices();
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+    DeviceState device;
+    for (size_t i = 0; i < DeviceTable::capacity(); i++) {
+        if (!loraReceiver.copyDevice(i, device)) {
+            continue;
+        }
+        LOG_DEBUG("📡 TR-%03u: %u leitura(s), %u duplicada(s), enlace %u%%",
+                  device.device_addr, device.readings, device.sequence.duplicates, deviceLinkQuality(device));
+    }
+#endif
+    LOG_INFO("📡 Transmissores: %u/%u, %u duplicada(s), %u perdida(s)",
+             summary.devices, DEVICE_TABLE_MAX_DEVICES, summary.duplicates, summary.gaps);
+    if (summary.untracked > 0) {
+        LOG_WARN("⚠️  Tabela de transmissores cheia: %u leitura(s) sem controle de duplicatas", summary.untracked);
+    }
+}
+
+bool uploadPendingSummaries() {
+#if AGGREGATION_MODE
+    AggregateSummary summaries[UPLINK_BATCH_SIZE];
+    for (;;) {
+        // Os resumos entram só no fim do anel: os peek() continuam válidos
+        lockStore();
+        size_t count = aggregator.peek(summaries, UPLINK_BATCH_SIZE);
+        unlockStore();
+        if (count == 0) {
+            break;
+        }
+        size_t processed = networkManager.sendSummariesToAPI(summaries, count);
+        lockStore();
+        aggregator.acknowledge(processed);
+        unlockStore();
+        if (processed < count) {
+            return false;
+        }
+    }
+    lockStore();
+    uint32_t folded = aggregator.foldedCount();
+    uint32_t excursions = aggregator.excursionCount();
+    uint32_t dropped = aggregator.droppedCount();
+    unlockStore();
+    LOG_INFO("🧮 Agregação: %u leitura(s) resumidas, %u fora dos limites, %u resumo(s) perdidos", folded, excursions,
+             dropped);
+#endif
+    return true;
+}
+
+size_t pendingUploads() {
+    lockStore();
+    size_t pending = outbox.pendingCount();
+#if AGGREGATION_MODE
+    pending += aggregator.pendingCount();
+#endif
+    unlockStore();
+    return pending;
+}
+
+void lockStore() {
+    xSemaphoreTake(storeLock, portMAX_DELAY);
+}
+
+void unlockStore() {
+    xSemaphoreGive(storeLock);
+}
+
+uint32_t storeWaitMs() {
+    // Leituras que o flash recusou continuam em RAM e sem ack: tenta de novo logo
+    lockStore();
+    uint32_t waitMs = outbox.isMounted() && outbox.ramPendingCount() > 0 ? STORE_RETRY_MS : HTTP_IDLE_TIMEOUT_MS;
+#if AGGREGATION_MODE
+    // Acorda também no fim da janela de agregação
+    uint32_t windowMs = aggregator.msUntilWindowEnd(millis());
+    if (windowMs < waitMs) {
+        waitMs = windowMs;
+    }
+#endif
+    unlockStore();
+    return waitMs;
+}
+
+bool storeQueuedReadings() {
+    // Leituras tiradas da fila e ainda não avisadas à recepção, na ordem da fila
+    static uint32_t unreported = 0;
+    bool added = false;
+    ReadingFrame reading;
+    uint32_t now = uptimeSeconds();
+    
+    lockStore();
+    for (;;) {
+        // Flash recusando escritas: com a RAM da outbox cheia a leitura fica
+        // na fila (cheia, a recepção descarta sem confirmar) em vez de
+        // empurrar para fora uma leitura que o transmissor já deu como entregue
+        if (outbox.isMounted() && outbox.ramPendingCount() >= OUTBOX_RAM_RECORDS) {
+            break;
+        }
+        if (!readingQueue.pop(reading)) {
+            break;
+        }
+        unreported++;
+        added = true;
+#if AGGREGATION_MODE
+        // Leituras dentro dos limites só entram no resumo da janela
+        if (aggregator.add(reading, millis())) {
+            continue;
+        }
+#endif
+        outbox.append(reading, now);
+    }
+    
+    // Grava a leva no flash agora: em RAM ela se perderia num reboot. A
+    // recepção só confirma ao transmissor o que o flash aceitou; sem flash
+    // montado, a outbox em RAM é o que existe e a leitura é confirmada assim
+    bool persisted = outbox.flush();
+    if (unreported > 0 && (persisted || !outbox.isMounted())) {
+        loraReceiver.readingsStored(unreported);
+        unreported = 0;
+    }
+    metricOutboxPending.set(outbox.pendingCount());
+    metricOutboxRamDropped.set(outbox.ramDroppedCount());
+    metricOutboxWriteErrors.set(outbox.writeErrorCount());
+    
+#if AGGREGATION_MODE
+    if (aggregator.windowDue(millis())) {
+        aggregator.closeWindow(millis());
+        added = true;
+    }
+#endif
+    unlockStore();
+    return added;
+}
+
+void pollSerialCommands() {
+    // Lê uma linha de comando sem bloquear
+    static char command[SERIAL_COMMAND_SIZE];
+    static size_t length = 0;
+    
+    while (Serial.available() > 0) {
+        char c = (char)Serial.read();
+        if (c == '\r' || c == '\n') {
+            if (length > 0) {
+                command[length] = '\0';
+                runSerialCommand(command);
+                length = 0;
+            }
+        } else if (length < sizeof(command) - 1) {
+            command[length++] = c;
+        }
+    }
+}
+
+void runSerialCommand(const char *command) {
+    if (strcmp(command, "metrics") == 0) {
+        metricsSampleHeap();
+        metricsPrint(Serial);
+    } else if (strcmp(command, "bench") == 0) {
+        benchRun(Serial);
+    } else if (strcmp(command, "health") == 0) {
+        loraHealth.print(Serial);
+        networkHealth.print(Serial);
+        apiHealth.print(Serial);
+    } else {
+        Serial.printf("Comando desconhecido: %s (disponíveis: metrics, bench, health)\n", command);
+    }
+}
+
+uint32_t uptimeSeconds() {
+    return millis() / 1000;
 }
 
 void blinkLED(int times, int delayMs) {
+#if LED_STATUS == LORA_AUX_PIN
+    // O LED embutido divide o GPIO 2 com o AUX do E32, reservado para a
+    // interrupção de recepção (no polling ela só marca o fim do pacote)
+    (void)times;
+    (void)delayMs;
+#else
     for (int i = 0; i < times; i++) {
         digitalWrite(LED_STATUS, HIGH);
         delay(delayMs);
         digitalWrite(LED_STATUS, LOW);
         delay(delayMs);
     }
+#endif
 }
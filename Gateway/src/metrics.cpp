@@ -0,0 +1,163 @@
+#include "metrics.h"
+
+static Metric *metricsHead = nullptr;
+static Metric *metricsTail = nullptr;
+
+Metric::Metric(const char *name, MetricType type) : name(name), type(type), next(nullptr) {
+    // Registro na ordem de construção (a das definições abaixo)
+    if (metricsTail == nullptr) {
+        metricsHead = this;
+    } else {
+        metricsTail->next = this;
+    }
+    metricsTail = this;
+}
+
+MetricHistogram::MetricHistogram(const char *name)
+    : Metric(name, METRIC_HISTOGRAM), count(0), sum(0), max(0) {
+    for (size_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+        buckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void MetricHistogram::observe(uint32_t sample) {
+    // Balde = número de bits significativos (0 -> 0, 1 -> 1, 2-3 -> 2, ...)
+    size_t bucket = sample == 0 ? 0 : 32 - __builtin_clz(sample);
+    if (bucket >= METRICS_HISTOGRAM_BUCKETS) {
+        bucket = METRICS_HISTOGRAM_BUCKETS - 1;
+    }
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(sample, std::memory_order_relaxed);
+
+    uint32_t current = max.load(std::memory_order_relaxed);
+    while (sample > current && !max.compare_exchange_weak(current, sample, std::memory_order_relaxed)) {
+    }
+}
+
+uint32_t MetricHistogram::percentile(uint8_t percent) const {
+    uint32_t total = getCount();
+    if (total == 0) {
+        return 0;
+    }
+    uint32_t target = (uint32_t)(((uint64_t)total * percent + 99) / 100);
+    uint32_t seen = 0;
+    for (size_t i = 0; i < METRICS_HISTOGRAM_BUCKETS - 1; i++) {
+        seen += getBucket(i);
+        if (seen >= target) {
+            return i == 0 ? 0 : (1u << i) - 1;
+        }
+    }
+    return getMax();
+}
+
+// Definições (ordem do relatório)
+MetricCounter metricLoRaFrames("lora.frames");
+MetricCounter metricLoRaParseErrors("lora.parse_errors");
+MetricCounter metricLoRaDuplicates("lora.duplicates");
+MetricCounter metricLoRaRecoveries("lora.recoveries");
+MetricCounter metricLoRaDiscardedBytes("lora.discarded_bytes");
+MetricCounter metricLoRaMessages("lora.messages");
+MetricCounter metricLoRaMessagesLost("lora.messages_lost");
+MetricCounter metricLoRaAcks("lora.acks");
+MetricCounter metricLoRaAckErrors("lora.ack_errors");
+MetricCounter metricLoRaRxWakeups("lora.rx_wakeups");
+MetricHistogram metricLoRaRxCpuUs("lora.rx_cpu_us");
+MetricHistogram metricLoRaRxLatencyUs("lora.rx_latency_us");
+MetricCounter metricUartFifoOverflows("uart.fifo_overflows");
+MetricCounter metricUartBufferFull("uart.buffer_full");
+MetricCounter metricUartErrors("uart.errors");
+MetricGauge metricUartRxPeak("uart.rx_peak");
+MetricGauge metricQueueDepth("queue.depth");
+MetricGauge metricQueueDropped("queue.dropped");
+MetricGauge metricOutboxPending("outbox.pending");
+MetricGauge metricOutboxRamDropped("outbox.ram_dropped");
+MetricGauge metricOutboxWriteErrors("outbox.write_errors");
+MetricHistogram metricWiFiConnectMs("wifi.connect_ms");
+MetricCounter metricWiFiFailures("wifi.failures");
+MetricCounter metricWiFiResets("wifi.resets");
+MetricHistogram metricHttp2xxMs("http.2xx_ms");
+MetricHistogram metricHttp4xxMs("http.4xx_ms");
+MetricHistogram metricHttp5xxMs("http.5xx_ms");
+MetricHistogram metricHttpErrorMs("http.error_ms");
+MetricCounter metricMqttConnects("mqtt.connects");
+MetricHistogram metricMqttAckMs("mqtt.ack_ms");
+MetricCounter metricReadingsSent("uplink.readings_sent");
+MetricCounter metricReadingsRejected("uplink.readings_rejected");
+MetricCounter metricUplinkConfigErrors("uplink.config_errors");
+MetricGauge metricHeapFree("heap.free");
+MetricGauge metricHeapLargestBlock("heap.largest_block");
+
+void metricsObserveHttp(int httpResponseCode, uint32_t elapsedMs) {
+    if (httpResponseCode >= 200 && httpResponseCode < 300) {
+        metricHttp2xxMs.observe(elapsedMs);
+    } else if (httpResponseCode >= 400 && httpResponseCode < 500) {
+        metricHttp4xxMs.observe(elapsedMs);
+    } else if (httpResponseCode >= 500) {
+        metricHttp5xxMs.observe(elapsedMs);
+    } else {
+        metricHttpErrorMs.observe(elapsedMs);
+    }
+}
+
+void metricsSampleHeap() {
+    metricHeapFree.set(ESP.getFreeHeap());
+    metricHeapLargestBlock.set(ESP.getMaxAllocHeap());
+}
+
+void metricsPrint(Print &out) {
+    // Uma métrica por linha: "nome tipo valor", fácil de processar por script
+    out.printf("# metrics uptime_ms=%lu\n", millis());
+    for (Metric *metric = metricsHead; metric != nullptr; metric = metric->next) {
+        switch (metric->type) {
+            case METRIC_COUNTER:
+                out.printf("%s counter %lu\n", metric->name, (unsigned long)static_cast<MetricCounter *>(metric)->get());
+                break;
+            case METRIC_GAUGE:
+                out.printf("%s gauge %ld\n", metric->name, (long)static_cast<MetricGauge *>(metric)->get());
+                break;
+            case METRIC_HISTOGRAM: {
+                MetricHistogram *histogram = static_cast<MetricHistogram *>(metric);
+                out.printf("%s histogram count=%lu sum=%lu max=%lu p50=%lu p99=%lu buckets=", metric->name,
+                           (unsigned long)histogram->getCount(), (unsigned long)histogram->getSum(),
+                           (unsigned long)histogram->getMax(), (unsigned long)histogram->percentile(50),
+                           (unsigned long)histogram->percentile(99));
+                for (size_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+                    out.printf(i == 0 ? "%lu" : ",%lu", (unsigned long)histogram->getBucket(i));
+                }
+                out.printf("\n");
+                break;
+            }
+        }
+    }
+}
+
+void metricsToJSON(JsonDocument &doc) {
+    doc["uptime_ms"] = millis();
+    JsonObject counters = doc["counters"].to<JsonObject>();
+    JsonObject gauges = doc["gauges"].to<JsonObject>();
+    JsonObject histograms = doc["histograms"].to<JsonObject>();
+
+    for (Metric *metric = metricsHead; metric != nullptr; metric = metric->next) {
+        switch (metric->type) {
+            case METRIC_COUNTER:
+                counters[metric->name] = static_cast<MetricCounter *>(metric)->get();
+                break;
+            case METRIC_GAUGE:
+                gauges[metric->name] = static_cast<MetricGauge *>(metric)->get();
+                break;
+            case METRIC_HISTOGRAM: {
+                MetricHistogram *histogram = static_cast<MetricHistogram *>(metric);
+                JsonObject item = histograms[metric->name].to<JsonObject>();
+                item["count"] = histogram->getCount();
+                item["sum"] = histogram->getSum();
+                item["max"] = histogram->getMax();
+                JsonArray buckets = item["buckets"].to<JsonArray>();
+                for (size_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+                    buckets.add(histogram->getBucket(i));
+                }
+                break;
+            }
+        }
+    }
+}
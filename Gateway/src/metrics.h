@@ -0,0 +1,122 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <atomic>
+
+// Registro de métricas do Gateway: contadores, medidores (gauges) e
+// histogramas com baldes fixos em escala log2. Todas as atualizações são
+// atômicas (relaxed) e podem vir de qualquer tarefa sem travas. Cada
+// métrica se registra ao ser construída; as instâncias globais ficam em
+// metrics.cpp, na ordem em que aparecem no relatório.
+//
+// O relatório sai na Serial com o comando "metrics" e, com METRICS_PUSH=1,
+// é enviado em JSON para API_METRICS_ENDPOINT após cada rajada.
+
+#ifndef METRICS_PUSH
+#define METRICS_PUSH 0
+#endif
+#define METRICS_HISTOGRAM_BUCKETS 16    // Balde i: valores < 2^i (o último acumula o resto)
+
+enum MetricType {
+    METRIC_COUNTER,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM
+};
+
+class Metric {
+public:
+    const char *const name;
+    const MetricType type;
+    Metric *next;
+
+protected:
+    Metric(const char *name, MetricType type);
+};
+
+class MetricCounter : public Metric {
+private:
+    std::atomic<uint32_t> value;
+
+public:
+    explicit MetricCounter(const char *name) : Metric(name, METRIC_COUNTER), value(0) {}
+    void add(uint32_t amount = 1) { value.fetch_add(amount, std::memory_order_relaxed); }
+    uint32_t get() const { return value.load(std::memory_order_relaxed); }
+};
+
+class MetricGauge : public Metric {
+private:
+    std::atomic<int32_t> value;
+
+public:
+    explicit MetricGauge(const char *name) : Metric(name, METRIC_GAUGE), value(0) {}
+    void set(int32_t newValue) { value.store(newValue, std::memory_order_relaxed); }
+    int32_t get() const { return value.load(std::memory_order_relaxed); }
+};
+
+class MetricHistogram : public Metric {
+private:
+    std::atomic<uint32_t> buckets[METRICS_HISTOGRAM_BUCKETS];
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> sum;
+    std::atomic<uint32_t> max;
+
+public:
+    explicit MetricHistogram(const char *name);
+    void observe(uint32_t sample);
+    uint32_t getCount() const { return count.load(std::memory_order_relaxed); }
+    uint32_t getSum() const { return sum.load(std::memory_order_relaxed); }
+    uint32_t getMax() const { return max.load(std::memory_order_relaxed); }
+    uint32_t getBucket(size_t index) const { return buckets[index].load(std::memory_order_relaxed); }
+    // Limite superior aproximado do percentil (0-100), pelo balde
+    uint32_t percentile(uint8_t percent) const;
+};
+
+// Métricas do Gateway
+extern MetricCounter metricLoRaFrames;
+extern MetricCounter metricLoRaParseErrors;
+extern MetricCounter metricLoRaDuplicates;
+extern MetricCounter metricLoRaRecoveries;
+extern MetricCounter metricLoRaDiscardedBytes;
+extern MetricCounter metricLoRaMessages;
+extern MetricCounter metricLoRaMessagesLost;
+extern MetricCounter metricLoRaAcks;
+extern MetricCounter metricLoRaAckErrors;
+extern MetricCounter metricLoRaRxWakeups;
+extern MetricHistogram metricLoRaRxCpuUs;
+extern MetricHistogram metricLoRaRxLatencyUs;
+extern MetricCounter metricUartFifoOverflows;
+extern MetricCounter metricUartBufferFull;
+extern MetricCounter metricUartErrors;
+extern MetricGauge metricUartRxPeak;
+extern MetricGauge metricQueueDepth;
+extern MetricGauge metricQueueDropped;
+extern MetricGauge metricOutboxPending;
+extern MetricGauge metricOutboxRamDropped;
+extern MetricGauge metricOutboxWriteErrors;
+extern MetricHistogram metricWiFiConnectMs;
+extern MetricCounter metricWiFiFailures;
+extern MetricCounter metricWiFiResets;
+extern MetricHistogram metricHttp2xxMs;
+extern MetricHistogram metricHttp4xxMs;
+extern MetricHistogram metricHttp5xxMs;
+extern MetricHistogram metricHttpErrorMs;
+extern MetricCounter metricMqttConnects;
+extern MetricHistogram metricMqttAckMs;
+extern MetricCounter metricReadingsSent;
+extern MetricCounter metricReadingsRejected;
+extern MetricCounter metricUplinkConfigErrors;
+extern MetricGauge metricHeapFree;
+extern MetricGauge metricHeapLargestBlock;
+
+// Latência de uma requisição no histograma da classe do status
+void metricsObserveHttp(int httpResponseCode, uint32_t elapsedMs);
+
+// Atualiza os medidores de heap (os demais são atualizados por quem os mede)
+void metricsSampleHeap();
+
+void metricsPrint(Print &out);
+void metricsToJSON(JsonDocument &doc);
+
+#endif
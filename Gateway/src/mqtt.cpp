@@ -0,0 +1,190 @@
+#include "mqtt.h"
+#include <string.h>
+
+MqttClient::MqttClient() : transport(nullptr), packetId(0), keepAliveSeconds(0), sessionResumed(false),
+    lastActivity(0) {
+}
+
+int MqttClient::connect(Client &client, const char *host, uint16_t port, const char *clientId,
+                        const char *username, const char *password, uint16_t keepAlive,
+                        unsigned long timeoutMs) {
+    transport = &client;
+    keepAliveSeconds = keepAlive;
+    sessionResumed = false;
+    if (!transport->connect(host, port)) {
+        return -1;
+    }
+
+    // Sessão persistente: o broker guarda a sessão entre conexões
+    uint8_t flags = 0;
+    size_t remaining = 10 + 2 + strlen(clientId);
+    if (username != nullptr) {
+        flags |= 0x80;
+        remaining += 2 + strlen(username);
+    }
+    if (password != nullptr) {
+        flags |= 0x40;
+        remaining += 2 + strlen(password);
+    }
+    static const uint8_t protocol[] = { 0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04 };
+    bool ok = writeHeader(MQTT_PACKET_CONNECT, remaining) && writeBytes(protocol, sizeof(protocol)) &&
+              writeBytes(&flags, 1) && writeU16(keepAlive) && writeString(clientId) &&
+              (username == nullptr || writeString(username)) && (password == nullptr || writeString(password));
+    if (!ok) {
+        transport->stop();
+        return -1;
+    }
+
+    uint8_t type;
+    uint8_t body[MQTT_READ_BUFFER_SIZE];
+    size_t length;
+    if (!readPacket(type, body, sizeof(body), length, timeoutMs) || type != MQTT_PACKET_CONNACK || length != 2) {
+        transport->stop();
+        return -1;
+    }
+    if (body[1] != 0) {
+        transport->stop();
+        return body[1];
+    }
+    sessionResumed = (body[0] & 0x01) != 0;
+    lastActivity = millis();
+    return 0;
+}
+
+bool MqttClient::connected() {
+    if (transport == nullptr || !transport->connected()) {
+        return false;
+    }
+    // Sem tráfego por 1,5x o keep-alive o broker já fechou a sessão
+    return keepAliveSeconds == 0 || idleMs() < (unsigned long)keepAliveSeconds * 1500;
+}
+
+void MqttClient::disconnect() {
+    if (transport == nullptr) {
+        return;
+    }
+    // DISCONNECT limpo: o broker mantém a sessão, mas descarta o will
+    if (transport->connected()) {
+        writeHeader(MQTT_PACKET_DISCONNECT, 0);
+    }
+    transport->stop();
+    transport = nullptr;
+}
+
+uint16_t MqttClient::nextPacketId() {
+    // 0 não é um packet id válido
+    if (++packetId == 0) {
+        packetId = 1;
+    }
+    return packetId;
+}
+
+bool MqttClient::publish(const char *topic, const uint8_t *payload, size_t length, uint16_t id, bool duplicate) {
+    if (transport == nullptr) {
+        return false;
+    }
+    uint8_t type = MQTT_PACKET_PUBLISH | MQTT_PUBLISH_QOS1 | (duplicate ? MQTT_PUBLISH_DUP : 0);
+    size_t remaining = 2 + strlen(topic) + 2 + length;
+    bool ok = writeHeader(type, remaining) && writeString(topic) && writeU16(id) && writeBytes(payload, length);
+    if (ok) {
+        lastActivity = millis();
+    }
+    return ok;
+}
+
+bool MqttClient::waitAck(uint16_t &id, unsigned long timeoutMs) {
+    unsigned long start = millis();
+    for (;;) {
+        unsigned long elapsed = millis() - start;
+        if (elapsed >= timeoutMs) {
+            return false;
+        }
+
+        uint8_t type;
+        uint8_t body[MQTT_READ_BUFFER_SIZE];
+        size_t length;
+        if (!readPacket(type, body, sizeof(body), length, timeoutMs - elapsed)) {
+            return false;
+        }
+        lastActivity = millis();
+        if ((type & 0xF0) == MQTT_PACKET_PUBACK && length == 2) {
+            id = (uint16_t)((body[0] << 8) | body[1]);
+            return true;
+        }
+        // PINGRESP ou outros pacotes: ignora e continua esperando
+    }
+}
+
+bool MqttClient::writeHeader(uint8_t type, size_t remainingLength) {
+    // Tamanho restante em base 128, até 4 bytes
+    uint8_t header[MQTT_HEADER_MAX_SIZE];
+    size_t length = 0;
+    header[length++] = type;
+    do {
+        uint8_t digit = remainingLength % 128;
+        remainingLength /= 128;
+        if (remainingLength > 0) {
+            digit |= 0x80;
+        }
+        header[length++] = digit;
+    } while (remainingLength > 0 && length < sizeof(header));
+    return writeBytes(header, length);
+}
+
+bool MqttClient::writeString(const char *text) {
+    size_t length = strlen(text);
+    return writeU16((uint16_t)length) && writeBytes((const uint8_t *)text, length);
+}
+
+bool MqttClient::writeU16(uint16_t value) {
+    uint8_t bytes[2] = { (uint8_t)(value >> 8), (uint8_t)value };
+    return writeBytes(bytes, sizeof(bytes));
+}
+
+bool MqttClient::writeBytes(const uint8_t *data, size_t length) {
+    return length == 0 || transport->write(data, length) == length;
+}
+
+int MqttClient::readByte(unsigned long deadline) {
+    while (transport->available() <= 0) {
+        if (!transport->connected() || (long)(millis() - deadline) >= 0) {
+            return -1;
+        }
+        delay(1);
+    }
+    return transport->read();
+}
+
+bool MqttClient::readPacket(uint8_t &type, uint8_t *body, size_t capacity, size_t &length,
+                            unsigned long timeoutMs) {
+    unsigned long deadline = millis() + timeoutMs;
+    int byte = readByte(deadline);
+    if (byte < 0) {
+        return false;
+    }
+    type = (uint8_t)byte;
+
+    size_t remaining = 0;
+    for (int shift = 0; shift < 28; shift += 7) {
+        byte = readByte(deadline);
+        if (byte < 0) {
+            return false;
+        }
+        remaining |= (size_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            break;
+        }
+    }
+
+    length = remaining;
+    for (size_t i = 0; i < remaining; i++) {
+        byte = readByte(deadline);
+        if (byte < 0) {
+            return false;
+        }
+        if (i < capacity) {
+            body[i] = (uint8_t)byte;
+        }
+    }
+    return true;
+}
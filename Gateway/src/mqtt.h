@@ -0,0 +1,63 @@
+#ifndef MQTT_H
+#define MQTT_H
+
+#include <Arduino.h>
+#include <Client.h>
+
+// Cliente MQTT 3.1.1 mínimo para o uplink (UPLINK_PROTOCOL=1), sem alocação.
+// Só publica: CONNECT com sessão persistente (clean session = 0), PUBLISH
+// QoS 1 com vários pacotes em voo e espera dos PUBACKs, e DISCONNECT. Não
+// assina tópicos, então PUBLISH vindos do broker são ignorados.
+
+#define MQTT_PACKET_CONNECT 0x10
+#define MQTT_PACKET_CONNACK 0x20
+#define MQTT_PACKET_PUBLISH 0x30
+#define MQTT_PACKET_PUBACK 0x40
+#define MQTT_PACKET_PINGREQ 0xC0
+#define MQTT_PACKET_PINGRESP 0xD0
+#define MQTT_PACKET_DISCONNECT 0xE0
+
+#define MQTT_PUBLISH_DUP 0x08
+#define MQTT_PUBLISH_QOS1 0x02
+#define MQTT_HEADER_MAX_SIZE 5      // Tipo + até 4 bytes de tamanho restante
+#define MQTT_READ_BUFFER_SIZE 16    // Maior pacote lido por inteiro (CONNACK, PUBACK)
+
+class MqttClient {
+private:
+    Client *transport;
+    uint16_t packetId;
+    uint16_t keepAliveSeconds;
+    bool sessionResumed;
+    unsigned long lastActivity;
+
+public:
+    MqttClient();
+
+    // Abre o socket e a sessão; retorna o código do CONNACK (0 = aceito) ou
+    // -1 se a conexão TCP ou o handshake falharem
+    int connect(Client &client, const char *host, uint16_t port, const char *clientId, const char *username,
+                const char *password, uint16_t keepAlive, unsigned long timeoutMs);
+    bool connected();
+    bool isOpen() const { return transport != nullptr; }
+    void disconnect();
+    // O broker ainda tinha a sessão anterior (CONNACK com session present)
+    bool sessionPresent() const { return sessionResumed; }
+    unsigned long idleMs() const { return millis() - lastActivity; }
+
+    uint16_t nextPacketId();
+    // Envia um PUBLISH QoS 1 sem esperar o PUBACK
+    bool publish(const char *topic, const uint8_t *payload, size_t length, uint16_t id, bool duplicate);
+    // Espera o próximo PUBACK; false no timeout ou se a conexão cair
+    bool waitAck(uint16_t &id, unsigned long timeoutMs);
+
+private:
+    bool writeHeader(uint8_t type, size_t remainingLength);
+    bool writeString(const char *text);
+    bool writeU16(uint16_t value);
+    bool writeBytes(const uint8_t *data, size_t length);
+    int readByte(unsigned long deadline);
+    // Lê um pacote; corpos maiores que capacity são descartados
+    bool readPacket(uint8_t &type, uint8_t *body, size_t capacity, size_t &length, unsigned long timeoutMs);
+};
+
+#endif
@@ -1,112 +1,853 @@
 #include "network.h"
+#include "log.h"
+#include "metrics.h"
 
-NetworkManager::NetworkManager() : isWiFiConnected(false), connectionStartTime(0) {
-    // Construtor
+NetworkManager::NetworkManager() : isWiFiConnected(false), connectionStartTime(0), batchSupported(true),
+    configError(0), connectionsOpened(0), completions(nullptr),
+    cborEnabled(API_UPLINK_FORMAT != UPLINK_FORMAT_JSON), cborConfirmed(API_UPLINK_FORMAT == UPLINK_FORMAT_CBOR),
+    compressionEnabled(UPLINK_COMPRESSION != 0), compressorLock(nullptr), cacheValid(false), lastBurstTime(0),
+    burstInterval(0) {
+    memset(&cache, 0, sizeof(cache));
+    memset(&wifiStats, 0, sizeof(wifiStats));
+    memset(&compressionStats, 0, sizeof(compressionStats));
+    for (size_t i = 0; i < UPLINK_CONNECTIONS; i++) {
+        // Sem validação de certificado, como o HTTPClient fazia com http.begin(url)
+        connections[i].secureClient.setInsecure();
+        connections[i].http.setReuse(true);
+        connections[i].lastRequestTime = 0;
+        workers[i].manager = this;
+        workers[i].index = (uint8_t)i;
+        workers[i].task = nullptr;
+    }
+#if UPLINK_PROTOCOL == UPLINK_PROTOCOL_MQTT
+    inflightCount = 0;
+#endif
+}
+
+void NetworkManager::begin() {
+    if (UPLINK_PIPELINE_DEPTH == 1) {
+        return;
+    }
+    
+    // Conexão 0 é da tarefa de uplink; cada conexão extra tem sua tarefa
+    compressorLock = xSemaphoreCreateMutex();
+    completions = xQueueCreate(UPLINK_CONNECTIONS, sizeof(uint8_t));
+    for (size_t i = 1; i < UPLINK_PIPELINE_DEPTH; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "uplink_%u", (unsigned)i);
+        xTaskCreatePinnedToCore(workerTask, name, UPLINK_WORKER_STACK, &workers[i], UPLINK_WORKER_PRIORITY,
+                                &workers[i].task, UPLINK_WORKER_CORE);
+    }
+    LOG_INFO("[NETWORK] Pool de uplink com %u conexões", (unsigned)UPLINK_PIPELINE_DEPTH);
+}
+
+void NetworkManager::workerTask(void *parameter) {
+    UplinkWorker *worker = static_cast<UplinkWorker *>(parameter);
+    NetworkManager *manager = worker->manager;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        UplinkRequest &request = manager->requests[worker->index];
+        request.processed = manager->sendBatch(manager->connections[worker->index], request.items, request.count,
+                                               request.delivered);
+        xQueueSend(manager->completions, &worker->index, portMAX_DELAY);
+    }
 }
 
 bool NetworkManager::connectWiFi() {
-    Serial.println("\n[NETWORK] Conectando ao WiFi...");
-    Serial.println("SSID: " + String(WIFI_SSID));
+    noteBurst();
     
+    // O link pode ter ficado ligado desde a rajada anterior
+    if (isWiFiConnected && WiFi.status() == WL_CONNECTED) {
+        wifiStats.reusedLinks++;
+        LOG_DEBUG("[NETWORK] WiFi já conectado, link reaproveitado");
+        return true;
+    }
+    isWiFiConnected = false;
     connectionStartTime = millis();
     
-    // Inicia conexão WiFi
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    // Sem regravar a credencial no flash a cada conexão
+    WiFi.persistent(false);
+    WiFi.mode(WIFI_STA);
+    
+    bool fast = false;
+#if WIFI_FAST_CONNECT
+    if (loadCache()) {
+        // Caminho rápido: canal e BSSID conhecidos, sem busca nem DHCP
+        LOG_INFO("[NETWORK] Conexão rápida ao WiFi (SSID: %s, canal %d)...", WIFI_SSID, (int)cache.channel);
+#if WIFI_CACHE_IP
+        WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.subnet), IPAddress(cache.dns));
+#endif
+        WiFi.begin(WIFI_SSID, WIFI_PASSWORD, cache.channel, cache.bssid);
+        fast = waitForConnection(WIFI_FAST_TIMEOUT_MS);
+        
+        if (!fast) {
+            LOG_WARN("[NETWORK] Conexão rápida falhou, fazendo busca completa");
+            WiFi.disconnect();
+#if WIFI_CACHE_IP
+            // Volta ao DHCP
+            WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
+#endif
+            cacheValid = false;
+        }
+    }
+#endif
     
-    // Aguarda conexão com timeout
-    while (WiFi.status() != WL_CONNECTED && !isConnectionTimeout()) {
-        delay(500);
-        Serial.print(".");
+    if (!fast) {
+        LOG_INFO("[NETWORK] Conectando ao WiFi (SSID: %s)...", WIFI_SSID);
+        WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+        waitForConnection(WIFI_TIMEOUT_MS);
     }
     
+    unsigned long elapsed = millis() - connectionStartTime;
     if (WiFi.status() == WL_CONNECTED) {
         isWiFiConnected = true;
-        Serial.println("\n✅ WiFi conectado com sucesso!");
-        Serial.println("IP: " + WiFi.localIP().toString());
-        Serial.println("Signal: " + String(WiFi.RSSI()) + " dBm");
+        if (fast) {
+            wifiStats.fastConnects++;
+        } else {
+            wifiStats.fullConnects++;
+        }
+        wifiStats.lastConnectMs = elapsed;
+        metricWiFiConnectMs.observe(elapsed);
+        wifiStats.totalConnectMs += elapsed;
+        if (elapsed > wifiStats.maxConnectMs) {
+            wifiStats.maxConnectMs = elapsed;
+        }
+        
+        IPAddress ip = WiFi.localIP();
+        LOG_INFO("✅ WiFi conectado em %lu ms (%s)", elapsed, fast ? "rápida" : "completa");
+        LOG_INFO("IP: %u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+        LOG_DEBUG("Signal: %d dBm", WiFi.RSSI());
+        
+#if WIFI_FAST_CONNECT
+        saveCache();
+#endif
         return true;
     } else {
-        isWiFiConnected = false;
-        Serial.println("\n❌ Falha na conexão WiFi (timeout)!");
+        wifiStats.failures++;
+        metricWiFiFailures.add();
+        WiFi.disconnect(true);
+        LOG_ERROR("❌ Falha na conexão WiFi (timeout após %lu ms)!", elapsed);
+        return false;
+    }
+}
+
+bool NetworkManager::waitForConnection(unsigned long timeoutMs) {
+    unsigned long start = millis();
+    for (;;) {
+        wl_status_t status = WiFi.status();
+        if (status == WL_CONNECTED) {
+            return true;
+        }
+        if (status == WL_CONNECT_FAILED || (millis() - start) >= timeoutMs) {
+            return false;
+        }
+        delay(WIFI_POLL_INTERVAL_MS);
+    }
+}
+
+void NetworkManager::noteBurst() {
+    // Média móvel (peso 1/4) do intervalo entre o início das rajadas
+    unsigned long now = millis();
+    if (lastBurstTime != 0) {
+        unsigned long interval = now - lastBurstTime;
+        burstInterval = burstInterval == 0 ? interval : (burstInterval * 3 + interval) / 4;
+    }
+    lastBurstTime = now;
+}
+
+void NetworkManager::finishBurst() {
+    // Rajadas frequentes: manter o link custa menos que reconectar
+    if (burstInterval != 0 && burstInterval < WIFI_KEEP_UP_INTERVAL_MS) {
+        LOG_DEBUG("[NETWORK] Rajadas a cada ~%lu ms, mantendo WiFi ligado", burstInterval);
+        return;
+    }
+    disconnectWiFi();
+}
+
+bool NetworkManager::loadCache() {
+    if (cacheValid) {
+        return true;
+    }
+    
+    Preferences prefs;
+    if (!prefs.begin("wifi", true)) {
         return false;
     }
+    size_t length = prefs.getBytes("cache", &cache, sizeof(cache));
+    prefs.end();
+    
+    uint16_t ssidHash = frameCRC16((const uint8_t *)WIFI_SSID, strlen(WIFI_SSID));
+    cacheValid = length == sizeof(cache) && cache.ssidHash == ssidHash && cache.channel > 0;
+    return cacheValid;
+}
+
+void NetworkManager::saveCache() {
+    WiFiCache current;
+    memset(&current, 0, sizeof(current));
+    memcpy(current.bssid, WiFi.BSSID(), sizeof(current.bssid));
+    current.channel = WiFi.channel();
+    current.ip = (uint32_t)WiFi.localIP();
+    current.gateway = (uint32_t)WiFi.gatewayIP();
+    current.subnet = (uint32_t)WiFi.subnetMask();
+    current.dns = (uint32_t)WiFi.dnsIP(0);
+    current.ssidHash = frameCRC16((const uint8_t *)WIFI_SSID, strlen(WIFI_SSID));
+    
+    // Só grava no NVS quando algo mudou
+    if (cacheValid && memcmp(&current, &cache, sizeof(cache)) == 0) {
+        return;
+    }
+    
+    Preferences prefs;
+    if (prefs.begin("wifi", false)) {
+        prefs.putBytes("cache", &current, sizeof(current));
+        prefs.end();
+        cache = current;
+        cacheValid = true;
+        LOG_DEBUG("[NETWORK] Cache do WiFi atualizado (canal %d)", (int)current.channel);
+    }
 }
 
 bool NetworkManager::sendDataToAPI(const ReceivedData &data) {
+    int httpResponseCode = postReading(connections[0], data);
+    return httpResponseCode >= 200 && httpResponseCode < 300;
+}
+
+int NetworkManager::postReading(UplinkConnection &connection, const ReceivedData &data) {
     if (!isWiFiConnected) {
-        Serial.println("ERRO: WiFi não conectado!");
+        LOG_ERROR("ERRO: WiFi não conectado!");
+        return HTTPC_ERROR_NOT_CONNECTED;
+    }
+    
+    if (cborEnabled) {
+        size_t length = createReadingsCBOR(&data, 1, false, connection.cborBuffer, sizeof(connection.cborBuffer));
+        int httpResponseCode = postBody(connection, API_ENDPOINT, CBOR_CONTENT_TYPE, connection.cborBuffer, length,
+                                        nullptr);
+        if (!isCBORRejected(httpResponseCode)) {
+            return httpResponseCode;
+        }
+    }
+    return postJSON(connection, API_ENDPOINT, createReadingJSON(data), nullptr);
+}
+
+int NetworkManager::postBatch(UplinkConnection &connection, const ReceivedData *items, size_t count,
+                              String *response) {
+    if (cborEnabled) {
+        size_t length = createReadingsCBOR(items, count, true, connection.cborBuffer, sizeof(connection.cborBuffer));
+        int httpResponseCode = postBody(connection, API_BATCH_ENDPOINT, CBOR_CONTENT_TYPE, connection.cborBuffer,
+                                        length, response);
+        if (!isCBORRejected(httpResponseCode)) {
+            return httpResponseCode;
+        }
+    }
+    return postJSON(connection, API_BATCH_ENDPOINT, createBatchJSON(items, count), response);
+}
+
+bool NetworkManager::isCBORRejected(int httpResponseCode) {
+    // No modo automático, o primeiro POST em CBOR sonda o servidor
+    if (cborConfirmed) {
         return false;
     }
+    if (httpResponseCode >= 200 && httpResponseCode < 300) {
+        cborConfirmed = true;
+        LOG_INFO("[NETWORK] Servidor aceita CBOR, usando envio binário");
+        return false;
+    }
+    if (httpResponseCode == 400 || httpResponseCode == 415 || httpResponseCode == 422) {
+        LOG_WARN("[NETWORK] Servidor recusou CBOR (HTTP %d), voltando para JSON", httpResponseCode);
+        cborEnabled = false;
+        return true;
+    }
+    return false;
+}
+
+// Resposta definitiva do servidor: aceita (2xx) ou recusada por causa do
+// próprio registro (400, 413, 422), que reenviado seria recusado de novo.
+// Todo o resto fica na outbox: erros de transporte, 408, 429 e 5xx são
+// temporários, 401/403/404 são erro de configuração e os demais 4xx não
+// dizem nada sobre o registro
+static bool isFinalResponse(int httpResponseCode) {
+    return (httpResponseCode >= 200 && httpResponseCode < 300) || httpResponseCode == 400 ||
+           httpResponseCode == 413 || httpResponseCode == 422;
+}
+
+// Chave da API, permissão ou endpoint errados: nenhum registro passaria
+static bool isConfigError(int httpResponseCode) {
+    return httpResponseCode == 401 || httpResponseCode == 403 || httpResponseCode == 404;
+}
+
+static void reportConfigError(std::atomic<int> &configError, int httpResponseCode) {
+    metricUplinkConfigErrors.add();
+    if (configError.exchange(httpResponseCode) == 0) {
+        LOG_ERROR("[NETWORK] API recusou o Gateway (HTTP %d): confira API_KEY e API_ENDPOINT, leituras mantidas",
+                  httpResponseCode);
+    }
+}
+
+// Marca como respondidas as primeiras processed leituras
+static size_t markAnswered(bool *answered, size_t processed) {
+    for (size_t i = 0; i < processed; i++) {
+        answered[i] = true;
+    }
+    return processed;
+}
+
+size_t NetworkManager::sendBatchToAPI(const ReceivedData *items, size_t count, bool *delivered, bool *answered) {
+    for (size_t i = 0; i < count; i++) {
+        delivered[i] = false;
+        answered[i] = false;
+    }
+    configError = 0;
     
-    Serial.println("\n[NETWORK] Enviando dados para API...");
+    if (!isWiFiConnected) {
+        LOG_ERROR("ERRO: WiFi não conectado!");
+        return 0;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    if (count > UPLINK_WINDOW_SIZE) {
+        count = UPLINK_WINDOW_SIZE;
+    }
+#if UPLINK_PROTOCOL == UPLINK_PROTOCOL_MQTT
+    return markAnswered(answered, publishBatch(items, count, delivered));
+#endif
+    if (count <= UPLINK_BATCH_SIZE) {
+        return markAnswered(answered, sendBatch(connections[0], items, count, delivered));
+    }
+    return dispatchBatches(items, count, delivered, answered);
+}
+
+size_t NetworkManager::dispatchBatches(const ReceivedData *items, size_t count, bool *delivered, bool *answered) {
+    // Um lote por conexão: o primeiro vai pela própria tarefa de uplink, os
+    // outros pelas tarefas do pool, todos ao mesmo tempo
+    size_t batches = 0;
+    for (size_t start = 0; start < count && batches < UPLINK_PIPELINE_DEPTH; start += UPLINK_BATCH_SIZE) {
+        if (batches > 0 && ESP.getFreeHeap() < UPLINK_MIN_FREE_HEAP) {
+            LOG_WARN("[NETWORK] Heap livre baixo (%u bytes), só %u lote(s) em paralelo", ESP.getFreeHeap(), batches);
+            break;
+        }
+        UplinkRequest &request = requests[batches];
+        request.items = items + start;
+        request.delivered = delivered + start;
+        request.count = count - start < UPLINK_BATCH_SIZE ? count - start : UPLINK_BATCH_SIZE;
+        request.processed = 0;
+        if (batches > 0) {
+            xTaskNotifyGive(workers[batches].task);
+        }
+        batches++;
+    }
     
-    // Cria JSON para API
-    String jsonPayload = createAPIJSON(data);
+    requests[0].processed = sendBatch(connections[0], requests[0].items, requests[0].count, requests[0].delivered);
+    for (size_t i = 1; i < batches; i++) {
+        uint8_t index;
+        xQueueReceive(completions, &index, portMAX_DELAY);
+    }
     
-    Serial.println("JSON para API: " + jsonPayload);
+    // Cada lote responde pelo seu início contínuo; a outbox confirma fora de
+    // ordem, então um lote incompleto não faz os seguintes serem reenviados
+    size_t processed = 0;
+    for (size_t i = 0; i < batches; i++) {
+        processed += markAnswered(answered + (requests[i].items - items), requests[i].processed);
+    }
+    LOG_DEBUG("[NETWORK] %u lote(s) em paralelo: %u/%u leituras concluídas", batches, processed, count);
+    return processed;
+}
+
+size_t NetworkManager::sendBatch(UplinkConnection &connection, const ReceivedData *items, size_t count,
+                                 bool *delivered) {
+    if (!batchSupported || count == 1) {
+        return sendEachToAPI(connection, items, count, delivered);
+    }
     
-    // Configura HTTPClient
-    HTTPClient http;
-    http.begin(API_ENDPOINT);
-    http.addHeader("Content-Type", "application/json");
-    http.addHeader("x-api-key", API_KEY);
-    http.setTimeout(HTTP_TIMEOUT_MS);
+    String response;
+    int httpResponseCode = postBatch(connection, items, count, &response);
     
-    // Requisicao completa
-    Serial.println("Requisicao completa");
-    Serial.println("Endpoint: " + String(API_ENDPOINT));
-    Serial.println("API Key: " + String(API_KEY));
-    Serial.println("Timeout: " + String(HTTP_TIMEOUT_MS) + " ms");
+    if (httpResponseCode == 404 || httpResponseCode == 405 || httpResponseCode == 415 || httpResponseCode == 501) {
+        // Servidor sem suporte a lotes: passa a enviar item a item. Se o
+        // endpoint individual também der 404, o erro é de configuração e
+        // os lotes voltam a valer quando ela for corrigida
+        LOG_WARN("[NETWORK] Lote recusado (HTTP %d), usando envio individual", httpResponseCode);
+        batchSupported = false;
+        size_t processed = sendEachToAPI(connection, items, count, delivered);
+        if (configError.load() == 404) {
+            batchSupported = true;
+        }
+        return processed;
+    }
+    if (httpResponseCode == 400 || httpResponseCode == 413 || httpResponseCode == 422) {
+        // Lote recusado inteiro: item a item, só os registros ruins são descartados
+        LOG_WARN("[NETWORK] Lote recusado (HTTP %d), reenviando item a item", httpResponseCode);
+        return sendEachToAPI(connection, items, count, delivered);
+    }
+    if (isConfigError(httpResponseCode)) {
+        reportConfigError(configError, httpResponseCode);
+        return 0;
+    }
+    if (!isFinalResponse(httpResponseCode)) {
+        return 0;
+    }
+    
+    // Resultado por item quando o servidor informa; senão o lote inteiro foi aceito
+    size_t processed = count;
+    if (!parseBatchResponse(response, count, delivered, &processed)) {
+        for (size_t i = 0; i < count; i++) {
+            delivered[i] = true;
+        }
+        processed = count;
+    }
+    
+    size_t accepted = 0;
+    for (size_t i = 0; i < processed; i++) {
+        if (delivered[i]) accepted++;
+    }
+    LOG_INFO("[NETWORK] Lote: %u/%u leituras aceitas", accepted, count);
+    return processed;
+}
 
-    // Envia POST request
-    Serial.println("Enviando POST para: " + String(API_ENDPOINT));
-    int httpResponseCode = http.POST(jsonPayload);
+size_t NetworkManager::sendEachToAPI(UplinkConnection &connection, const ReceivedData *items, size_t count,
+                                     bool *delivered) {
+    // Para na primeira resposta que não seja definitiva: o restante continua pendente
+    for (size_t i = 0; i < count; i++) {
+        int httpResponseCode = postReading(connection, items[i]);
+        if (!isFinalResponse(httpResponseCode)) {
+            if (isConfigError(httpResponseCode)) {
+                reportConfigError(configError, httpResponseCode);
+            }
+            return i;
+        }
+        delivered[i] = httpResponseCode >= 200 && httpResponseCode < 300;
+    }
+    return count;
+}
+
+#if UPLINK_PROTOCOL == UPLINK_PROTOCOL_MQTT
+bool NetworkManager::connectMqtt() {
+    if (mqtt.connected()) {
+        return true;
+    }
+    // Socket morto ou sessão expirada no broker: reconecta
+    mqtt.disconnect();
     
-    // Verifica resposta
-    if (httpResponseCode > 0) {
-        String response = http.getString();
-        Serial.println("Código HTTP: " + String(httpResponseCode));
-        Serial.println("Resposta da API: " + response);
+#ifdef MQTT_CLIENT_ID
+    const char *clientId = MQTT_CLIENT_ID;
+#else
+    char clientId[MQTT_CLIENT_ID_SIZE];
+    snprintf(clientId, sizeof(clientId), "vitalsync-gw-%012llx", (unsigned long long)ESP.getEfuseMac());
+#endif
+    
+    unsigned long start = millis();
+    int result = mqtt.connect(mqttTransport, MQTT_HOST, MQTT_PORT, clientId, MQTT_USERNAME, API_KEY,
+                              MQTT_KEEPALIVE_S, MQTT_TIMEOUT_MS);
+    if (result != 0) {
+        LOG_ERROR("❌ Falha ao conectar ao broker MQTT %s:%d (%d)", MQTT_HOST, MQTT_PORT, result);
+        return false;
+    }
+    connectionsOpened++;
+    metricMqttConnects.add();
+    
+    // Sessão nova: o broker esqueceu os PUBLISH em voo, os ids antigos não valem mais
+    if (!mqtt.sessionPresent()) {
+        inflightCount = 0;
+    }
+    LOG_INFO("✅ Broker MQTT conectado em %lu ms (sessão %s)", millis() - start,
+             mqtt.sessionPresent() ? "retomada" : "nova");
+    return true;
+}
+
+uint16_t NetworkManager::inflightPacketId(uint32_t payloadCRC, bool &duplicate) {
+    for (size_t i = 0; i < inflightCount; i++) {
+        if (inflight[i].payloadCRC == payloadCRC) {
+            duplicate = true;
+            return inflight[i].packetId;
+        }
+    }
+    duplicate = false;
+    return mqtt.nextPacketId();
+}
+
+size_t NetworkManager::publishBatch(const ReceivedData *items, size_t count, bool *delivered) {
+    if (!connectMqtt()) {
+        return 0;
+    }
+    
+    // Uma mensagem por sequência de leituras do mesmo transmissor, todas em
+    // voo ao mesmo tempo; os PUBACKs vêm depois
+    size_t runEnd[MQTT_MAX_INFLIGHT];
+    bool runAcked[MQTT_MAX_INFLIGHT];
+    MqttInflight published[MQTT_MAX_INFLIGHT];
+    size_t runCount = 0;
+    size_t start = 0;
+    unsigned long publishStart = millis();
+    while (start < count && runCount < MQTT_MAX_INFLIGHT) {
+        size_t end = start + 1;
+        while (end < count && items[end].device_addr == items[start].device_addr) {
+            end++;
+        }
         
-        if (httpResponseCode >= 200 && httpResponseCode < 300) {
-            Serial.println("✅ Dados enviados com sucesso para API!");
-            http.end();
-            return true;
+        char deviceId[DEVICE_ID_SIZE];
+        char topic[MQTT_TOPIC_SIZE];
+        formatDeviceId(items[start].device_addr, deviceId, sizeof(deviceId));
+        snprintf(topic, sizeof(topic), "%s/%s", MQTT_TOPIC_PREFIX, deviceId);
+        
+        String json;
+        uint8_t *cborBuffer = connections[0].cborBuffer;
+        const uint8_t *body = cborBuffer;
+        size_t length = 0;
+        if (API_UPLINK_FORMAT == UPLINK_FORMAT_CBOR) {
+            length = createReadingsCBOR(items + start, end - start, true, cborBuffer, sizeof(connections[0].cborBuffer));
         } else {
-            Serial.println("❌ Erro HTTP da API: " + String(httpResponseCode));
+            json = createBatchJSON(items + start, end - start);
+            body = (const uint8_t *)json.c_str();
+            length = json.length();
+        }
+        
+        uint32_t payloadCRC = gzipCRC32(body, length);
+        bool duplicate;
+        uint16_t packetId = inflightPacketId(payloadCRC, duplicate);
+        if (!mqtt.publish(topic, body, length, packetId, duplicate)) {
+            LOG_WARN("[NETWORK] Falha ao publicar em " MQTT_TOPIC_PREFIX "/TR-%03u", items[start].device_addr);
+            break;
+        }
+        LOG_DEBUG("[NETWORK] PUBLISH " MQTT_TOPIC_PREFIX "/TR-%03u id=%u (%u bytes%s)", items[start].device_addr, packetId, length, duplicate ? ", DUP" : "");
+        
+        published[runCount].packetId = packetId;
+        published[runCount].payloadCRC = payloadCRC;
+        runEnd[runCount] = end;
+        runAcked[runCount] = false;
+        runCount++;
+        start = end;
+    }
+    
+    size_t pendingAcks = runCount;
+    while (pendingAcks > 0) {
+        uint16_t packetId;
+        if (!mqtt.waitAck(packetId, MQTT_TIMEOUT_MS)) {
+            break;
+        }
+        for (size_t i = 0; i < runCount; i++) {
+            if (!runAcked[i] && published[i].packetId == packetId) {
+                runAcked[i] = true;
+                pendingAcks--;
+                break;
+            }
+        }
+    }
+    metricMqttAckMs.observe(millis() - publishStart);
+    
+    // Os sem PUBACK ficam em voo: se voltarem da outbox, vão com o mesmo id
+    inflightCount = 0;
+    for (size_t i = 0; i < runCount; i++) {
+        if (!runAcked[i]) {
+            inflight[inflightCount++] = published[i];
+        }
+    }
+    if (pendingAcks > 0) {
+        LOG_WARN("[NETWORK] %u PUBACK(s) não chegaram, reconectando no próximo envio", pendingAcks);
+        mqtt.disconnect();
+    }
+    
+    // Só sai da outbox o início do lote com todas as mensagens confirmadas
+    size_t confirmed = 0;
+    for (size_t i = 0; i < runCount && runAcked[i]; i++) {
+        confirmed = runEnd[i];
+    }
+    for (size_t i = 0; i < confirmed; i++) {
+        delivered[i] = true;
+    }
+    LOG_INFO("[NETWORK] MQTT: %u/%u leituras confirmadas (%u mensagens, %lu ms)", confirmed, count, runCount,
+             millis() - publishStart);
+    return confirmed;
+}
+#endif
+
+size_t NetworkManager::sendSummariesToAPI(const AggregateSummary *summaries, size_t count) {
+    if (!isWiFiConnected) {
+        LOG_ERROR("ERRO: WiFi não conectado!");
+        return 0;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    
+    // Mesma regra das leituras: só sai da fila o que teve resposta definitiva
+    configError = 0;
+    int httpResponseCode = postJSON(connections[0], API_SUMMARY_ENDPOINT, createSummaryJSON(summaries, count),
+                                    nullptr);
+    if (!isFinalResponse(httpResponseCode)) {
+        if (isConfigError(httpResponseCode)) {
+            reportConfigError(configError, httpResponseCode);
+        }
+        return 0;
+    }
+    if (httpResponseCode >= 300) {
+        LOG_WARN("[NETWORK] Resumos descartados pelo servidor (HTTP %d)", httpResponseCode);
+    } else {
+        LOG_INFO("[NETWORK] %u resumo(s) enviados", count);
+    }
+    return count;
+}
+
+bool NetworkManager::sendMetricsToAPI() {
+    if (!isWiFiConnected) {
+        return false;
+    }
+    
+    JsonDocument doc;
+    metricsToJSON(doc);
+    String payload;
+    serializeJson(doc, payload);
+    
+    int httpResponseCode = postJSON(connections[0], API_METRICS_ENDPOINT, payload, nullptr);
+    return httpResponseCode >= 200 && httpResponseCode < 300;
+}
+
+// Falhas de envio típicas de um socket keep-alive que o servidor já fechou
+static bool isStaleConnectionError(int httpResponseCode) {
+    return httpResponseCode == HTTPC_ERROR_SEND_HEADER_FAILED ||
+           httpResponseCode == HTTPC_ERROR_SEND_PAYLOAD_FAILED ||
+           httpResponseCode == HTTPC_ERROR_NOT_CONNECTED ||
+           httpResponseCode == HTTPC_ERROR_CONNECTION_LOST;
+}
+
+WiFiClient &NetworkManager::transportFor(UplinkConnection &connection, const char *url) {
+    if (strncmp(url, "https://", 8) == 0) {
+        return connection.secureClient;
+    }
+    return connection.plainClient;
+}
+
+int NetworkManager::postJSON(UplinkConnection &connection, const char *url, const String &payload,
+                             String *response) {
+    return postBody(connection, url, "application/json", (const uint8_t *)payload.c_str(), payload.length(),
+                    response);
+}
+
+int NetworkManager::postBody(UplinkConnection &connection, const char *url, const char *contentType,
+                             const uint8_t *body, size_t length, String *response) {
+#if UPLINK_COMPRESSION
+    // Corpos grandes vão comprimidos, se ficarem menores
+    if (compressionEnabled && length >= UPLINK_COMPRESS_MIN_SIZE) {
+        // Um compressor (~6 KB) para todas as conexões do pool
+        if (compressorLock != nullptr) {
+            xSemaphoreTake(compressorLock, portMAX_DELAY);
+        }
+        unsigned long compressStart = micros();
+        size_t compressed = compressor.compress(body, length, connection.compressBuffer,
+                                                sizeof(connection.compressBuffer));
+        compressionStats.cpuMicros += micros() - compressStart;
+        bool smaller = compressed > 0 && compressed < length;
+        if (smaller) {
+            compressionStats.bodies++;
+            compressionStats.bytesIn += length;
+            compressionStats.bytesOut += compressed;
+        }
+        if (compressorLock != nullptr) {
+            xSemaphoreGive(compressorLock);
+        }
+        
+        if (smaller) {
+            LOG_DEBUG("[NETWORK] Corpo comprimido: %u -> %u bytes", length, compressed);
+            
+            int httpResponseCode = sendBody(connection, url, contentType, "gzip", connection.compressBuffer,
+                                            compressed, response);
+            if (httpResponseCode != 415) {
+                return httpResponseCode;
+            }
+            LOG_WARN("[NETWORK] Servidor recusou gzip (HTTP 415), enviando sem compressão");
+            compressionEnabled = false;
+        }
+    }
+#endif
+    return sendBody(connection, url, contentType, nullptr, body, length, response);
+}
+
+int NetworkManager::sendBody(UplinkConnection &connection, const char *url, const char *contentType,
+                             const char *contentEncoding, const uint8_t *body, size_t length, String *response) {
+    HTTPClient &http = connection.http;
+    if (connection.lastRequestTime != 0 && (millis() - connection.lastRequestTime) > HTTP_IDLE_TIMEOUT_MS) {
+        // O servidor provavelmente já fechou o socket ocioso
+        closeConnection(connection);
+    }
+    
+    WiFiClient &client = transportFor(connection, url);
+    int httpResponseCode = 0;
+    unsigned long requestStart = millis();
+    
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = client.connected();
+        if (!reused) {
+            connectionsOpened++;
         }
+        
+        // Mesmo cliente a cada requisição: o HTTPClient reaproveita o socket aberto
+        http.begin(client, url);
+        http.addHeader("Content-Type", contentType);
+        if (contentEncoding != nullptr) {
+            http.addHeader("Content-Encoding", contentEncoding);
+        }
+        http.addHeader("x-api-key", API_KEY);
+        http.setTimeout(HTTP_TIMEOUT_MS);
+        
+        // Envia POST request
+        LOG_DEBUG("[NETWORK] POST %s (%u bytes, conexão %s)", url, length, reused ? "reaproveitada" : "nova");
+        httpResponseCode = http.POST(const_cast<uint8_t *>(body), length);
+        
+        if (!reused || !isStaleConnectionError(httpResponseCode)) {
+            break;
+        }
+        
+        // A conexão reaproveitada estava morta: reconecta e tenta de novo
+        LOG_WARN("[NETWORK] Conexão keep-alive perdida (%d), reconectando", httpResponseCode);
+        closeConnection(connection);
+    }
+    unsigned long elapsed = millis() - requestStart;
+    metricsObserveHttp(httpResponseCode, elapsed);
+    
+    // Verifica resposta
+    if (httpResponseCode >= 200 && httpResponseCode < 300) {
+        LOG_INFO("✅ Dados enviados para API (HTTP %d, %lu ms)", httpResponseCode, elapsed);
+        if (response != nullptr) {
+            *response = http.getString();
+        }
+    } else if (httpResponseCode > 0) {
+        LOG_WARN("❌ Erro HTTP da API: %d (%lu ms)", httpResponseCode, elapsed);
     } else {
-        Serial.println("❌ Erro na conexão HTTP: " + String(httpResponseCode));
-        Serial.println("Erro: " + http.errorToString(httpResponseCode));
+        LOG_ERROR("❌ Erro na conexão HTTP: %d (%lu ms)", httpResponseCode, elapsed);
     }
     
+    // Com reuse ativo, end() mantém o socket aberto se o servidor permitir keep-alive
     http.end();
-    return false;
+    connection.lastRequestTime = millis();
+    return httpResponseCode;
+}
+
+void NetworkManager::closeIdleConnection() {
+    for (size_t i = 0; i < UPLINK_CONNECTIONS; i++) {
+        UplinkConnection &connection = connections[i];
+        if (connection.lastRequestTime != 0 && (millis() - connection.lastRequestTime) > HTTP_IDLE_TIMEOUT_MS) {
+            LOG_DEBUG("[NETWORK] Conexão HTTP %u ociosa, fechando", i);
+            closeConnection(connection);
+        }
+    }
+    
+#if UPLINK_PROTOCOL == UPLINK_PROTOCOL_MQTT
+    // DISCONNECT limpo antes do broker expirar o keep-alive; a sessão fica
+    if (mqtt.isOpen() && mqtt.idleMs() > (unsigned long)MQTT_KEEPALIVE_S * 1000) {
+        LOG_DEBUG("[NETWORK] Sessão MQTT ociosa, desconectando");
+        mqtt.disconnect();
+    }
+#endif
+    
+    // WiFi mantido ligado pela política, mas as rajadas pararam
+    if (isWiFiConnected && (millis() - lastBurstTime) > WIFI_KEEP_UP_INTERVAL_MS) {
+        LOG_DEBUG("[NETWORK] Sem rajadas há %lu ms, desligando WiFi", millis() - lastBurstTime);
+        burstInterval = 0;
+        disconnectWiFi();
+    }
+}
+
+void NetworkManager::closeConnection(UplinkConnection &connection) {
+    connection.http.end();
+    connection.plainClient.stop();
+    connection.secureClient.stop();
+    connection.lastRequestTime = 0;
 }
 
 void NetworkManager::disconnectWiFi() {
+    // Fecha os sockets antes de derrubar o WiFi
+    for (size_t i = 0; i < UPLINK_CONNECTIONS; i++) {
+        closeConnection(connections[i]);
+    }
+#if UPLINK_PROTOCOL == UPLINK_PROTOCOL_MQTT
+    mqtt.disconnect();
+#endif
+    
     if (isWiFiConnected) {
-        Serial.println("\n[NETWORK] Desconectando WiFi...");
         WiFi.disconnect(true);
         isWiFiConnected = false;
-        Serial.println("WiFi desconectado!");
+        LOG_INFO("[NETWORK] WiFi desconectado");
     }
 }
 
-String NetworkManager::createAPIJSON(const ReceivedData &data) {
-    Serial.println("Criando JSON para API...");
-    StaticJsonDocument<200> doc;
-    doc["transmitter_id"] = data.device_id;  // ID do transmissor
-    doc["temperature"] = data.temperature;
-    doc["heart_rate"] = data.heart_rate;
-    doc["oxygen_level"] = data.oxygen_level;
+void NetworkManager::resetWiFi() {
+    // Desliga o driver do WiFi por completo; o próximo connectWiFi() o
+    // inicializa de novo. As leituras pendentes continuam na outbox.
+    disconnectWiFi();
+    WiFi.mode(WIFI_OFF);
+    cacheValid = false;
+    metricWiFiResets.add();
+    LOG_WARN("[NETWORK] Pilha WiFi reiniciada");
+}
+
+static void addMetricJSON(JsonObject parent, const char *name, const MetricSummary &metric, uint16_t count,
+                          float scale) {
+    JsonObject object = parent[name].to<JsonObject>();
+    object["min"] = metric.min * scale;
+    object["max"] = metric.max * scale;
+    object["mean"] = (float)metric.sum / count * scale;
+    object["last"] = metric.last * scale;
+}
+
+String NetworkManager::createSummaryJSON(const AggregateSummary *summaries, size_t count) {
+    // Um objeto por transmissor e janela; o Gateway não tem relógio de
+    // parede, então a janela é informada pela duração e pela idade
+    JsonDocument doc;
+    JsonArray array = doc.to<JsonArray>();
+    uint32_t now = millis();
+    for (size_t i = 0; i < count; i++) {
+        const AggregateSummary &summary = summaries[i];
+        char deviceId[DEVICE_ID_SIZE];
+        formatDeviceId(summary.device_addr, deviceId, sizeof(deviceId));
+        
+        JsonObject item = array.add<JsonObject>();
+        item["transmitter_id"] = deviceId;
+        item["count"] = summary.count;
+        item["window_seconds"] = summary.windowMs / 1000;
+        item["age_seconds"] = (now - summary.windowEndMs) / 1000;
+        addMetricJSON(item, "heart_rate", summary.heartRate, summary.count, 1.0f);
+        addMetricJSON(item, "oxygen_level", summary.oxygen, summary.count, 1.0f);
+        addMetricJSON(item, "temperature", summary.temperature, summary.count, 0.01f);
+    }
     String jsonString;
     serializeJson(doc, jsonString);
     
-    Serial.println("JSON da API criado com sucesso!");
     return jsonString;
 }
 
-bool NetworkManager::isConnectionTimeout() {
-    return (millis() - connectionStartTime) > WIFI_TIMEOUT_MS;
-}
\ No newline at end of file
+bool NetworkManager::parseBatchResponse(const String &response, size_t count, bool *delivered, size_t *processed) {
+    // Formatos aceitos: {"results":[...]} ou [...], com um elemento por item
+    // do lote, na mesma ordem: true/false, código HTTP ou {"status": código}.
+    // Como no envio individual, processed para no primeiro item sem resposta
+    // definitiva
+    JsonDocument doc;
+    if (deserializeJson(doc, response)) {
+        return false;
+    }
+    
+    JsonArray results = doc.is<JsonArray>() ? doc.as<JsonArray>() : doc["results"].as<JsonArray>();
+    if (results.isNull() || results.size() != count) {
+        return false;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        JsonVariant result = results[i];
+        int status = 0;
+        if (result.is<bool>()) {
+            status = result.as<bool>() ? 200 : 400;
+        } else if (result.is<int>()) {
+            status = result.as<int>();
+        } else {
+            status = result["status"] | 0;
+        }
+        if (!isFinalResponse(status)) {
+            if (isConfigError(status)) {
+                reportConfigError(configError, status);
+            }
+            *processed = i;
+            return true;
+        }
+        delivered[i] = status >= 200 && status < 300;
+    }
+    *processed = count;
+    return true;
+}
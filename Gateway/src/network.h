@@ -4,8 +4,15 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <HTTPClient.h>
+#include <WiFiClientSecure.h>
 #include <ArduinoJson.h>
+#include <Preferences.h>
+#include <atomic>
 #include "lora.h"
+#include "uplink_codec.h"
+#include "gzip.h"
+#include "aggregator.h"
+#include "mqtt.h"
 
 // Configurações WiFi e API vêm dos build flags do platformio.ini
 // Valores padrão caso não sejam definidos
@@ -27,21 +34,277 @@
 #ifndef HTTP_TIMEOUT_MS
 #define HTTP_TIMEOUT_MS 5000
 #endif
+#ifndef HTTP_IDLE_TIMEOUT_MS
+#define HTTP_IDLE_TIMEOUT_MS 15000  // Fecha a conexão HTTP reaproveitável após esse tempo ocioso
+#endif
+
+// Envio em lote: um POST com um array JSON de leituras
+#ifndef API_BATCH_ENDPOINT
+#define API_BATCH_ENDPOINT API_ENDPOINT "/batch"
+#endif
+// Resumos do modo de agregação (AGGREGATION_MODE=1)
+#ifndef API_SUMMARY_ENDPOINT
+#define API_SUMMARY_ENDPOINT API_ENDPOINT "/summary"
+#endif
+// Relatório de métricas (METRICS_PUSH=1)
+#ifndef API_METRICS_ENDPOINT
+#define API_METRICS_ENDPOINT API_ENDPOINT "/metrics"
+#endif
+#ifndef UPLINK_BATCH_SIZE
+#define UPLINK_BATCH_SIZE 20       // Leituras por requisição
+#endif
+#ifndef UPLINK_FLUSH_MS
+#define UPLINK_FLUSH_MS 3000       // Espera máxima após a primeira leitura antes do envio
+#endif
+// Pool de conexões HTTP: até UPLINK_CONNECTIONS lotes em voo ao mesmo
+// tempo, um por conexão keep-alive. A conexão 0 é usada pela própria tarefa
+// de uplink; as demais têm uma tarefa cada
+#ifndef UPLINK_CONNECTIONS
+#define UPLINK_CONNECTIONS 1       // 1 = um lote por vez (sem tarefas extras)
+#endif
+#define UPLINK_MAX_CONNECTIONS 4
+static_assert(UPLINK_CONNECTIONS >= 1 && UPLINK_CONNECTIONS <= UPLINK_MAX_CONNECTIONS,
+              "UPLINK_CONNECTIONS deve estar entre 1 e 4");
+#ifndef UPLINK_MIN_FREE_HEAP
+#define UPLINK_MIN_FREE_HEAP 48000 // Heap livre mínimo para usar uma conexão extra (TLS usa ~40 KB)
+#endif
+#define UPLINK_WORKER_STACK 8192      // Como a tarefa de uplink: o handshake TLS usa bastante pilha
+#define UPLINK_WORKER_PRIORITY 2
+#define UPLINK_WORKER_CORE 0       // Mesmo núcleo da tarefa de uplink e do WiFi
+
+// Formato do corpo enviado à API (build flag API_UPLINK_FORMAT)
+#define UPLINK_FORMAT_JSON 0    // JSON com nomes de campo (padrão)
+#define UPLINK_FORMAT_CBOR 1    // application/cbor com chaves inteiras
+#define UPLINK_FORMAT_AUTO 2    // Tenta CBOR; volta para JSON se o servidor recusar
+#ifndef API_UPLINK_FORMAT
+#define API_UPLINK_FORMAT UPLINK_FORMAT_JSON
+#endif
+// Compressão gzip dos corpos (Content-Encoding: gzip). Desligada por
+// padrão: o servidor precisa aceitar corpos comprimidos
+#ifndef UPLINK_COMPRESSION
+#define UPLINK_COMPRESSION 0
+#endif
+#ifndef UPLINK_COMPRESS_MIN_SIZE
+#define UPLINK_COMPRESS_MIN_SIZE 512      // Corpos menores vão sem compressão
+#endif
+#ifndef UPLINK_COMPRESS_BUFFER_SIZE
+#define UPLINK_COMPRESS_BUFFER_SIZE 2048  // Saída comprimida máxima; acima disso vai sem compressão
+#endif
+
+// Protocolo do uplink das leituras (build flag UPLINK_PROTOCOL). Resumos e
+// métricas continuam indo por HTTP
+#define UPLINK_PROTOCOL_HTTP 0  // POST para API_ENDPOINT (padrão)
+#define UPLINK_PROTOCOL_MQTT 1  // PUBLISH QoS 1 no broker MQTT_HOST, sessão persistente
+#ifndef UPLINK_PROTOCOL
+#define UPLINK_PROTOCOL UPLINK_PROTOCOL_HTTP
+#endif
+#ifndef MQTT_HOST
+#define MQTT_HOST "CONFIGURE_NO_PLATFORMIO_INI"
+#endif
+#ifndef MQTT_PORT
+#define MQTT_PORT 1883
+#endif
+#ifndef MQTT_USERNAME
+#define MQTT_USERNAME "gateway"        // A senha é a API_KEY
+#endif
+// MQTT_CLIENT_ID: padrão "vitalsync-gw-" + MAC; precisa ser fixo para a
+// sessão ser retomada entre conexões
+#ifndef MQTT_TOPIC_PREFIX
+#define MQTT_TOPIC_PREFIX "vitalsync/readings"   // Tópico: prefixo/TR-005
+#endif
+#ifndef MQTT_KEEPALIVE_S
+#define MQTT_KEEPALIVE_S 60
+#endif
+#ifndef MQTT_TIMEOUT_MS
+#define MQTT_TIMEOUT_MS 5000           // CONNACK e PUBACKs
+#endif
+#ifndef MQTT_MAX_INFLIGHT
+#define MQTT_MAX_INFLIGHT 8            // Mensagens QoS 1 aguardando PUBACK
+#endif
+#define MQTT_CLIENT_ID_SIZE 32
+#define MQTT_TOPIC_SIZE 64
+
+// PUBLISH MQTT já ficam vários em voo numa só sessão; o pool vale só para HTTP
+#define UPLINK_PIPELINE_DEPTH (UPLINK_PROTOCOL == UPLINK_PROTOCOL_MQTT ? 1 : UPLINK_CONNECTIONS)
+// Leituras aceitas por sendBatchToAPI: um lote por conexão
+#define UPLINK_WINDOW_SIZE (UPLINK_PIPELINE_DEPTH * UPLINK_BATCH_SIZE)
+
+// PUBLISH ainda sem PUBACK; reenviado com o mesmo id e DUP se o mesmo
+// conteúdo voltar da outbox
+struct MqttInflight {
+    uint16_t packetId;
+    uint32_t payloadCRC;
+};
+
+struct CompressionStats {
+    uint32_t bodies;        // Corpos enviados comprimidos
+    uint32_t bytesIn;
+    uint32_t bytesOut;
+    uint32_t cpuMicros;     // Tempo gasto comprimindo (inclusive tentativas sem ganho)
+};
+
+// Reconexão rápida: BSSID, canal e IP da última conexão ficam no NVS e a
+// próxima conexão pula a busca de canais; se falhar, busca completa
+#ifndef WIFI_FAST_CONNECT
+#define WIFI_FAST_CONNECT 1
+#endif
+#ifndef WIFI_FAST_TIMEOUT_MS
+#define WIFI_FAST_TIMEOUT_MS 3000      // Prazo do caminho rápido antes da busca completa
+#endif
+#ifndef WIFI_CACHE_IP
+// Reaproveita o último IP do DHCP como IP fixo e pula o DHCP. A concessão
+// não é acompanhada: se o roteador der o IP a outro aparelho, o WiFi
+// associa e as requisições falham. Só com o IP reservado no roteador
+#define WIFI_CACHE_IP 0
+#endif
+#ifndef WIFI_KEEP_UP_INTERVAL_MS
+#define WIFI_KEEP_UP_INTERVAL_MS 60000 // Mantém o WiFi ligado se as rajadas vierem em intervalos menores
+#endif
+#define WIFI_POLL_INTERVAL_MS 50
+
+// Dados da última conexão bem-sucedida, gravados no NVS
+struct WiFiCache {
+    uint8_t bssid[6];
+    int32_t channel;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+    uint16_t ssidHash;      // Invalida o cache se o SSID mudar
+};
+
+struct WiFiStats {
+    uint32_t fastConnects;
+    uint32_t fullConnects;
+    uint32_t failures;
+    uint32_t reusedLinks;           // Rajadas que encontraram o WiFi já ligado
+    unsigned long lastConnectMs;
+    unsigned long maxConnectMs;
+    unsigned long totalConnectMs;
+};
+
+// Conexão do pool: socket keep-alive e buffers de uma requisição
+struct UplinkConnection {
+    WiFiClient plainClient;
+    WiFiClientSecure secureClient;
+    HTTPClient http;
+    unsigned long lastRequestTime;
+    uint8_t cborBuffer[3 + UPLINK_BATCH_SIZE * CBOR_READING_MAX_SIZE];
+#if UPLINK_COMPRESSION
+    uint8_t compressBuffer[UPLINK_COMPRESS_BUFFER_SIZE];
+#endif
+};
+
+// Lote entregue a uma conexão do pool; aponta para os arrays de quem chamou
+struct UplinkRequest {
+    const ReceivedData *items;
+    bool *delivered;
+    size_t count;
+    size_t processed;
+};
+
+class NetworkManager;
+
+struct UplinkWorker {
+    NetworkManager *manager;
+    uint8_t index;
+    TaskHandle_t task;
+};
 
 class NetworkManager {
 private:
     bool isWiFiConnected;
     unsigned long connectionStartTime;
+    // O estado negociado com o servidor é compartilhado pelas conexões do pool
+    std::atomic<bool> batchSupported;   // Desligado se o servidor recusar lotes
+    std::atomic<int> configError;       // 401/403/404 na última rodada de envio (0 = nenhum)
+    
+    // Conexões HTTP persistentes (keep-alive), reaproveitadas entre requisições
+    UplinkConnection connections[UPLINK_CONNECTIONS];
+    std::atomic<uint32_t> connectionsOpened;
+    
+    // Conexões extras: uma tarefa por conexão, que avisa o fim pela fila
+    UplinkWorker workers[UPLINK_CONNECTIONS];
+    UplinkRequest requests[UPLINK_CONNECTIONS];
+    QueueHandle_t completions;
+    
+    // Corpo CBOR (modo CBOR ou automático)
+    std::atomic<bool> cborEnabled;
+    std::atomic<bool> cborConfirmed;    // Servidor já aceitou CBOR (sem sondagem)
+    
+    // Compressão dos corpos (um compressor para todas as conexões)
+    std::atomic<bool> compressionEnabled;   // Desligada se o servidor recusar gzip
+#if UPLINK_COMPRESSION
+    GzipCompressor compressor;
+#endif
+    SemaphoreHandle_t compressorLock;
+    CompressionStats compressionStats;
+    
+#if UPLINK_PROTOCOL == UPLINK_PROTOCOL_MQTT
+    // Sessão MQTT, mantida enquanto o WiFi estiver ligado
+    WiFiClient mqttTransport;
+    MqttClient mqtt;
+    MqttInflight inflight[MQTT_MAX_INFLIGHT];
+    size_t inflightCount;
+#endif
+    
+    // Reconexão rápida e política de manter o link
+    WiFiCache cache;
+    bool cacheValid;
+    unsigned long lastBurstTime;
+    unsigned long burstInterval;    // Média móvel do intervalo entre rajadas
+    WiFiStats wifiStats;
     
 public:
     NetworkManager();
+    void begin();
     bool connectWiFi();
     bool sendDataToAPI(const ReceivedData &data);
+    // Envia até UPLINK_WINDOW_SIZE leituras, em lotes de UPLINK_BATCH_SIZE
+    // distribuídos pelas conexões do pool. answered[i] indica as leituras
+    // com resposta definitiva do servidor (não necessariamente contínuas:
+    // cada lote para no seu primeiro item sem resposta) e delivered[i] quais
+    // delas foram aceitas. Retorna quantas tiveram resposta
+    size_t sendBatchToAPI(const ReceivedData *items, size_t count, bool *delivered, bool *answered);
+    size_t sendSummariesToAPI(const AggregateSummary *summaries, size_t count);
+    // Código 401/403/404 que interrompeu a última rodada (0 se nenhum): a
+    // API recusou a chave ou o endpoint, e as leituras ficaram na outbox
+    int getConfigError() const { return configError.load(); }
+    bool sendMetricsToAPI();
+    void finishBurst();
     void disconnectWiFi();
+    void resetWiFi();
+    void closeIdleConnection();
+    uint32_t getConnectionsOpened() const { return connectionsOpened.load(); }
+    const WiFiStats &getWiFiStats() const { return wifiStats; }
+    const CompressionStats &getCompressionStats() const { return compressionStats; }
     
 private:
-    String createAPIJSON(const ReceivedData &data);
-    bool isConnectionTimeout();
+    static void workerTask(void *parameter);
+    size_t dispatchBatches(const ReceivedData *items, size_t count, bool *delivered, bool *answered);
+    WiFiClient &transportFor(UplinkConnection &connection, const char *url);
+    void closeConnection(UplinkConnection &connection);
+    size_t sendBatch(UplinkConnection &connection, const ReceivedData *items, size_t count, bool *delivered);
+    int postReading(UplinkConnection &connection, const ReceivedData &data);
+    int postBatch(UplinkConnection &connection, const ReceivedData *items, size_t count, String *response);
+    int postJSON(UplinkConnection &connection, const char *url, const String &payload, String *response);
+    int postBody(UplinkConnection &connection, const char *url, const char *contentType, const uint8_t *body,
+                 size_t length, String *response);
+    int sendBody(UplinkConnection &connection, const char *url, const char *contentType,
+                 const char *contentEncoding, const uint8_t *body, size_t length, String *response);
+    bool isCBORRejected(int httpResponseCode);
+    String createSummaryJSON(const AggregateSummary *summaries, size_t count);
+    bool parseBatchResponse(const String &response, size_t count, bool *delivered, size_t *processed);
+    size_t sendEachToAPI(UplinkConnection &connection, const ReceivedData *items, size_t count, bool *delivered);
+#if UPLINK_PROTOCOL == UPLINK_PROTOCOL_MQTT
+    bool connectMqtt();
+    size_t publishBatch(const ReceivedData *items, size_t count, bool *delivered);
+    uint16_t inflightPacketId(uint32_t payloadCRC, bool &duplicate);
+#endif
+    bool waitForConnection(unsigned long timeoutMs);
+    void noteBurst();
+    bool loadCache();
+    void saveCache();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,430 @@
+#include "outbox.h"
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Registro no flash (15 bytes, big-endian):
+// [0] 0xA5 | [1..2] endereço | [3..4] sequência | [5] hr | [6] SpO2 |
+// [7..8] temperatura (0,01 °C) | [9..12] storedAt | [13..14] CRC-16
+#define OUTBOX_RECORD_MAGIC 0xA5
+#define OUTBOX_RECORD_SIZE 15
+#define OUTBOX_SCAN_CHUNK 8
+
+static void encodeRecord(const OutboxRecord &record, uint8_t *out) {
+    out[0] = OUTBOX_RECORD_MAGIC;
+    out[1] = (uint8_t)(record.reading.device_addr >> 8);
+    out[2] = (uint8_t)(record.reading.device_addr & 0xFF);
+    out[3] = (uint8_t)(record.reading.sequence >> 8);
+    out[4] = (uint8_t)(record.reading.sequence & 0xFF);
+    out[5] = record.reading.heart_rate;
+    out[6] = record.reading.oxygen_level;
+    out[7] = (uint8_t)((uint16_t)record.reading.temperature_centi >> 8);
+    out[8] = (uint8_t)(record.reading.temperature_centi & 0xFF);
+    out[9] = (uint8_t)(record.storedAt >> 24);
+    out[10] = (uint8_t)(record.storedAt >> 16);
+    out[11] = (uint8_t)(record.storedAt >> 8);
+    out[12] = (uint8_t)(record.storedAt & 0xFF);
+    uint16_t crc = frameCRC16(out, OUTBOX_RECORD_SIZE - 2);
+    out[13] = (uint8_t)(crc >> 8);
+    out[14] = (uint8_t)(crc & 0xFF);
+}
+
+static bool decodeRecord(const uint8_t *in, OutboxRecord &record) {
+    if (in[0] != OUTBOX_RECORD_MAGIC) {
+        return false;
+    }
+    uint16_t crc = (uint16_t)((in[13] << 8) | in[14]);
+    if (frameCRC16(in, OUTBOX_RECORD_SIZE - 2) != crc) {
+        return false;
+    }
+
+    record.reading.device_addr = (uint16_t)((in[1] << 8) | in[2]);
+    record.reading.sequence = (uint16_t)((in[3] << 8) | in[4]);
+    record.reading.heart_rate = in[5];
+    record.reading.oxygen_level = in[6];
+    record.reading.temperature_centi = (int16_t)((in[7] << 8) | in[8]);
+    record.storedAt = ((uint32_t)in[9] << 24) | ((uint32_t)in[10] << 16) |
+                      ((uint32_t)in[11] << 8) | in[12];
+    return true;
+}
+
+Outbox::Outbox()
+    : mounted(false), readSegment(1), readOffset(0), writeSegment(1), writeOffset(0),
+      flashPending(0), oldestStoredAt(0), clockBase(0), droppedRecords(0), ramDropped(0), writeErrors(0),
+      bufferCount(0), ackedAhead(0) {
+    basePath[0] = '\0';
+}
+
+void Outbox::segmentPath(uint32_t segment, char *path, size_t size) const {
+    snprintf(path, size, "%s/seg_%08lu.log", basePath, (unsigned long)segment);
+}
+
+void Outbox::cursorPath(char *path, size_t size) const {
+    snprintf(path, size, "%s/cursor", basePath);
+}
+
+bool Outbox::begin(const char *path, uint32_t uptimeSeconds) {
+    snprintf(basePath, sizeof(basePath), "%s", path);
+    mkdir(basePath, 0777);
+
+    DIR *dir = opendir(basePath);
+    if (dir == nullptr) {
+        return false;
+    }
+
+    // Descobre o intervalo de segmentos existentes
+    uint32_t minSegment = 0;
+    uint32_t maxSegment = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        unsigned long id;
+        if (sscanf(entry->d_name, "seg_%lu.log", &id) == 1 && id > 0) {
+            if (minSegment == 0 || id < minSegment) minSegment = (uint32_t)id;
+            if (id > maxSegment) maxSegment = (uint32_t)id;
+        }
+    }
+    closedir(dir);
+
+    if (!loadCursor() || readSegment < minSegment) {
+        readSegment = minSegment > 0 ? minSegment : 1;
+        readOffset = 0;
+    }
+
+    // Cada boot escreve num segmento novo: uma cauda corrompida por queda
+    // de energia no segmento anterior não esconde os registros seguintes
+    writeSegment = maxSegment + 1 > readSegment ? maxSegment + 1 : readSegment;
+    writeOffset = 0;
+    mounted = true;
+
+    uint32_t firstStoredAt = 0;
+    uint32_t maxStoredAt = 0;
+    flashPending = scan(firstStoredAt, maxStoredAt);
+    ackedAhead = 0;
+    oldestStoredAt = firstStoredAt;
+    clockBase = (maxStoredAt + 1 > uptimeSeconds) ? maxStoredAt + 1 - uptimeSeconds : 0;
+    return true;
+}
+
+bool Outbox::loadCursor() {
+    char path[OUTBOX_PATH_SIZE + 16];
+    cursorPath(path, sizeof(path));
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    uint8_t data[10];
+    bool valid = fread(data, 1, sizeof(data), file) == sizeof(data) &&
+                 frameCRC16(data, 8) == (uint16_t)((data[8] << 8) | data[9]);
+    fclose(file);
+    if (!valid) {
+        return false;
+    }
+
+    readSegment = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+    readOffset = ((uint32_t)data[4] << 24) | ((uint32_t)data[5] << 16) | ((uint32_t)data[6] << 8) | data[7];
+    return true;
+}
+
+bool Outbox::saveCursor() {
+    uint8_t data[10];
+    data[0] = (uint8_t)(readSegment >> 24);
+    data[1] = (uint8_t)(readSegment >> 16);
+    data[2] = (uint8_t)(readSegment >> 8);
+    data[3] = (uint8_t)(readSegment & 0xFF);
+    data[4] = (uint8_t)(readOffset >> 24);
+    data[5] = (uint8_t)(readOffset >> 16);
+    data[6] = (uint8_t)(readOffset >> 8);
+    data[7] = (uint8_t)(readOffset & 0xFF);
+    uint16_t crc = frameCRC16(data, 8);
+    data[8] = (uint8_t)(crc >> 8);
+    data[9] = (uint8_t)(crc & 0xFF);
+
+    char path[OUTBOX_PATH_SIZE + 16];
+    cursorPath(path, sizeof(path));
+    FILE *file = fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool written = fwrite(data, 1, sizeof(data), file) == sizeof(data);
+    fclose(file);
+    return written;
+}
+
+uint32_t Outbox::scan(uint32_t &firstStoredAt, uint32_t &maxStoredAt) {
+    OutboxRecord chunk[OUTBOX_SCAN_CHUNK];
+    uint32_t segment = readSegment;
+    uint32_t offset = readOffset;
+    uint32_t count = 0;
+
+    for (;;) {
+        size_t n = readRecords(chunk, OUTBOX_SCAN_CHUNK, segment, offset);
+        if (n == 0) {
+            break;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (count == 0 && i == 0) firstStoredAt = chunk[i].storedAt;
+            if (chunk[i].storedAt > maxStoredAt) maxStoredAt = chunk[i].storedAt;
+        }
+        count += n;
+    }
+    return count;
+}
+
+size_t Outbox::readRecords(OutboxRecord *records, size_t maxRecords, uint32_t &segment, uint32_t &offset) {
+    // Lê a partir de (segment, offset) avançando pelos segmentos; records
+    // pode ser nullptr para apenas avançar o cursor
+    size_t count = 0;
+    uint8_t raw[OUTBOX_RECORD_SIZE];
+
+    while (count < maxRecords && segment <= writeSegment) {
+        char path[OUTBOX_PATH_SIZE + 24];
+        segmentPath(segment, path, sizeof(path));
+
+        bool segmentEnded = true;
+        FILE *file = fopen(path, "rb");
+        if (file != nullptr) {
+            if (fseek(file, offset, SEEK_SET) == 0) {
+                while (count < maxRecords) {
+                    OutboxRecord record;
+                    if (fread(raw, 1, OUTBOX_RECORD_SIZE, file) != OUTBOX_RECORD_SIZE ||
+                        !decodeRecord(raw, record)) {
+                        break;    // Fim do segmento ou registro corrompido
+                    }
+                    if (records != nullptr) {
+                        records[count] = record;
+                    }
+                    count++;
+                    offset += OUTBOX_RECORD_SIZE;
+                }
+                segmentEnded = count < maxRecords;
+            }
+            fclose(file);
+        }
+
+        if (!segmentEnded || segment == writeSegment) {
+            break;
+        }
+        segment++;
+        offset = 0;
+    }
+    return count;
+}
+
+bool Outbox::append(const ReadingFrame &reading, uint32_t uptimeSeconds) {
+    bool kept = true;
+    if (bufferCount == OUTBOX_RAM_RECORDS) {
+        // Flash indisponível e anel cheio: o registro mais antigo dá lugar ao novo
+        memmove(writeBuffer, writeBuffer + 1, (bufferCount - 1) * sizeof(OutboxRecord));
+        bufferCount--;
+        ramDropped++;
+        forgetAckedAt(flashPending);
+        kept = false;
+    }
+
+    OutboxRecord &record = writeBuffer[bufferCount++];
+    record.reading = reading;
+    record.storedAt = clockNow(uptimeSeconds);
+
+    if (mounted && bufferCount % OUTBOX_WRITE_BATCH == 0) {
+        flush();
+    }
+    return kept;
+}
+
+bool Outbox::flush() {
+    if (bufferCount == 0) {
+        return true;
+    }
+    if (!mounted) {
+        return false;
+    }
+
+    size_t written = 0;
+    while (written < bufferCount) {
+        if (writeOffset + OUTBOX_RECORD_SIZE > OUTBOX_SEGMENT_SIZE) {
+            writeSegment++;
+            writeOffset = 0;
+        }
+        while (writeSegment - readSegment + 1 > OUTBOX_MAX_SEGMENTS) {
+            dropOldestSegment();
+        }
+
+        // Um fwrite por lote, com os registros que ainda cabem no segmento
+        uint8_t raw[OUTBOX_WRITE_BATCH * OUTBOX_RECORD_SIZE];
+        size_t fit = (OUTBOX_SEGMENT_SIZE - writeOffset) / OUTBOX_RECORD_SIZE;
+        size_t count = bufferCount - written;
+        if (count > fit) count = fit;
+        if (count > OUTBOX_WRITE_BATCH) count = OUTBOX_WRITE_BATCH;
+        for (size_t i = 0; i < count; i++) {
+            encodeRecord(writeBuffer[written + i], raw + i * OUTBOX_RECORD_SIZE);
+        }
+
+        char path[OUTBOX_PATH_SIZE + 24];
+        segmentPath(writeSegment, path, sizeof(path));
+        FILE *file = fopen(path, "ab");
+        if (file == nullptr) {
+            writeErrors++;
+            break;
+        }
+        size_t bytes = fwrite(raw, 1, count * OUTBOX_RECORD_SIZE, file);
+        // O stdio guarda em buffer: a falha pode aparecer só no fclose
+        bool complete = fclose(file) == 0 && bytes == count * OUTBOX_RECORD_SIZE;
+        if (!complete) {
+            // Escrita parcial: corta a cauda de volta para writeOffset, senão
+            // o registro pela metade esconderia os gravados depois dele. Os
+            // registros ficam em RAM para a próxima tentativa; se nem o corte
+            // der certo, eles vão para um segmento novo
+            writeErrors++;
+            if (truncate(path, writeOffset) != 0) {
+                writeSegment++;
+                writeOffset = 0;
+            }
+            break;
+        }
+
+        if (flashPending == 0 && written == 0) {
+            oldestStoredAt = writeBuffer[0].storedAt;
+        }
+        writeOffset += (uint32_t)bytes;
+        flashPending += count;
+        written += count;
+    }
+
+    // Mantém em RAM o que não pôde ser gravado
+    if (written > 0) {
+        memmove(writeBuffer, writeBuffer + written, (bufferCount - written) * sizeof(OutboxRecord));
+        bufferCount -= written;
+    }
+    return bufferCount == 0;
+}
+
+size_t Outbox::peek(OutboxRecord *records, size_t maxRecords) {
+    // Primeiro os registros do flash, depois os que ainda estão em RAM
+    size_t count = 0;
+    if (flashPending > 0) {
+        uint32_t segment = readSegment;
+        uint32_t offset = readOffset;
+        count = readRecords(records, maxRecords, segment, offset);
+    }
+    for (size_t i = 0; count < maxRecords && i < bufferCount; i++) {
+        records[count++] = writeBuffer[i];
+    }
+    return count;
+}
+
+void Outbox::acknowledge(size_t count) {
+    // Os count primeiros, mais os já confirmados logo em seguida
+    size_t prefix = count;
+    while (isAcknowledged(prefix)) {
+        prefix++;
+    }
+    ackedAhead = prefix < OUTBOX_ACK_WINDOW ? ackedAhead >> prefix : 0;
+    consume(prefix);
+}
+
+void Outbox::acknowledge(const bool *done, size_t count) {
+    for (size_t i = 0; i < count && i < OUTBOX_ACK_WINDOW; i++) {
+        if (done[i]) {
+            ackedAhead |= (uint64_t)1 << i;
+        }
+    }
+
+    // O cursor só passa pelo início contínuo; o resto fica marcado
+    size_t prefix = 0;
+    while (prefix < count && (done[prefix] || isAcknowledged(prefix))) {
+        prefix++;
+    }
+    while (isAcknowledged(prefix)) {
+        prefix++;
+    }
+    ackedAhead = prefix < OUTBOX_ACK_WINDOW ? ackedAhead >> prefix : 0;
+    consume(prefix);
+}
+
+void Outbox::forgetAckedAt(size_t position) {
+    // Registro descartado nessa posição: os seguintes andam uma posição
+    if (position >= OUTBOX_ACK_WINDOW) {
+        return;
+    }
+    uint64_t below = ackedAhead & (((uint64_t)1 << position) - 1);
+    uint64_t above = position + 1 < OUTBOX_ACK_WINDOW ? (ackedAhead >> (position + 1)) << position : 0;
+    ackedAhead = below | above;
+}
+
+void Outbox::consume(size_t count) {
+    size_t fromFlash = count < flashPending ? count : flashPending;
+    if (fromFlash > 0) {
+        uint32_t previousSegment = readSegment;
+        readRecords(nullptr, fromFlash, readSegment, readOffset);
+        flashPending -= fromFlash;
+        deleteConsumedSegments(previousSegment);
+        saveCursor();
+
+        if (flashPending > 0) {
+            OutboxRecord first;
+            uint32_t segment = readSegment;
+            uint32_t offset = readOffset;
+            if (readRecords(&first, 1, segment, offset) == 1) {
+                oldestStoredAt = first.storedAt;
+            }
+        }
+    }
+
+    size_t fromBuffer = count - fromFlash;
+    if (fromBuffer > bufferCount) fromBuffer = bufferCount;
+    if (fromBuffer > 0) {
+        memmove(writeBuffer, writeBuffer + fromBuffer, (bufferCount - fromBuffer) * sizeof(OutboxRecord));
+        bufferCount -= fromBuffer;
+    }
+}
+
+void Outbox::dropOldestSegment() {
+    // Sem espaço: perde os registros pendentes do segmento mais antigo
+    char path[OUTBOX_PATH_SIZE + 24];
+    segmentPath(readSegment, path, sizeof(path));
+
+    uint32_t lost = 0;
+    FILE *file = fopen(path, "rb");
+    if (file != nullptr) {
+        if (fseek(file, 0, SEEK_END) == 0) {
+            long size = ftell(file);
+            if (size > (long)readOffset) {
+                lost = (uint32_t)(size - readOffset) / OUTBOX_RECORD_SIZE;
+            }
+        }
+        fclose(file);
+    }
+    if (lost > flashPending) lost = flashPending;
+
+    remove(path);
+    droppedRecords += lost;
+    flashPending -= lost;
+    ackedAhead = lost < OUTBOX_ACK_WINDOW ? ackedAhead >> lost : 0;
+    readSegment++;
+    readOffset = 0;
+    saveCursor();
+}
+
+void Outbox::deleteConsumedSegments(uint32_t fromSegment) {
+    for (uint32_t segment = fromSegment; segment < readSegment; segment++) {
+        char path[OUTBOX_PATH_SIZE + 24];
+        segmentPath(segment, path, sizeof(path));
+        remove(path);
+    }
+}
+
+uint32_t Outbox::oldestAgeSeconds(uint32_t uptimeSeconds) const {
+    uint32_t oldest;
+    if (flashPending > 0) {
+        oldest = oldestStoredAt;
+    } else if (bufferCount > 0) {
+        oldest = writeBuffer[0].storedAt;
+    } else {
+        return 0;
+    }
+    uint32_t now = clockNow(uptimeSeconds);
+    return now > oldest ? now - oldest : 0;
+}
@@ -0,0 +1,126 @@
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "frame.h"
+
+// Caixa de saída persistente (store-and-forward) das leituras pendentes.
+//
+// Log append-only dividido em segmentos (arquivos seg_NNNNNNNN.log) no
+// sistema de arquivos montado em basePath (LittleFS em /littlefs no ESP32,
+// qualquer diretório no host, já que só usa stdio/dirent). Cada registro
+// tem CRC-16; registros corrompidos (escrita interrompida por queda de
+// energia) encerram a leitura do segmento. O cursor de leitura só avança
+// quando a API confirma o recebimento e é salvo no arquivo "cursor".
+//
+// As escritas são agrupadas: append() guarda os registros em RAM e flush()
+// grava todos com um fwrite por segmento. Quem chama faz o flush() logo
+// depois de cada lote de append() (o Gateway, toda vez que esvazia a fila
+// da recepção), e append() grava sozinho a cada OUTBOX_WRITE_BATCH
+// registros acumulados, então um reboot perde no máximo o lote em
+// andamento. Uma escrita parcial é cortada de volta ao fim do último
+// registro inteiro e os registros continuam em RAM para a próxima tentativa.
+//
+// Sem sistema de arquivos (begin() falhou ou não foi chamado) ou com o
+// flash recusando escritas, a outbox continua funcionando como um anel em
+// RAM de OUTBOX_RAM_RECORDS registros: cheio, o registro mais antigo dá
+// lugar ao novo e é contado em ramDroppedCount(). O que está só em RAM se
+// perde num reboot.
+//
+// A confirmação pode vir fora de ordem (lotes paralelos em que um falhou):
+// o cursor avança só pelo início contínuo e os registros respondidos logo
+// depois dele ficam marcados num bitmap em RAM de OUTBOX_ACK_WINDOW
+// posições, que quem envia consulta com isAcknowledged() para não
+// reenviá-los. Um reboot perde só essas marcas, e esses registros são
+// reenviados uma vez.
+//
+// O tempo dos registros é um relógio monotônico em segundos de
+// funcionamento, que continua do último valor gravado após um reboot.
+
+#ifndef OUTBOX_SEGMENT_SIZE
+#define OUTBOX_SEGMENT_SIZE 4096      // Bytes por segmento
+#endif
+#ifndef OUTBOX_MAX_SEGMENTS
+#define OUTBOX_MAX_SEGMENTS 32        // Acima disso o segmento mais antigo é descartado
+#endif
+#ifndef OUTBOX_WRITE_BATCH
+#define OUTBOX_WRITE_BATCH 16         // Registros por fwrite; append() grava sozinho a cada lote
+#endif
+#ifndef OUTBOX_RAM_RECORDS
+#define OUTBOX_RAM_RECORDS 64         // Anel em RAM enquanto o flash não estiver disponível
+#endif
+#define OUTBOX_PATH_SIZE 64
+#define OUTBOX_ACK_WINDOW 64          // Registros após o cursor com confirmação fora de ordem
+
+static_assert(OUTBOX_RAM_RECORDS >= OUTBOX_WRITE_BATCH, "OUTBOX_RAM_RECORDS menor que um lote de escrita");
+
+struct OutboxRecord {
+    ReadingFrame reading;
+    uint32_t storedAt;      // Segundos no relógio da outbox
+};
+
+class Outbox {
+private:
+    char basePath[OUTBOX_PATH_SIZE];
+    bool mounted;
+
+    // Cursor de leitura (primeiro registro ainda não confirmado no flash)
+    uint32_t readSegment;
+    uint32_t readOffset;
+
+    // Segmento atual de escrita
+    uint32_t writeSegment;
+    uint32_t writeOffset;
+
+    uint32_t flashPending;      // Registros pendentes no flash
+    uint32_t oldestStoredAt;    // storedAt do registro no cursor
+    uint32_t clockBase;         // Ajuste do relógio entre reboots
+    uint32_t droppedRecords;    // Descartados por falta de espaço
+    uint32_t ramDropped;        // Sobrescritos no anel em RAM
+    uint32_t writeErrors;       // Escritas no flash que falharam
+
+    OutboxRecord writeBuffer[OUTBOX_RAM_RECORDS];
+    size_t bufferCount;
+
+    uint64_t ackedAhead;        // Bit i = registro na posição i após o cursor já confirmado
+
+public:
+    Outbox();
+    bool begin(const char *path, uint32_t uptimeSeconds);
+    bool append(const ReadingFrame &reading, uint32_t uptimeSeconds);
+    bool flush();
+    size_t peek(OutboxRecord *records, size_t maxRecords);
+    // Confirma os count primeiros registros do peek()
+    void acknowledge(size_t count);
+    // Confirma os registros do peek() com done[i]; os demais continuam pendentes
+    void acknowledge(const bool *done, size_t count);
+    // Registro index do peek() já confirmado fora de ordem
+    bool isAcknowledged(size_t index) const {
+        return index < OUTBOX_ACK_WINDOW && (ackedAhead >> index) & 1;
+    }
+
+    uint32_t pendingCount() const { return flashPending + bufferCount; }
+    uint32_t flashPendingCount() const { return flashPending; }
+    uint32_t droppedCount() const { return droppedRecords; }
+    uint32_t ramPendingCount() const { return bufferCount; }
+    uint32_t ramDroppedCount() const { return ramDropped; }
+    uint32_t writeErrorCount() const { return writeErrors; }
+    bool isMounted() const { return mounted; }
+    uint32_t oldestAgeSeconds(uint32_t uptimeSeconds) const;
+
+private:
+    uint32_t clockNow(uint32_t uptimeSeconds) const { return clockBase + uptimeSeconds; }
+    void segmentPath(uint32_t segment, char *path, size_t size) const;
+    void cursorPath(char *path, size_t size) const;
+    bool loadCursor();
+    bool saveCursor();
+    uint32_t scan(uint32_t &firstStoredAt, uint32_t &maxStoredAt);
+    size_t readRecords(OutboxRecord *records, size_t maxRecords, uint32_t &segment, uint32_t &offset);
+    void dropOldestSegment();
+    void consume(size_t count);
+    void forgetAckedAt(size_t position);
+    void deleteConsumedSegments(uint32_t fromSegment);
+};
+
+#endif
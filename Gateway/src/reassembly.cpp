@@ -0,0 +1,150 @@
+#include "reassembly.h"
+#include <string.h>
+
+Reassembler::Reassembler(MessageHandler handler, void *context) : handler(handler), handlerContext(context) {
+    reset();
+}
+
+void Reassembler::reset() {
+    for (size_t i = 0; i < REASSEMBLY_SLOTS; i++) {
+        slots[i].used = false;
+    }
+    for (size_t i = 0; i < REASSEMBLY_RECENT; i++) {
+        recent[i].used = false;
+    }
+    recentNext = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+Reassembler::Slot *Reassembler::findSlot(uint16_t deviceAddr, uint8_t messageId) {
+    for (size_t i = 0; i < REASSEMBLY_SLOTS; i++) {
+        Slot &slot = slots[i];
+        if (slot.used && slot.device_addr == deviceAddr && slot.messageId == messageId) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+Reassembler::Slot *Reassembler::claimSlot(uint32_t nowMs) {
+    // Slot livre, ou o da mensagem mais antiga
+    Slot *oldest = nullptr;
+    for (size_t i = 0; i < REASSEMBLY_SLOTS; i++) {
+        Slot &slot = slots[i];
+        if (!slot.used) {
+            return &slot;
+        }
+        if (oldest == nullptr || nowMs - slot.startedMs > nowMs - oldest->startedMs) {
+            oldest = &slot;
+        }
+    }
+    stats.evicted++;
+    return oldest;
+}
+
+bool Reassembler::recentlyCompleted(uint16_t deviceAddr, uint8_t messageId, uint16_t sequence, uint32_t nowMs) const {
+    for (size_t i = 0; i < REASSEMBLY_RECENT; i++) {
+        const Recent &entry = recent[i];
+        if (entry.used && entry.device_addr == deviceAddr && entry.messageId == messageId &&
+            entry.sequence == sequence && nowMs - entry.completedMs < REASSEMBLY_TIMEOUT_MS) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Reassembler::rememberCompleted(const Slot &slot, uint32_t nowMs) {
+    Recent &entry = recent[recentNext];
+    entry.completedMs = nowMs;
+    entry.device_addr = slot.device_addr;
+    entry.sequence = slot.sequence;
+    entry.messageId = slot.messageId;
+    entry.used = true;
+    recentNext = (recentNext + 1) % REASSEMBLY_RECENT;
+}
+
+FrameStatus Reassembler::push(const FrameHeader &header, const uint8_t *payload, uint32_t nowMs) {
+    FragmentHeader fragment;
+    const uint8_t *data = nullptr;
+    size_t length = 0;
+    FrameStatus status = decodeFragmentPayload(header, payload, fragment, data, length);
+    if (status != FRAME_OK) {
+        stats.invalid++;
+        return status;
+    }
+    expire(nowMs);
+
+    Slot *slot = findSlot(header.device_addr, fragment.message_id);
+    if (slot != nullptr &&
+        (slot->count != fragment.count || slot->type != fragment.message_type || slot->sequence != header.sequence)) {
+        // Mesmo id com outra mensagem (transmissor reiniciou): a antiga não completa mais
+        stats.evicted++;
+        slot->used = false;
+        slot = nullptr;
+    }
+    if (slot == nullptr) {
+        if (recentlyCompleted(header.device_addr, fragment.message_id, header.sequence, nowMs)) {
+            stats.duplicates++;
+            return FRAME_OK;
+        }
+        slot = claimSlot(nowMs);
+        slot->used = true;
+        slot->startedMs = nowMs;
+        slot->received = 0;
+        slot->lastLength = 0;
+        slot->device_addr = header.device_addr;
+        slot->sequence = header.sequence;
+        slot->messageId = fragment.message_id;
+        slot->type = fragment.message_type;
+        slot->count = fragment.count;
+    }
+
+    uint16_t bit = (uint16_t)(1u << fragment.index);
+    if (slot->received & bit) {
+        stats.duplicates++;
+        return FRAME_OK;
+    }
+    memcpy(slot->data + fragment.index * FRAME_FRAGMENT_DATA_MAX, data, length);
+    slot->received |= bit;
+    if (fragment.index + 1 == fragment.count) {
+        slot->lastLength = (uint16_t)length;
+    }
+    stats.fragments++;
+
+    uint16_t all = (uint16_t)((1u << slot->count) - 1);
+    if (slot->received != all) {
+        return FRAME_OK;
+    }
+
+    ReassembledMessage message;
+    message.device_addr = slot->device_addr;
+    message.sequence = slot->sequence;
+    message.type = slot->type;
+    message.data = slot->data;
+    message.length = (size_t)(slot->count - 1) * FRAME_FRAGMENT_DATA_MAX + slot->lastLength;
+    stats.completed++;
+    handler(message, handlerContext);
+    rememberCompleted(*slot, nowMs);
+    slot->used = false;
+    return FRAME_OK;
+}
+
+void Reassembler::expire(uint32_t nowMs) {
+    for (size_t i = 0; i < REASSEMBLY_SLOTS; i++) {
+        Slot &slot = slots[i];
+        if (slot.used && nowMs - slot.startedMs >= REASSEMBLY_TIMEOUT_MS) {
+            slot.used = false;
+            stats.expired++;
+        }
+    }
+}
+
+size_t Reassembler::pendingCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < REASSEMBLY_SLOTS; i++) {
+        if (slots[i].used) {
+            count++;
+        }
+    }
+    return count;
+}
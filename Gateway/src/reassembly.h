@@ -0,0 +1,104 @@
+#ifndef REASSEMBLY_H
+#define REASSEMBLY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "frame.h"
+
+// Remontagem das mensagens fragmentadas (FRAME_TYPE_FRAGMENT, ver frame.h).
+//
+// Cada mensagem em andamento ocupa um de REASSEMBLY_SLOTS slots fixos,
+// identificado por (endereço do transmissor, id da mensagem). Os
+// fragmentos podem chegar em qualquer ordem e repetidos: um bitmap marca
+// os já recebidos e o deslocamento vem do índice. A mensagem completa vai
+// para o handler uma vez; a que não completar em REASSEMBLY_TIMEOUT_MS é
+// descartada. Com todos os slots ocupados, um fragmento de mensagem nova
+// descarta a mais antiga. As últimas mensagens completas ficam lembradas
+// por REASSEMBLY_TIMEOUT_MS, para que uma cópia atrasada de um fragmento
+// não abra um slot (e derrube uma mensagem em andamento) à toa.
+//
+// Não faz alocação dinâmica e não depende do Arduino: roda no PC, com
+// perda e reordenação injetadas (ver tools/lora_sim.cpp).
+
+#ifndef REASSEMBLY_SLOTS
+#define REASSEMBLY_SLOTS 4          // Mensagens simultâneas, ~730 bytes cada
+#endif
+#ifndef REASSEMBLY_TIMEOUT_MS
+#define REASSEMBLY_TIMEOUT_MS 5000  // Prazo desde o primeiro fragmento
+#endif
+
+#define REASSEMBLY_RECENT (REASSEMBLY_SLOTS * 2)
+
+static_assert(FRAME_FRAGMENT_MAX_COUNT <= 16, "bitmap de fragmentos tem 16 bits");
+
+// Mensagem remontada entregue ao handler
+struct ReassembledMessage {
+    uint16_t device_addr;
+    uint16_t sequence;          // Sequência do header dos fragmentos
+    uint8_t type;               // FRAME_TYPE_* da mensagem
+    const uint8_t *data;        // Válido apenas durante o callback
+    size_t length;
+};
+
+typedef void (*MessageHandler)(const ReassembledMessage &message, void *context);
+
+struct ReassemblyStats {
+    uint32_t fragments;         // Fragmentos aceitos
+    uint32_t duplicates;        // Fragmentos repetidos
+    uint32_t invalid;           // Fragmentos que não batem com a mensagem em andamento
+    uint32_t completed;         // Mensagens entregues
+    uint32_t expired;           // Mensagens descartadas por prazo
+    uint32_t evicted;           // Mensagens descartadas por falta de slot
+};
+
+class Reassembler {
+private:
+    struct Slot {
+        uint8_t data[FRAME_MESSAGE_MAX_SIZE];
+        uint32_t startedMs;
+        uint16_t received;      // Bit i = fragmento i já chegou
+        uint16_t lastLength;    // Tamanho do último fragmento (0 = ainda não chegou)
+        uint16_t device_addr;
+        uint16_t sequence;
+        uint8_t messageId;
+        uint8_t type;
+        uint8_t count;
+        bool used;
+    };
+
+    // Mensagem completa há pouco
+    struct Recent {
+        uint32_t completedMs;
+        uint16_t device_addr;
+        uint16_t sequence;
+        uint8_t messageId;
+        bool used;
+    };
+
+    Slot slots[REASSEMBLY_SLOTS];
+    Recent recent[REASSEMBLY_RECENT];
+    size_t recentNext;          // Próxima posição a sobrescrever
+    MessageHandler handler;
+    void *handlerContext;
+    ReassemblyStats stats;
+
+    Slot *findSlot(uint16_t deviceAddr, uint8_t messageId);
+    Slot *claimSlot(uint32_t nowMs);
+    bool recentlyCompleted(uint16_t deviceAddr, uint8_t messageId, uint16_t sequence, uint32_t nowMs) const;
+    void rememberCompleted(const Slot &slot, uint32_t nowMs);
+
+public:
+    Reassembler(MessageHandler handler, void *context);
+    void reset();
+
+    // Guarda um fragmento já validado pelo CRC do frame
+    FrameStatus push(const FrameHeader &header, const uint8_t *payload, uint32_t nowMs);
+
+    // Descarta as mensagens vencidas; chamar periodicamente
+    void expire(uint32_t nowMs);
+
+    size_t pendingCount() const;
+    const ReassemblyStats &getStats() const { return stats; }
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Buffer circular de capacidade fixa (sem alocação dinâmica).
+// Capacity deve ser potência de 2 para que o índice use máscara.
+template <typename T, size_t Capacity>
+class RingBuffer {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "RingBuffer: capacidade deve ser potencia de 2");
+
+private:
+    T items[Capacity];
+    size_t head;    // Próxima posição de escrita (contador livre)
+    size_t tail;    // Próxima posição de leitura (contador livre)
+
+public:
+    RingBuffer() : head(0), tail(0) {}
+
+    bool push(const T &item) {
+        if (full()) {
+            return false;
+        }
+        items[head & (Capacity - 1)] = item;
+        head++;
+        return true;
+    }
+
+    bool pop(T &item) {
+        if (empty()) {
+            return false;
+        }
+        item = items[tail & (Capacity - 1)];
+        tail++;
+        return true;
+    }
+
+    // Escreve até count itens; retorna quantos couberam
+    size_t write(const T *data, size_t count) {
+        size_t written = 0;
+        while (written < count && push(data[written])) {
+            written++;
+        }
+        return written;
+    }
+
+    // Lê até count itens; retorna quantos foram lidos
+    size_t read(T *data, size_t count) {
+        size_t readCount = 0;
+        while (readCount < count && pop(data[readCount])) {
+            readCount++;
+        }
+        return readCount;
+    }
+
+    // Copia até count itens sem removê-los; retorna quantos foram copiados
+    size_t peek(T *data, size_t count) const {
+        size_t peeked = 0;
+        while (peeked < count && peeked < size()) {
+            data[peeked] = items[(tail + peeked) & (Capacity - 1)];
+            peeked++;
+        }
+        return peeked;
+    }
+
+    // Item index a partir do início, sem removê-lo (index < size())
+    const T &at(size_t index) const { return items[(tail + index) & (Capacity - 1)]; }
+
+    // Remove até count itens do início
+    void discard(size_t count) {
+        tail += count < size() ? count : size();
+    }
+
+    size_t size() const { return head - tail; }
+    size_t available() const { return Capacity - size(); }
+    bool empty() const { return head == tail; }
+    bool full() const { return size() == Capacity; }
+    void clear() { tail = head; }
+    static size_t capacity() { return Capacity; }
+};
+
+#endif
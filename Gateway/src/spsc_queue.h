@@ -0,0 +1,78 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Fila lock-free de capacidade fixa para exatamente um produtor e um
+// consumidor (por exemplo, tarefas em núcleos diferentes do ESP32).
+// O produtor só escreve head e o consumidor só escreve tail; a ordem
+// acquire/release garante que o item esteja visível antes do índice.
+// Capacity deve ser potência de 2.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue: capacidade deve ser potencia de 2");
+
+private:
+    T items[Capacity];
+    std::atomic<size_t> head;       // Próxima escrita (produtor)
+    std::atomic<size_t> tail;       // Próxima leitura (consumidor)
+
+    // Contabilidade (escrita apenas pelo produtor)
+    std::atomic<uint32_t> pushed;
+    std::atomic<uint32_t> dropped;
+    std::atomic<uint32_t> highWater;
+
+public:
+    SpscQueue() : head(0), tail(0), pushed(0), dropped(0), highWater(0) {}
+
+    // Produtor: retorna false (e contabiliza o descarte) se a fila estiver cheia
+    bool push(const T &item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_acquire);
+        if (h - t >= Capacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        items[h & (Capacity - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+
+        pushed.fetch_add(1, std::memory_order_relaxed);
+        uint32_t depth = (uint32_t)(h + 1 - t);
+        if (depth > highWater.load(std::memory_order_relaxed)) {
+            highWater.store(depth, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // Consumidor
+    bool pop(T &item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        if (h == t) {
+            return false;
+        }
+
+        item = items[t & (Capacity - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    // Do produtor: só o consumidor esvazia, então "não cheia" vale até o próximo push
+    bool full() const { return size() >= Capacity; }
+    void countDropped() { dropped.fetch_add(1, std::memory_order_relaxed); }
+    static size_t capacity() { return Capacity; }
+
+    uint32_t pushedCount() const { return pushed.load(std::memory_order_relaxed); }
+    uint32_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+    uint32_t highWatermark() const { return highWater.load(std::memory_order_relaxed); }
+};
+
+#endif
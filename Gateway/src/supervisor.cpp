@@ -0,0 +1,80 @@
+#include "supervisor.h"
+#include "log.h"
+
+const char *subsystemStateName(SubsystemState state) {
+    switch (state) {
+        case SUBSYSTEM_UP: return "up";
+        case SUBSYSTEM_DEGRADED: return "degraded";
+        case SUBSYSTEM_DOWN: return "down";
+        case SUBSYSTEM_RECOVERING: return "recovering";
+    }
+    return "?";
+}
+
+SubsystemHealth::SubsystemHealth(const char *name, uint8_t faultThreshold, uint32_t minBackoffMs, uint32_t maxBackoffMs)
+    : name(name), faultThreshold(faultThreshold), minBackoffMs(minBackoffMs), maxBackoffMs(maxBackoffMs),
+      state(SUBSYSTEM_UP), consecutiveFaults(0), backoffMs(minBackoffMs), retryAt(0), lastFault(nullptr),
+      faults(0), reinits(0) {
+}
+
+void SubsystemHealth::reportHealthy() {
+    if (state == SUBSYSTEM_UP) {
+        return;
+    }
+    if (state == SUBSYSTEM_RECOVERING) {
+        LOG_INFO("✅ %s recuperado após %u reinicialização(ões)", name, reinits);
+    }
+    state = SUBSYSTEM_UP;
+    consecutiveFaults = 0;
+    backoffMs = minBackoffMs;
+}
+
+void SubsystemHealth::reportFault(const char *reason, uint32_t now) {
+    faults++;
+    lastFault = reason;
+    if (consecutiveFaults < 255) {
+        consecutiveFaults++;
+    }
+
+    // Depois de uma reinicialização, qualquer falha já conta como nova queda
+    if (state == SUBSYSTEM_RECOVERING || consecutiveFaults >= faultThreshold) {
+        state = SUBSYSTEM_DOWN;
+    } else {
+        state = SUBSYSTEM_DEGRADED;
+    }
+    scheduleRetry(now);
+    LOG_WARN("⚠️  %s com falha: %s (%s, nova tentativa em %u ms)", name, reason, subsystemStateName(state),
+             retryDelayMs(now));
+}
+
+void SubsystemHealth::markDown(const char *reason, uint32_t now) {
+    faults++;
+    lastFault = reason;
+    consecutiveFaults = faultThreshold;
+    state = SUBSYSTEM_DOWN;
+    scheduleRetry(now);
+    LOG_ERROR("❌ %s fora do ar: %s (reinicialização em %u ms)", name, reason, retryDelayMs(now));
+}
+
+void SubsystemHealth::reinitDone(bool ok, uint32_t now) {
+    reinits++;
+    if (ok) {
+        state = SUBSYSTEM_RECOVERING;
+    } else {
+        markDown("reinicialização falhou", now);
+    }
+}
+
+void SubsystemHealth::scheduleRetry(uint32_t now) {
+    retryAt = now + backoffMs;
+    backoffMs = backoffMs > maxBackoffMs / 2 ? maxBackoffMs : backoffMs * 2;
+}
+
+uint32_t SubsystemHealth::retryDelayMs(uint32_t now) const {
+    return retryDue(now) ? 0 : retryAt - now;
+}
+
+void SubsystemHealth::print(Print &out) const {
+    out.printf("%s %s faults=%lu reinits=%lu last_fault=%s\n", name, subsystemStateName(state),
+               (unsigned long)faults, (unsigned long)reinits, lastFault != nullptr ? lastFault : "-");
+}
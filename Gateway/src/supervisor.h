@@ -0,0 +1,64 @@
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include <Arduino.h>
+
+// Saúde de um subsistema do Gateway (rádio LoRa ou rede). Quem avalia é a
+// tarefa dona do subsistema, que também faz a reinicialização: uma falha
+// só reinicializa aquele subsistema, com espera exponencial entre as
+// tentativas, enquanto a fila, a outbox e o outro subsistema seguem
+// funcionando. Substitui o ESP.restart(), que perdia as leituras em RAM e
+// deixava o canal sem escuta durante o boot.
+//
+//   UP --falha--> DEGRADED --N falhas seguidas--> DOWN
+//   DOWN --reinicialização--> RECOVERING --verificação boa--> UP
+//   RECOVERING --falha--> DOWN (espera dobra até o máximo)
+
+enum SubsystemState : uint8_t {
+    SUBSYSTEM_UP,
+    SUBSYSTEM_DEGRADED,   // Falhou, mas ainda abaixo do limite para reinicializar
+    SUBSYSTEM_DOWN,       // Aguardando a espera para reinicializar
+    SUBSYSTEM_RECOVERING  // Reinicializado, aguardando a primeira verificação boa
+};
+
+const char *subsystemStateName(SubsystemState state);
+
+class SubsystemHealth {
+private:
+    const char *name;
+    uint8_t faultThreshold;
+    uint32_t minBackoffMs;
+    uint32_t maxBackoffMs;
+    SubsystemState state;
+    uint8_t consecutiveFaults;
+    uint32_t backoffMs;         // Próxima espera
+    uint32_t retryAt;           // millis() a partir do qual pode tentar de novo
+    const char *lastFault;      // Literal com o motivo da última falha
+    uint32_t faults;
+    uint32_t reinits;
+
+    void scheduleRetry(uint32_t now);
+
+public:
+    // Os campos são escritos só pela tarefa dona; o comando "health" lê sem trava
+    SubsystemHealth(const char *name, uint8_t faultThreshold, uint32_t minBackoffMs, uint32_t maxBackoffMs);
+    void reportHealthy();
+    void reportFault(const char *reason, uint32_t now);
+    // Falha que já exige reinicialização (ex.: a própria inicialização falhou)
+    void markDown(const char *reason, uint32_t now);
+    void reinitDone(bool ok, uint32_t now);
+
+    bool needsReinit() const { return state == SUBSYSTEM_DOWN; }
+    bool retryDue(uint32_t now) const { return (int32_t)(now - retryAt) >= 0; }
+    uint32_t retryDelayMs(uint32_t now) const;
+
+    const char *getName() const { return name; }
+    SubsystemState getState() const { return state; }
+    const char *getLastFault() const { return lastFault; }
+    uint32_t getFaults() const { return faults; }
+    uint32_t getReinits() const { return reinits; }
+
+    void print(Print &out) const;
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include "uplink_codec.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+ReceivedData toReceivedData(const ReadingFrame &reading) {
+    ReceivedData data;
+    data.device_addr = reading.device_addr;
+    data.heart_rate = reading.heart_rate;
+    data.oxygen_level = reading.oxygen_level;
+    data.temperature = frameTemperatureFromCenti(reading.temperature_centi);
+    return data;
+}
+
+struct DeviceIdAlias {
+    uint16_t device_addr;
+    const char *id;
+};
+
+static const DeviceIdAlias deviceIdAliases[] = { DEVICE_ID_ALIASES };
+
+const char *deviceIdAlias(uint16_t deviceAddr) {
+    for (size_t i = 0; i < sizeof(deviceIdAliases) / sizeof(deviceIdAliases[0]); i++) {
+        if (deviceIdAliases[i].device_addr == deviceAddr) {
+            return deviceIdAliases[i].id;
+        }
+    }
+    return nullptr;
+}
+
+void formatDeviceId(uint16_t deviceAddr, char *out, size_t size) {
+    const char *alias = deviceIdAlias(deviceAddr);
+    if (alias != nullptr) {
+        snprintf(out, size, "%s", alias);
+    } else {
+        snprintf(out, size, "TR-%03u", deviceAddr);
+    }
+}
+
+static void appendReadingJSON(String &json, const ReceivedData &data) {
+    // Temperatura a partir dos centésimos, sem zeros à direita (36.5, não
+    // 36.50), como o ArduinoJson escrevia
+    char deviceId[DEVICE_ID_SIZE];
+    formatDeviceId(data.device_addr, deviceId, sizeof(deviceId));
+    int centi = frameTemperatureToCenti(data.temperature);
+    unsigned magnitude = (unsigned)abs(centi);
+    char temperature[12];
+    if (magnitude % 100 == 0) {
+        snprintf(temperature, sizeof(temperature), "%s%u", centi < 0 ? "-" : "", magnitude / 100);
+    } else if (magnitude % 10 == 0) {
+        snprintf(temperature, sizeof(temperature), "%s%u.%u", centi < 0 ? "-" : "", magnitude / 100,
+                 magnitude % 100 / 10);
+    } else {
+        snprintf(temperature, sizeof(temperature), "%s%u.%02u", centi < 0 ? "-" : "", magnitude / 100,
+                 magnitude % 100);
+    }
+
+    char item[JSON_READING_MAX_SIZE];
+    snprintf(item, sizeof(item), "{\"transmitter_id\":\"%s\",\"temperature\":%s,\"heart_rate\":%d,\"oxygen_level\":%d}",
+             deviceId, temperature, data.heart_rate, data.oxygen_level);
+    json += item;
+}
+
+String createReadingJSON(const ReceivedData &data) {
+    String jsonString;
+    jsonString.reserve(JSON_READING_MAX_SIZE);
+    appendReadingJSON(jsonString, data);
+    return jsonString;
+}
+
+size_t createReadingsCBOR(const ReceivedData *items, size_t count, bool asArray, uint8_t *out, size_t capacity) {
+    // Mapa com chaves inteiras por leitura (ver CBOR_KEY_* em uplink_codec.h);
+    // ~15 bytes contra ~80 do JSON equivalente. Transmissores com alias
+    // levam também o ID em texto, que o servidor usa no lugar do endereço
+    CborWriter writer(out, capacity);
+    if (asArray) {
+        writer.writeArray(count);
+    }
+    for (size_t i = 0; i < count; i++) {
+        const char *alias = deviceIdAlias(items[i].device_addr);
+        writer.writeMap(alias != nullptr ? 5 : 4);
+        writer.writeUnsigned(CBOR_KEY_TRANSMITTER);
+        writer.writeUnsigned(items[i].device_addr);
+        writer.writeUnsigned(CBOR_KEY_TEMPERATURE);
+        writer.writeSigned(frameTemperatureToCenti(items[i].temperature));
+        writer.writeUnsigned(CBOR_KEY_HEART_RATE);
+        writer.writeSigned(items[i].heart_rate);
+        writer.writeUnsigned(CBOR_KEY_OXYGEN_LEVEL);
+        writer.writeSigned(items[i].oxygen_level);
+        if (alias != nullptr) {
+            // Chaves em ordem crescente; o ID com o mesmo corte do JSON
+            char deviceId[DEVICE_ID_SIZE];
+            formatDeviceId(items[i].device_addr, deviceId, sizeof(deviceId));
+            writer.writeUnsigned(CBOR_KEY_TRANSMITTER_ID);
+            writer.writeText(deviceId);
+        }
+    }
+    
+    return writer.ok() ? writer.size() : 0;
+}
+
+String createBatchJSON(const ReceivedData *items, size_t count) {
+    // Array com os mesmos campos do envio individual, escrito numa String
+    // reservada de uma vez
+    String jsonString;
+    jsonString.reserve(2 + count * (JSON_READING_MAX_SIZE + 1));
+    jsonString += '[';
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) {
+            jsonString += ',';
+        }
+        appendReadingJSON(jsonString, items[i]);
+    }
+    jsonString += ']';
+    
+    return jsonString;
+}
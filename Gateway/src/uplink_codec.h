@@ -0,0 +1,57 @@
+#ifndef UPLINK_CODEC_H
+#define UPLINK_CODEC_H
+
+#include <Arduino.h>
+#include "frame.h"
+#include "cbor.h"
+
+// Serialização das leituras enviadas à API (JSON e CBOR), separada do
+// NetworkManager para poder ser medida pelo comando "bench". Não depende
+// do ESP32 nem do ArduinoJson: o bench do host mede os mesmos codificadores.
+
+#define CBOR_CONTENT_TYPE "application/cbor"
+
+// Chaves inteiras de cada leitura no corpo CBOR (um mapa por leitura;
+// lotes são um array de mapas)
+#define CBOR_KEY_TRANSMITTER 1   // Endereço LoRa do transmissor (0x0005 = "TR-005")
+#define CBOR_KEY_TEMPERATURE 2   // Temperatura em 0,01 °C
+#define CBOR_KEY_HEART_RATE 3    // bpm
+#define CBOR_KEY_OXYGEN_LEVEL 4  // SpO2 em %
+#define CBOR_KEY_TRANSMITTER_ID 5 // ID em texto, só para transmissores em DEVICE_ID_ALIASES
+#define CBOR_READING_MAX_SIZE 28 // Maior mapa CBOR de uma leitura (com o ID em texto)
+#define JSON_READING_MAX_SIZE 96 // Maior objeto JSON de uma leitura
+
+// Estrutura para dados recebidos
+struct ReceivedData {
+    uint16_t device_addr;  // Endereço LoRa do transmissor (ID "TR-005" gerado no envio)
+    int heart_rate;
+    int oxygen_level;
+    float temperature;
+};
+
+// Converte uma leitura decodificada para o formato enviado à API
+ReceivedData toReceivedData(const ReadingFrame &reading);
+
+// ID do transmissor usado pela API: "TR-%03u" do endereço LoRa ("TR-005"
+// para 0x0005), exceto os transmissores que a API já conhecia por outro ID
+// antes dos frames binários. O Transmitter de endereço 0x0002 mandava
+// "TR-001" no JSON legado, e é com esse ID que o servidor guarda o histórico.
+// DEVICE_ID_ALIASES é uma lista de pares {endereço, "ID"}. O JSON legado
+// continua usando os dígitos do próprio ID ("TR-001" -> 0x0001), então não
+// use num transmissor binário o endereço que daria o mesmo ID de um alias.
+#define DEVICE_ID_SIZE 12
+#ifndef DEVICE_ID_ALIASES
+#define DEVICE_ID_ALIASES { 0x0002, "TR-001" }
+#endif
+
+void formatDeviceId(uint16_t deviceAddr, char *out, size_t size);
+// ID de DEVICE_ID_ALIASES para o endereço, ou nullptr
+const char *deviceIdAlias(uint16_t deviceAddr);
+
+String createReadingJSON(const ReceivedData &data);
+String createBatchJSON(const ReceivedData *items, size_t count);
+// Retorna o tamanho gerado, ou 0 se não couber em capacity (o buffer do
+// NetworkManager comporta UPLINK_BATCH_SIZE leituras)
+size_t createReadingsCBOR(const ReceivedData *items, size_t count, bool asArray, uint8_t *out, size_t capacity);
+
+#endif
@@ -0,0 +1,79 @@
+// Confirmações pendentes (ack_tracker.h): janela, atraso depois da rajada e
+// leituras marcadas só quando a outbox as guarda. Roda no host: pio test -e native
+#include <unity.h>
+#include "ack_tracker.h"
+
+#define DELAY_MS 400
+
+static AckTracker tracker;
+
+void setUp() {
+    tracker.reset();
+}
+
+void tearDown() {}
+
+static void test_ack_waits_for_silence() {
+    tracker.record(0x0002, 10, 1000);
+    tracker.record(0x0002, 11, 1220);
+    TEST_ASSERT_EQUAL_UINT32(DELAY_MS, tracker.nextDueMs(1220, DELAY_MS));
+
+    AckFrame ack;
+    TEST_ASSERT_FALSE(tracker.takeDue(1619, DELAY_MS, ack));
+    TEST_ASSERT_TRUE(tracker.takeDue(1620, DELAY_MS, ack));
+    TEST_ASSERT_EQUAL_UINT16(0x0002, ack.device_addr);
+    TEST_ASSERT_EQUAL_UINT16(10, ack.base);
+    TEST_ASSERT_EQUAL_HEX32(0x3, ack.bitmap);
+    TEST_ASSERT_EQUAL_size_t(0, tracker.pendingCount());
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, tracker.nextDueMs(1620, DELAY_MS));
+}
+
+static void test_touch_postpones_pending_ack() {
+    // Leitura guardada, mas o transmissor continua a rajada
+    tracker.record(5, 1, 0);
+    tracker.touch(5, 300);
+    AckFrame ack;
+    TEST_ASSERT_FALSE(tracker.takeDue(DELAY_MS, DELAY_MS, ack));
+    TEST_ASSERT_EQUAL_UINT32(100, tracker.nextDueMs(600, DELAY_MS));
+    TEST_ASSERT_TRUE(tracker.takeDue(700, DELAY_MS, ack));
+
+    // Sem confirmação pendente, touch não abre slot
+    tracker.touch(6, 800);
+    TEST_ASSERT_EQUAL_size_t(0, tracker.pendingCount());
+}
+
+static void test_late_record_keeps_latest_time() {
+    // A duplicata de uma leitura já guardada foi marcada agora; a leitura
+    // seguinte chega da outbox com o horário de recepção, mais antigo, e
+    // não adianta o ack
+    tracker.record(7, 19, 1000);
+    tracker.record(7, 20, 600);
+    AckFrame ack;
+    TEST_ASSERT_FALSE(tracker.takeDue(1300, DELAY_MS, ack));
+    TEST_ASSERT_TRUE(tracker.takeDue(1400, DELAY_MS, ack));
+    TEST_ASSERT_EQUAL_UINT16(19, ack.base);
+    TEST_ASSERT_EQUAL_HEX32(0x3, ack.bitmap);
+}
+
+static void test_oldest_transmitter_loses_slot() {
+    for (uint16_t device = 0; device < ACK_TRACKER_SLOTS; device++) {
+        tracker.record(device, 1, 100 + device);
+    }
+    tracker.record(100, 1, 500);
+    TEST_ASSERT_EQUAL_size_t(ACK_TRACKER_SLOTS, tracker.pendingCount());
+    TEST_ASSERT_EQUAL_UINT32(1, tracker.getStats().evicted);
+
+    // O transmissor 0 saiu; o 1 é o próximo a vencer
+    AckFrame ack;
+    TEST_ASSERT_TRUE(tracker.takeDue(1000, DELAY_MS, ack));
+    TEST_ASSERT_EQUAL_UINT16(1, ack.device_addr);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_ack_waits_for_silence);
+    RUN_TEST(test_touch_postpones_pending_ack);
+    RUN_TEST(test_late_record_keeps_latest_time);
+    RUN_TEST(test_oldest_transmitter_loses_slot);
+    return UNITY_END();
+}
@@ -0,0 +1,263 @@
+// Escritor CBOR (cbor.h) conferido com os exemplos do apêndice A da RFC 8949
+// e com um decodificador independente, escrito aqui a partir da RFC.
+// Roda no host: pio test -e native
+#include <unity.h>
+#include <string.h>
+#include "cbor.h"
+
+void setUp() {}
+void tearDown() {}
+
+// Decodificador de referência: só inteiros, arrays e mapas, com a forma
+// mais curta exigida (modo determinístico da RFC 8949, seção 4.2.1)
+struct CborReader {
+    const uint8_t *data;
+    size_t length;
+    size_t position;
+    bool error;
+};
+
+static bool readHead(CborReader &reader, uint8_t &major, uint64_t &argument) {
+    if (reader.position >= reader.length) {
+        reader.error = true;
+        return false;
+    }
+    uint8_t initial = reader.data[reader.position++];
+    major = initial >> 5;
+    uint8_t info = initial & 0x1F;
+    size_t extra = 0;
+    if (info < 24) {
+        argument = info;
+        return true;
+    }
+    switch (info) {
+        case 24: extra = 1; break;
+        case 25: extra = 2; break;
+        case 26: extra = 4; break;
+        case 27: extra = 8; break;
+        default: reader.error = true; return false;
+    }
+    if (reader.position + extra > reader.length) {
+        reader.error = true;
+        return false;
+    }
+    argument = 0;
+    for (size_t i = 0; i < extra; i++) {
+        argument = (argument << 8) | reader.data[reader.position++];
+    }
+    // Forma mais curta: o argumento não caberia num cabeçalho menor
+    uint64_t minimum = extra == 1 ? 24 : (uint64_t)1 << (4 * extra);
+    if (argument < minimum) {
+        reader.error = true;
+        return false;
+    }
+    return true;
+}
+
+static int64_t readInteger(CborReader &reader) {
+    uint8_t major;
+    uint64_t argument;
+    if (!readHead(reader, major, argument)) {
+        return 0;
+    }
+    if (major == 0) {
+        return (int64_t)argument;
+    }
+    if (major == 1) {
+        return -1 - (int64_t)argument;
+    }
+    reader.error = true;
+    return 0;
+}
+
+static uint64_t readContainer(CborReader &reader, uint8_t expectedMajor) {
+    uint8_t major;
+    uint64_t argument;
+    if (!readHead(reader, major, argument) || major != expectedMajor) {
+        reader.error = true;
+        return 0;
+    }
+    return argument;
+}
+
+static CborReader reader(const uint8_t *data, size_t length) {
+    CborReader cbor = { data, length, 0, false };
+    return cbor;
+}
+
+static void assertEncoding(const uint8_t *expected, size_t expectedLength, const uint8_t *actual, size_t length) {
+    TEST_ASSERT_EQUAL_size_t(expectedLength, length);
+    TEST_ASSERT_EQUAL_MEMORY(expected, actual, expectedLength);
+}
+
+static void test_unsigned_rfc8949_examples() {
+    struct { uint32_t value; uint8_t bytes[5]; size_t length; } examples[] = {
+        { 0, { 0x00 }, 1 },
+        { 1, { 0x01 }, 1 },
+        { 10, { 0x0a }, 1 },
+        { 23, { 0x17 }, 1 },
+        { 24, { 0x18, 0x18 }, 2 },
+        { 25, { 0x18, 0x19 }, 2 },
+        { 100, { 0x18, 0x64 }, 2 },
+        { 1000, { 0x19, 0x03, 0xe8 }, 3 },
+        { 1000000, { 0x1a, 0x00, 0x0f, 0x42, 0x40 }, 5 },
+        { 4294967295u, { 0x1a, 0xff, 0xff, 0xff, 0xff }, 5 },
+    };
+    for (size_t i = 0; i < sizeof(examples) / sizeof(examples[0]); i++) {
+        uint8_t buffer[8];
+        CborWriter writer(buffer, sizeof(buffer));
+        writer.writeUnsigned(examples[i].value);
+        TEST_ASSERT_TRUE(writer.ok());
+        assertEncoding(examples[i].bytes, examples[i].length, buffer, writer.size());
+    }
+}
+
+static void test_signed_rfc8949_examples() {
+    struct { int32_t value; uint8_t bytes[5]; size_t length; } examples[] = {
+        { -1, { 0x20 }, 1 },
+        { -10, { 0x29 }, 1 },
+        { -100, { 0x38, 0x63 }, 2 },
+        { -1000, { 0x39, 0x03, 0xe7 }, 3 },
+        { 500, { 0x19, 0x01, 0xf4 }, 3 },
+        { INT32_MIN, { 0x3a, 0x7f, 0xff, 0xff, 0xff }, 5 },
+    };
+    for (size_t i = 0; i < sizeof(examples) / sizeof(examples[0]); i++) {
+        uint8_t buffer[8];
+        CborWriter writer(buffer, sizeof(buffer));
+        writer.writeSigned(examples[i].value);
+        assertEncoding(examples[i].bytes, examples[i].length, buffer, writer.size());
+    }
+}
+
+static void test_containers_rfc8949_examples() {
+    // [1, [2, 3], [4, 5]] e {1: 2, 3: 4}
+    const uint8_t nested[] = { 0x83, 0x01, 0x82, 0x02, 0x03, 0x82, 0x04, 0x05 };
+    const uint8_t map[] = { 0xa2, 0x01, 0x02, 0x03, 0x04 };
+    uint8_t buffer[16];
+
+    CborWriter array(buffer, sizeof(buffer));
+    array.writeArray(3);
+    array.writeUnsigned(1);
+    array.writeArray(2);
+    array.writeUnsigned(2);
+    array.writeUnsigned(3);
+    array.writeArray(2);
+    array.writeUnsigned(4);
+    array.writeUnsigned(5);
+    assertEncoding(nested, sizeof(nested), buffer, array.size());
+
+    CborWriter object(buffer, sizeof(buffer));
+    object.writeMap(2);
+    object.writeUnsigned(1);
+    object.writeUnsigned(2);
+    object.writeUnsigned(3);
+    object.writeUnsigned(4);
+    assertEncoding(map, sizeof(map), buffer, object.size());
+
+    // 25 itens já não cabem no cabeçalho curto
+    const uint8_t long25[] = { 0x98, 0x19 };
+    CborWriter longArray(buffer, sizeof(buffer));
+    longArray.writeArray(25);
+    assertEncoding(long25, sizeof(long25), buffer, longArray.size());
+}
+
+static void test_text_rfc8949_examples() {
+    // "", "a", "IETF" e um texto de 24 bytes (cabeçalho de 2 bytes)
+    struct { const char *text; uint8_t bytes[8]; size_t length; } examples[] = {
+        { "", { 0x60 }, 1 },
+        { "a", { 0x61, 0x61 }, 2 },
+        { "IETF", { 0x64, 0x49, 0x45, 0x54, 0x46 }, 5 },
+    };
+    for (size_t i = 0; i < sizeof(examples) / sizeof(examples[0]); i++) {
+        uint8_t buffer[8];
+        CborWriter writer(buffer, sizeof(buffer));
+        writer.writeText(examples[i].text);
+        assertEncoding(examples[i].bytes, examples[i].length, buffer, writer.size());
+    }
+
+    uint8_t buffer[32];
+    CborWriter writer(buffer, sizeof(buffer));
+    writer.writeText("abcdefghijklmnopqrstuvwx");
+    TEST_ASSERT_EQUAL_size_t(26, writer.size());
+    TEST_ASSERT_EQUAL_HEX8(0x78, buffer[0]);
+    TEST_ASSERT_EQUAL_HEX8(24, buffer[1]);
+    TEST_ASSERT_EQUAL_MEMORY("abcdefghijklmnopqrstuvwx", buffer + 2, 24);
+
+    // Texto maior que o buffer: overflow, sem escrever além
+    CborWriter small(buffer, 3);
+    small.writeText("TR-001");
+    TEST_ASSERT_FALSE(small.ok());
+    TEST_ASSERT_EQUAL_size_t(3, small.size());
+}
+
+static void test_reading_document_decodes() {
+    // Mesma forma do corpo de leituras do uplink: array de mapas com chaves inteiras
+    const int32_t values[][5] = {
+        { 2, 1234, 72, 97, 3650 },
+        { 513, 65535, 0, 255, -1250 },
+        { 65535, 0, 23, 24, -32768 },
+    };
+    const size_t count = sizeof(values) / sizeof(values[0]);
+    uint8_t buffer[128];
+    CborWriter writer(buffer, sizeof(buffer));
+    writer.writeArray(count);
+    for (size_t i = 0; i < count; i++) {
+        writer.writeMap(5);
+        for (uint32_t key = 0; key < 5; key++) {
+            writer.writeUnsigned(key);
+            writer.writeSigned(values[i][key]);
+        }
+    }
+    TEST_ASSERT_TRUE(writer.ok());
+
+    CborReader cbor = reader(buffer, writer.size());
+    TEST_ASSERT_EQUAL_UINT32(count, readContainer(cbor, 4));
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_UINT32(5, readContainer(cbor, 5));
+        for (int32_t key = 0; key < 5; key++) {
+            TEST_ASSERT_EQUAL(key, readInteger(cbor));
+            TEST_ASSERT_EQUAL(values[i][key], readInteger(cbor));
+        }
+    }
+    TEST_ASSERT_FALSE(cbor.error);
+    TEST_ASSERT_EQUAL_size_t(writer.size(), cbor.position);
+}
+
+static void test_every_argument_size_decodes() {
+    // Todas as fronteiras de tamanho do cabeçalho, nos dois sinais
+    const int64_t edges[] = { 0, 23, 24, 255, 256, 65535, 65536, INT32_MAX,
+                              -1, -24, -25, -256, -257, -65536, -65537, INT32_MIN };
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+        uint8_t buffer[8];
+        CborWriter writer(buffer, sizeof(buffer));
+        writer.writeSigned((int32_t)edges[i]);
+        CborReader cbor = reader(buffer, writer.size());
+        TEST_ASSERT_EQUAL(edges[i], readInteger(cbor));
+        TEST_ASSERT_FALSE(cbor.error);
+        TEST_ASSERT_EQUAL_size_t(writer.size(), cbor.position);
+    }
+}
+
+static void test_overflow_is_reported() {
+    uint8_t buffer[4];
+    memset(buffer, 0xEE, sizeof(buffer));
+    CborWriter writer(buffer, 3);
+    writer.writeUnsigned(1);
+    TEST_ASSERT_TRUE(writer.ok());
+    writer.writeUnsigned(1000000);
+    TEST_ASSERT_FALSE(writer.ok());
+    TEST_ASSERT_LESS_OR_EQUAL(3, writer.size());
+    TEST_ASSERT_EQUAL_HEX8(0xEE, buffer[3]);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_unsigned_rfc8949_examples);
+    RUN_TEST(test_signed_rfc8949_examples);
+    RUN_TEST(test_containers_rfc8949_examples);
+    RUN_TEST(test_text_rfc8949_examples);
+    RUN_TEST(test_reading_document_decodes);
+    RUN_TEST(test_every_argument_size_decodes);
+    RUN_TEST(test_overflow_is_reported);
+    return UNITY_END();
+}
@@ -0,0 +1,120 @@
+// Janela de sequências (dedup.h): duplicatas, fora de ordem, volta do
+// contador de 16 bits e reinício da numeração. Roda no host: pio test -e native
+#include <unity.h>
+#include <string.h>
+#include "dedup.h"
+
+static SequenceWindow window;
+
+void setUp() {
+    memset(&window, 0, sizeof(window));
+}
+
+void tearDown() {}
+
+static void test_first_sequence_starts_window() {
+    TEST_ASSERT_TRUE(sequenceAccept(window, 500));
+    TEST_ASSERT_TRUE(window.started);
+    TEST_ASSERT_EQUAL_UINT16(500, window.highest);
+    TEST_ASSERT_EQUAL_UINT32(1, window.accepted);
+    TEST_ASSERT_FALSE(sequenceAccept(window, 500));
+    TEST_ASSERT_EQUAL_UINT32(1, window.duplicates);
+}
+
+static void test_gaps_counted_and_filled_out_of_order() {
+    TEST_ASSERT_TRUE(sequenceAccept(window, 10));
+    TEST_ASSERT_TRUE(sequenceAccept(window, 14));
+    TEST_ASSERT_EQUAL_UINT32(3, window.gaps);
+
+    // 11..13 chegam atrasadas: aceitas uma vez, fecham as lacunas
+    TEST_ASSERT_TRUE(sequenceAccept(window, 12));
+    TEST_ASSERT_TRUE(sequenceAccept(window, 11));
+    TEST_ASSERT_TRUE(sequenceAccept(window, 13));
+    TEST_ASSERT_EQUAL_UINT32(0, window.gaps);
+    TEST_ASSERT_FALSE(sequenceAccept(window, 12));
+    TEST_ASSERT_FALSE(sequenceAccept(window, 14));
+    TEST_ASSERT_EQUAL_UINT32(5, window.accepted);
+    TEST_ASSERT_EQUAL_UINT32(2, window.duplicates);
+    TEST_ASSERT_EQUAL_UINT16(14, window.highest);
+}
+
+static void test_window_edge() {
+    TEST_ASSERT_TRUE(sequenceAccept(window, 1000));
+    for (uint16_t sequence = 1001; sequence < 1000 + DEDUP_WINDOW; sequence++) {
+        TEST_ASSERT_TRUE(sequenceAccept(window, sequence));
+    }
+    uint16_t highest = 1000 + DEDUP_WINDOW - 1;
+
+    // A mais antiga ainda dentro da janela continua sendo reconhecida
+    TEST_ASSERT_FALSE(sequenceAccept(window, highest - (DEDUP_WINDOW - 1)));
+    TEST_ASSERT_EQUAL_UINT32(1, window.duplicates);
+    TEST_ASSERT_EQUAL_UINT32(0, window.resyncs);
+}
+
+static void test_backward_jump_past_window_resyncs() {
+    TEST_ASSERT_TRUE(sequenceAccept(window, 1000));
+
+    // Um a menos que a janela: ainda cabe no bitmap, é uma lacuna atrasada
+    TEST_ASSERT_TRUE(sequenceAccept(window, 1000 - (DEDUP_WINDOW - 1)));
+    TEST_ASSERT_EQUAL_UINT32(0, window.resyncs);
+
+    // A partir da janela não há como saber: reinicia em vez de descartar
+    TEST_ASSERT_TRUE(sequenceAccept(window, 1000 - DEDUP_WINDOW));
+    TEST_ASSERT_EQUAL_UINT32(1, window.resyncs);
+    TEST_ASSERT_EQUAL_UINT16(1000 - DEDUP_WINDOW, window.highest);
+    TEST_ASSERT_FALSE(sequenceAccept(window, 1000 - DEDUP_WINDOW));
+    TEST_ASSERT_EQUAL_UINT32(1, window.duplicates);
+}
+
+static void test_transmitter_restart_not_muted() {
+    // Transmissor regravado volta a contar do zero: saltos de 64 a 1024
+    // para trás não podem ser tomados como duplicatas
+    const uint16_t jumps[] = { DEDUP_WINDOW, 200, 1023, 1024, 1025, 30000 };
+    for (size_t i = 0; i < sizeof(jumps) / sizeof(jumps[0]); i++) {
+        setUp();
+        uint16_t highest = 40000;
+        TEST_ASSERT_TRUE(sequenceAccept(window, highest));
+        for (uint16_t sequence = highest - jumps[i]; sequence != (uint16_t)(highest - jumps[i] + 5); sequence++) {
+            TEST_ASSERT_TRUE_MESSAGE(sequenceAccept(window, sequence), "leitura após reinício descartada");
+        }
+        TEST_ASSERT_EQUAL_UINT32(1, window.resyncs);
+        TEST_ASSERT_EQUAL_UINT32(0, window.duplicates);
+    }
+}
+
+static void test_sequence_wrap() {
+    TEST_ASSERT_TRUE(sequenceAccept(window, 0xFFFE));
+    TEST_ASSERT_TRUE(sequenceAccept(window, 0xFFFF));
+    TEST_ASSERT_TRUE(sequenceAccept(window, 0x0001));
+    TEST_ASSERT_EQUAL_UINT32(1, window.gaps);
+    TEST_ASSERT_EQUAL_UINT16(0x0001, window.highest);
+
+    // 0x0000 atrasada e 0xFFFF repetida, do outro lado da volta
+    TEST_ASSERT_TRUE(sequenceAccept(window, 0x0000));
+    TEST_ASSERT_FALSE(sequenceAccept(window, 0xFFFF));
+    TEST_ASSERT_FALSE(sequenceAccept(window, 0xFFFE));
+    TEST_ASSERT_EQUAL_UINT32(0, window.gaps);
+    TEST_ASSERT_EQUAL_UINT32(2, window.duplicates);
+    TEST_ASSERT_EQUAL_UINT32(0, window.resyncs);
+}
+
+static void test_forward_jump_past_window_clears_bitmap() {
+    TEST_ASSERT_TRUE(sequenceAccept(window, 100));
+    TEST_ASSERT_TRUE(sequenceAccept(window, 100 + DEDUP_WINDOW + 10));
+    TEST_ASSERT_EQUAL_UINT32(DEDUP_WINDOW + 9, window.gaps);
+    TEST_ASSERT_TRUE(window.window == 1);
+    TEST_ASSERT_TRUE(sequenceAccept(window, 100 + DEDUP_WINDOW + 9));
+    TEST_ASSERT_FALSE(sequenceAccept(window, 100 + DEDUP_WINDOW + 10));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_sequence_starts_window);
+    RUN_TEST(test_gaps_counted_and_filled_out_of_order);
+    RUN_TEST(test_window_edge);
+    RUN_TEST(test_backward_jump_past_window_resyncs);
+    RUN_TEST(test_transmitter_restart_not_muted);
+    RUN_TEST(test_sequence_wrap);
+    RUN_TEST(test_forward_jump_past_window_clears_bitmap);
+    return UNITY_END();
+}
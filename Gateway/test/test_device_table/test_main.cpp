@@ -0,0 +1,118 @@
+// Tabela de transmissores (device_table.h): busca, inserção, duplicatas e
+// comportamento com a tabela cheia. Roda no host: pio test -e native
+#include <unity.h>
+#include "device_table.h"
+
+static DeviceTable table;
+
+static ReadingFrame reading(uint16_t deviceAddr, uint16_t sequence) {
+    ReadingFrame frame;
+    frame.device_addr = deviceAddr;
+    frame.sequence = sequence;
+    frame.heart_rate = 70;
+    frame.oxygen_level = 98;
+    frame.temperature_centi = 3650;
+    return frame;
+}
+
+void setUp() {
+    table.clear();
+}
+
+void tearDown() {}
+
+static void test_find_and_insert() {
+    TEST_ASSERT_NULL(table.find(7));
+    DeviceState *device = table.findOrInsert(7);
+    TEST_ASSERT_NOT_NULL(device);
+    TEST_ASSERT_TRUE(device->used);
+    TEST_ASSERT_EQUAL_UINT16(7, device->device_addr);
+    TEST_ASSERT_EQUAL_PTR(device, table.find(7));
+    TEST_ASSERT_EQUAL_PTR(device, table.findOrInsert(7));
+    TEST_ASSERT_EQUAL_size_t(1, table.size());
+    TEST_ASSERT_NULL(table.find(8));
+}
+
+static void test_record_drops_duplicates_only_with_sequence() {
+    TEST_ASSERT_TRUE(table.record(reading(2, 10), true, 1000));
+    TEST_ASSERT_FALSE(table.record(reading(2, 10), true, 1100));
+    TEST_ASSERT_TRUE(table.record(reading(2, 11), true, 2000));
+
+    // JSON legado não tem sequência: nunca é tomado por duplicata
+    TEST_ASSERT_TRUE(table.record(reading(3, 0), false, 1000));
+    TEST_ASSERT_TRUE(table.record(reading(3, 0), false, 2000));
+
+    const DeviceState *device = table.find(2);
+    TEST_ASSERT_EQUAL_UINT32(2, device->readings);
+    TEST_ASSERT_EQUAL_UINT32(1, device->sequence.duplicates);
+    TEST_ASSERT_EQUAL_UINT32(1000, device->meanIntervalMs);
+    TEST_ASSERT_EQUAL_UINT32(2, table.find(3)->readings);
+}
+
+static void test_full_table_passes_new_devices_untracked() {
+    for (uint16_t addr = 1; addr <= DEVICE_TABLE_MAX_DEVICES; addr++) {
+        TEST_ASSERT_NOT_NULL(table.findOrInsert(addr));
+    }
+    TEST_ASSERT_TRUE(table.isFull());
+    TEST_ASSERT_EQUAL_size_t(DEVICE_TABLE_MAX_DEVICES, table.size());
+
+    // Transmissor novo: passa sem filtro, inclusive repetido, e é contado
+    uint16_t stranger = DEVICE_TABLE_MAX_DEVICES + 100;
+    TEST_ASSERT_NULL(table.findOrInsert(stranger));
+    TEST_ASSERT_TRUE(table.record(reading(stranger, 5), true, 0));
+    TEST_ASSERT_TRUE(table.record(reading(stranger, 5), true, 0));
+    TEST_ASSERT_EQUAL_UINT32(2, table.untrackedCount());
+    TEST_ASSERT_EQUAL_size_t(DEVICE_TABLE_MAX_DEVICES, table.size());
+
+    // Os já conhecidos continuam com controle de duplicatas
+    TEST_ASSERT_TRUE(table.record(reading(1, 5), true, 0));
+    TEST_ASSERT_FALSE(table.record(reading(1, 5), true, 0));
+    TEST_ASSERT_EQUAL_UINT32(2, table.untrackedCount());
+    for (uint16_t addr = 1; addr <= DEVICE_TABLE_MAX_DEVICES; addr++) {
+        TEST_ASSERT_NOT_NULL(table.find(addr));
+    }
+}
+
+static void test_probe_is_bounded() {
+    for (uint16_t addr = 1; addr <= DEVICE_TABLE_MAX_DEVICES; addr++) {
+        table.findOrInsert(addr);
+    }
+    // Com a ocupação em 7/8 sobra folga: nenhuma sondagem dá a volta na tabela
+    TEST_ASSERT_LESS_THAN(DEVICE_TABLE_SIZE - DEVICE_TABLE_MAX_DEVICES, table.longestProbe());
+
+    // Endereços desconhecidos em toda a faixa: nenhum é achado nem inserido
+    for (uint32_t addr = DEVICE_TABLE_MAX_DEVICES + 1; addr <= 0xFFFF; addr++) {
+        TEST_ASSERT_NULL(table.findOrInsert((uint16_t)addr));
+    }
+    TEST_ASSERT_EQUAL_size_t(DEVICE_TABLE_MAX_DEVICES, table.size());
+}
+
+static void test_summary_and_clear() {
+    table.record(reading(4, 1), true, 0);
+    table.record(reading(4, 4), true, 0);
+    table.record(reading(4, 4), true, 0);
+    table.record(reading(9, 1), true, 0);
+    table.record(reading(9, 1), true, 0);
+
+    DeviceTableSummary summary = table.summarize();
+    TEST_ASSERT_EQUAL_size_t(2, summary.devices);
+    TEST_ASSERT_EQUAL_UINT32(2, summary.duplicates);
+    TEST_ASSERT_EQUAL_UINT32(2, summary.gaps);
+    TEST_ASSERT_EQUAL_UINT32(0, summary.untracked);
+    TEST_ASSERT_EQUAL_UINT8(50, deviceLinkQuality(*table.find(4)));
+
+    table.clear();
+    TEST_ASSERT_EQUAL_size_t(0, table.size());
+    TEST_ASSERT_FALSE(table.isFull());
+    TEST_ASSERT_NULL(table.find(4));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_find_and_insert);
+    RUN_TEST(test_record_drops_duplicates_only_with_sequence);
+    RUN_TEST(test_full_table_passes_new_devices_untracked);
+    RUN_TEST(test_probe_is_bounded);
+    RUN_TEST(test_summary_and_clear);
+    return UNITY_END();
+}
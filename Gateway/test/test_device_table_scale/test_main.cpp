@@ -0,0 +1,90 @@
+// Tabela de transmissores (device_table.h) com milhares de posições:
+// leituras intercaladas de 1.500 transmissores. Roda no host com a tabela
+// de 2048 posições: pio test -e native_table_2048
+#include <unity.h>
+#include "device_table.h"
+
+#define SCALE_DEVICES 1500
+#define SCALE_ROUNDS 8
+
+static_assert(DEVICE_TABLE_MAX_DEVICES >= SCALE_DEVICES, "compile com -DDEVICE_TABLE_SIZE=2048");
+
+static DeviceTable table;
+
+static ReadingFrame reading(uint16_t deviceAddr, uint16_t sequence) {
+    ReadingFrame frame;
+    frame.device_addr = deviceAddr;
+    frame.sequence = sequence;
+    frame.heart_rate = 70;
+    frame.oxygen_level = 98;
+    frame.temperature_centi = 3650;
+    return frame;
+}
+
+// Metade em sequência (0x0001...) e metade espalhada acima de 0x8000
+static uint16_t deviceAddress(size_t index) {
+    if (index < SCALE_DEVICES / 2) {
+        return (uint16_t)(index + 1);
+    }
+    return (uint16_t)(0x8000 | ((index * 97) & 0x7FFF));
+}
+
+void setUp() {
+    table.clear();
+}
+
+void tearDown() {}
+
+static void test_interleaved_devices() {
+    // Uma leitura de cada transmissor por rodada, como rajadas no canal
+    for (uint16_t round = 0; round < SCALE_ROUNDS; round++) {
+        for (size_t i = 0; i < SCALE_DEVICES; i++) {
+            TEST_ASSERT_TRUE(table.record(reading(deviceAddress(i), round), true, round * 1000u));
+        }
+    }
+    TEST_ASSERT_EQUAL_size_t(SCALE_DEVICES, table.size());
+    TEST_ASSERT_FALSE(table.isFull());
+
+    // Retransmissão da última rodada: todas descartadas
+    for (size_t i = 0; i < SCALE_DEVICES; i++) {
+        TEST_ASSERT_FALSE(table.record(reading(deviceAddress(i), SCALE_ROUNDS - 1), true, SCALE_ROUNDS * 1000u));
+    }
+
+    for (size_t i = 0; i < SCALE_DEVICES; i++) {
+        const DeviceState *device = table.find(deviceAddress(i));
+        TEST_ASSERT_NOT_NULL(device);
+        TEST_ASSERT_EQUAL_UINT16(deviceAddress(i), device->device_addr);
+        TEST_ASSERT_EQUAL_UINT32(SCALE_ROUNDS, device->readings);
+        TEST_ASSERT_EQUAL_UINT32(1000, device->meanIntervalMs);
+        TEST_ASSERT_EQUAL_UINT8(100, deviceLinkQuality(*device));
+    }
+
+    DeviceTableSummary summary = table.summarize();
+    TEST_ASSERT_EQUAL_size_t(SCALE_DEVICES, summary.devices);
+    TEST_ASSERT_EQUAL_UINT32(SCALE_DEVICES, summary.duplicates);
+    TEST_ASSERT_EQUAL_UINT32(0, summary.gaps);
+    TEST_ASSERT_EQUAL_UINT32(0, summary.untracked);
+
+    // Com 73% de ocupação as sondagens continuam curtas
+    TEST_ASSERT_LESS_THAN(64, table.longestProbe());
+}
+
+static void test_fills_to_max_devices() {
+    for (size_t i = 0; i < DEVICE_TABLE_MAX_DEVICES; i++) {
+        TEST_ASSERT_TRUE(table.record(reading((uint16_t)(i * 40503u + 1), 1), true, 0));
+    }
+    TEST_ASSERT_TRUE(table.isFull());
+    TEST_ASSERT_EQUAL_size_t(DEVICE_TABLE_MAX_DEVICES, table.size());
+    TEST_ASSERT_LESS_THAN(DEVICE_TABLE_SIZE - DEVICE_TABLE_MAX_DEVICES, table.longestProbe());
+
+    TEST_ASSERT_TRUE(table.record(reading(0xFFFF, 1), true, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, table.untrackedCount());
+    TEST_ASSERT_FALSE(table.record(reading(1, 1), true, 0));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_interleaved_devices);
+    RUN_TEST(test_fills_to_max_devices);
+    return UNITY_END();
+}
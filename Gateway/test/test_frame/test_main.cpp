@@ -0,0 +1,295 @@
+// Codec do frame binário (frame.h): CRC, leitura, rajada com deltas,
+// fragmentos, confirmação e rejeição de frames inválidos.
+// Roda no host: pio test -e native
+#include <unity.h>
+#include <string.h>
+#include "frame.h"
+
+static ReadingFrame sampleReading(uint16_t sequence) {
+    ReadingFrame reading;
+    reading.device_addr = 0x0102;
+    reading.sequence = sequence;
+    reading.heart_rate = 72;
+    reading.oxygen_level = 97;
+    reading.temperature_centi = 3650;
+    return reading;
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_crc16_ccitt_false_check_value() {
+    // Valor de verificação do catálogo de CRCs para "123456789"
+    const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, frameCRC16(check, sizeof(check)));
+    TEST_ASSERT_EQUAL_HEX16(0xFFFF, frameCRC16(check, 0));
+}
+
+static void test_reading_round_trip() {
+    uint8_t frame[FRAME_READING_SIZE];
+    ReadingFrame reading = sampleReading(1234);
+    reading.temperature_centi = -1250;
+    TEST_ASSERT_EQUAL_size_t(FRAME_READING_SIZE, encodeReadingFrame(reading, frame, sizeof(frame)));
+
+    ReadingFrame decoded;
+    TEST_ASSERT_EQUAL(FRAME_OK, decodeReadingFrame(frame, sizeof(frame), decoded));
+    TEST_ASSERT_EQUAL_UINT16(reading.device_addr, decoded.device_addr);
+    TEST_ASSERT_EQUAL_UINT16(reading.sequence, decoded.sequence);
+    TEST_ASSERT_EQUAL_UINT8(reading.heart_rate, decoded.heart_rate);
+    TEST_ASSERT_EQUAL_UINT8(reading.oxygen_level, decoded.oxygen_level);
+    TEST_ASSERT_EQUAL_INT16(reading.temperature_centi, decoded.temperature_centi);
+}
+
+static void test_reading_layout_is_big_endian() {
+    uint8_t frame[FRAME_READING_SIZE];
+    encodeReadingFrame(sampleReading(0xABCD), frame, sizeof(frame));
+    const uint8_t header[] = { (FRAME_VERSION << 4) | FRAME_TYPE_READING, FRAME_READING_PAYLOAD,
+                               0x01, 0x02, 0xAB, 0xCD, 72, 97, 0x0E, 0x42 };
+    TEST_ASSERT_EQUAL_MEMORY(header, frame, sizeof(header));
+    // O primeiro byte nunca é '{', que marca o JSON legado
+    TEST_ASSERT_TRUE(frame[0] != '{');
+}
+
+static void test_sequence_wrap_round_trip() {
+    uint8_t frame[FRAME_READING_SIZE];
+    const uint16_t sequences[] = { 0xFFFE, 0xFFFF, 0x0000, 0x0001 };
+    for (size_t i = 0; i < sizeof(sequences) / sizeof(sequences[0]); i++) {
+        ReadingFrame decoded;
+        encodeReadingFrame(sampleReading(sequences[i]), frame, sizeof(frame));
+        TEST_ASSERT_EQUAL(FRAME_OK, decodeReadingFrame(frame, sizeof(frame), decoded));
+        TEST_ASSERT_EQUAL_UINT16(sequences[i], decoded.sequence);
+    }
+}
+
+static void test_rejects_corrupted_frames() {
+    uint8_t frame[FRAME_READING_SIZE];
+    ReadingFrame decoded;
+    encodeReadingFrame(sampleReading(7), frame, sizeof(frame));
+
+    // Qualquer bit trocado fora da versão é pego pelo CRC
+    for (size_t i = 1; i < sizeof(frame); i++) {
+        uint8_t copy[FRAME_READING_SIZE];
+        memcpy(copy, frame, sizeof(copy));
+        copy[i] ^= 0x10;
+        FrameStatus status = decodeReadingFrame(copy, sizeof(copy), decoded);
+        TEST_ASSERT_TRUE(status == FRAME_BAD_CRC || status == FRAME_BAD_LENGTH || status == FRAME_TRUNCATED);
+    }
+
+    uint8_t badVersion[FRAME_READING_SIZE];
+    memcpy(badVersion, frame, sizeof(badVersion));
+    badVersion[0] = (uint8_t)((FRAME_VERSION + 1) << 4);
+    TEST_ASSERT_EQUAL(FRAME_BAD_VERSION, decodeReadingFrame(badVersion, sizeof(badVersion), decoded));
+    TEST_ASSERT_EQUAL(FRAME_TRUNCATED, decodeReadingFrame(frame, sizeof(frame) - 1, decoded));
+}
+
+static void test_encode_checks_capacity() {
+    uint8_t frame[FRAME_READING_SIZE];
+    TEST_ASSERT_EQUAL_size_t(0, encodeReadingFrame(sampleReading(1), frame, sizeof(frame) - 1));
+    TEST_ASSERT_EQUAL_size_t(0, frameTotalSize(frame, 1));
+}
+
+static void test_temperature_conversion_rounds_and_saturates() {
+    TEST_ASSERT_EQUAL_INT16(3650, frameTemperatureToCenti(36.5f));
+    TEST_ASSERT_EQUAL_INT16(3651, frameTemperatureToCenti(36.506f));
+    TEST_ASSERT_EQUAL_INT16(-1250, frameTemperatureToCenti(-12.5f));
+    TEST_ASSERT_EQUAL_INT16(32767, frameTemperatureToCenti(1000.0f));
+    TEST_ASSERT_EQUAL_INT16(-32768, frameTemperatureToCenti(-1000.0f));
+    TEST_ASSERT_EQUAL_UINT8(0, frameClampU8(-5));
+    TEST_ASSERT_EQUAL_UINT8(255, frameClampU8(300));
+}
+
+// Rajada de count leituras consecutivas a partir de sequence
+static void burstReadings(ReadingFrame *readings, size_t count, uint16_t sequence) {
+    for (size_t i = 0; i < count; i++) {
+        readings[i] = sampleReading((uint16_t)(sequence + i));
+        readings[i].heart_rate = (uint8_t)(70 + (i % 5));
+        readings[i].oxygen_level = (uint8_t)(96 + (i % 3));
+        readings[i].temperature_centi = (int16_t)(3650 - (int)(i % 7) * 3);
+    }
+}
+
+static void assertSameReading(const ReadingFrame &expected, const ReadingFrame &actual) {
+    TEST_ASSERT_EQUAL_UINT16(expected.device_addr, actual.device_addr);
+    TEST_ASSERT_EQUAL_UINT16(expected.sequence, actual.sequence);
+    TEST_ASSERT_EQUAL_UINT8(expected.heart_rate, actual.heart_rate);
+    TEST_ASSERT_EQUAL_UINT8(expected.oxygen_level, actual.oxygen_level);
+    TEST_ASSERT_EQUAL_INT16(expected.temperature_centi, actual.temperature_centi);
+}
+
+static size_t decodeBurst(const uint8_t *frame, size_t length, ReadingFrame *readings, size_t capacity) {
+    FrameHeader header;
+    const uint8_t *payload = nullptr;
+    size_t count = 0;
+    TEST_ASSERT_EQUAL(FRAME_OK, decodeFrame(frame, length, header, payload));
+    TEST_ASSERT_EQUAL(FRAME_OK, decodeBurstPayload(header, payload, readings, capacity, count));
+    return count;
+}
+
+static void test_burst_round_trip_across_sequence_wrap() {
+    // Base em 0xFFFE: as sequências decodificadas dão a volta para 0
+    ReadingFrame readings[10];
+    burstReadings(readings, 10, 0xFFFE);
+    uint8_t frame[FRAME_MAX_SIZE];
+    size_t encoded = 0;
+    size_t length = encodeBurstFrame(readings, 10, frame, sizeof(frame), encoded);
+    TEST_ASSERT_EQUAL_size_t(10, encoded);
+    TEST_ASSERT_EQUAL_size_t(FRAME_HEADER_SIZE + FRAME_BURST_BASE_SIZE + 9 * FRAME_BURST_DELTA_SIZE + FRAME_CRC_SIZE,
+                             length);
+
+    ReadingFrame decoded[FRAME_BURST_MAX_READINGS];
+    TEST_ASSERT_EQUAL_size_t(10, decodeBurst(frame, length, decoded, FRAME_BURST_MAX_READINGS));
+    for (size_t i = 0; i < 10; i++) {
+        assertSameReading(readings[i], decoded[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT16(0x0000, decoded[2].sequence);
+}
+
+static void test_burst_splits_on_delta_overflow() {
+    ReadingFrame readings[6];
+    burstReadings(readings, 6, 100);
+    readings[3].temperature_centi = (int16_t)(readings[2].temperature_centi + 128);   // Não cabe em int8
+    readings[4].temperature_centi = readings[3].temperature_centi;
+    readings[5].temperature_centi = readings[3].temperature_centi;
+    readings[5].heart_rate = (uint8_t)(readings[4].heart_rate - 128);
+
+    uint8_t frame[FRAME_MAX_SIZE];
+    ReadingFrame decoded[FRAME_BURST_MAX_READINGS];
+    size_t offset = 0;
+    const size_t expected[] = { 3, 2, 1 };
+    for (size_t part = 0; part < 3; part++) {
+        size_t encoded = 0;
+        size_t length = encodeBurstFrame(readings + offset, 6 - offset, frame, sizeof(frame), encoded);
+        TEST_ASSERT_EQUAL_size_t(expected[part], encoded);
+        TEST_ASSERT_EQUAL_size_t(encoded, decodeBurst(frame, length, decoded, FRAME_BURST_MAX_READINGS));
+        for (size_t i = 0; i < encoded; i++) {
+            assertSameReading(readings[offset + i], decoded[i]);
+        }
+        offset += encoded;
+    }
+
+    // Deltas no limite de int8 ainda cabem
+    burstReadings(readings, 3, 7);
+    readings[1].temperature_centi = (int16_t)(readings[0].temperature_centi + 127);
+    readings[2].temperature_centi = (int16_t)(readings[1].temperature_centi - 128);
+    size_t encoded = 0;
+    size_t length = encodeBurstFrame(readings, 3, frame, sizeof(frame), encoded);
+    TEST_ASSERT_EQUAL_size_t(3, encoded);
+    TEST_ASSERT_EQUAL_size_t(3, decodeBurst(frame, length, decoded, FRAME_BURST_MAX_READINGS));
+    assertSameReading(readings[2], decoded[2]);
+}
+
+static void test_burst_stops_at_sequence_break_and_capacity() {
+    ReadingFrame readings[FRAME_BURST_MAX_READINGS + 4];
+    burstReadings(readings, FRAME_BURST_MAX_READINGS + 4, 500);
+    uint8_t frame[FRAME_MAX_SIZE];
+    size_t encoded = 0;
+
+    // O payload enche em FRAME_BURST_MAX_READINGS leituras
+    size_t length = encodeBurstFrame(readings, FRAME_BURST_MAX_READINGS + 4, frame, sizeof(frame), encoded);
+    TEST_ASSERT_EQUAL_size_t(FRAME_BURST_MAX_READINGS, encoded);
+    TEST_ASSERT_LESS_OR_EQUAL(FRAME_MAX_SIZE, length);
+
+    // Sequência pulada abre outro frame
+    readings[4].sequence = 600;
+    encodeBurstFrame(readings, 8, frame, sizeof(frame), encoded);
+    TEST_ASSERT_EQUAL_size_t(4, encoded);
+
+    // Buffer de saída pequeno: nada é codificado
+    TEST_ASSERT_EQUAL_size_t(0, encodeBurstFrame(readings, 4, frame, FRAME_READING_SIZE, encoded));
+    TEST_ASSERT_EQUAL_size_t(0, encoded);
+}
+
+static void test_burst_rejects_bad_payloads() {
+    ReadingFrame readings[4];
+    burstReadings(readings, 4, 1);
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    size_t encoded = 0;
+    size_t length = encodeBurstPayload(readings, 4, payload, sizeof(payload), encoded);
+    ReadingFrame decoded[4];
+    size_t count = 0;
+
+    // Contagem que não fecha com o tamanho, zero leituras ou capacidade menor
+    TEST_ASSERT_EQUAL(FRAME_BAD_LENGTH, decodeBurstReadings(2, 1, payload, length - 1, decoded, 4, count));
+    TEST_ASSERT_EQUAL(FRAME_BAD_LENGTH, decodeBurstReadings(2, 1, payload, length, decoded, 3, count));
+    payload[0] = 0;
+    TEST_ASSERT_EQUAL(FRAME_BAD_LENGTH, decodeBurstReadings(2, 1, payload, length, decoded, 4, count));
+    TEST_ASSERT_EQUAL_size_t(0, count);
+}
+
+static void test_fragment_round_trip() {
+    uint8_t data[FRAME_FRAGMENT_DATA_MAX];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 3);
+    }
+    FragmentHeader fragment = { 9, FRAME_TYPE_BURST, 2, 3 };
+    uint8_t frame[FRAME_MAX_SIZE];
+    size_t length = encodeFragmentFrame(0x0102, 0xFFFF, fragment, data, 10, frame, sizeof(frame));
+    TEST_ASSERT_GREATER_THAN(0, length);
+
+    FrameHeader header;
+    const uint8_t *payload = nullptr;
+    FragmentHeader decoded;
+    const uint8_t *decodedData = nullptr;
+    size_t decodedLength = 0;
+    TEST_ASSERT_EQUAL(FRAME_OK, decodeFrame(frame, length, header, payload));
+    TEST_ASSERT_EQUAL_UINT16(0xFFFF, header.sequence);
+    TEST_ASSERT_EQUAL(FRAME_OK, decodeFragmentPayload(header, payload, decoded, decodedData, decodedLength));
+    TEST_ASSERT_EQUAL_UINT8(9, decoded.message_id);
+    TEST_ASSERT_EQUAL_UINT8(FRAME_TYPE_BURST, decoded.message_type);
+    TEST_ASSERT_EQUAL_UINT8(2, decoded.index);
+    TEST_ASSERT_EQUAL_UINT8(3, decoded.count);
+    TEST_ASSERT_EQUAL_size_t(10, decodedLength);
+    TEST_ASSERT_EQUAL_MEMORY(data, decodedData, 10);
+
+    // Só o último fragmento pode ser curto; índice fora do total é recusado
+    fragment.index = 0;
+    length = encodeFragmentFrame(0x0102, 1, fragment, data, 10, frame, sizeof(frame));
+    decodeFrame(frame, length, header, payload);
+    TEST_ASSERT_EQUAL(FRAME_BAD_LENGTH, decodeFragmentPayload(header, payload, decoded, decodedData, decodedLength));
+    fragment.index = 3;
+    TEST_ASSERT_EQUAL_size_t(0, encodeFragmentFrame(0x0102, 1, fragment, data, 10, frame, sizeof(frame)));
+    fragment.index = 0;
+    fragment.count = FRAME_FRAGMENT_MAX_COUNT + 1;
+    TEST_ASSERT_EQUAL_size_t(0, encodeFragmentFrame(0x0102, 1, fragment, data, 10, frame, sizeof(frame)));
+}
+
+static void test_ack_round_trip_and_window_wrap() {
+    AckFrame ack = { 0x0203, 0xFFF0, 0 };
+    TEST_ASSERT_TRUE(ackSet(ack, 0xFFF0));
+    TEST_ASSERT_TRUE(ackSet(ack, 0x0000));
+    TEST_ASSERT_TRUE(ackSet(ack, 0x000F));
+    TEST_ASSERT_FALSE(ackSet(ack, 0x0010));
+    TEST_ASSERT_FALSE(ackSet(ack, 0xFFEF));
+
+    uint8_t frame[FRAME_ACK_SIZE];
+    TEST_ASSERT_EQUAL_size_t(FRAME_ACK_SIZE, encodeAckFrame(ack, frame, sizeof(frame)));
+    FrameHeader header;
+    const uint8_t *payload = nullptr;
+    AckFrame decoded;
+    TEST_ASSERT_EQUAL(FRAME_OK, decodeFrame(frame, sizeof(frame), header, payload));
+    TEST_ASSERT_EQUAL(FRAME_OK, decodeAckPayload(header, payload, decoded));
+    TEST_ASSERT_EQUAL_UINT16(ack.device_addr, decoded.device_addr);
+    TEST_ASSERT_EQUAL_UINT16(ack.base, decoded.base);
+    TEST_ASSERT_EQUAL_HEX32(ack.bitmap, decoded.bitmap);
+    TEST_ASSERT_TRUE(ackHas(decoded, 0x0000));
+    TEST_ASSERT_FALSE(ackHas(decoded, 0x0001));
+    TEST_ASSERT_FALSE(ackHas(decoded, 0x0010));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_crc16_ccitt_false_check_value);
+    RUN_TEST(test_reading_round_trip);
+    RUN_TEST(test_reading_layout_is_big_endian);
+    RUN_TEST(test_sequence_wrap_round_trip);
+    RUN_TEST(test_rejects_corrupted_frames);
+    RUN_TEST(test_encode_checks_capacity);
+    RUN_TEST(test_temperature_conversion_rounds_and_saturates);
+    RUN_TEST(test_burst_round_trip_across_sequence_wrap);
+    RUN_TEST(test_burst_splits_on_delta_overflow);
+    RUN_TEST(test_burst_stops_at_sequence_break_and_capacity);
+    RUN_TEST(test_burst_rejects_bad_payloads);
+    RUN_TEST(test_fragment_round_trip);
+    RUN_TEST(test_ack_round_trip_and_window_wrap);
+    return UNITY_END();
+}
@@ -0,0 +1,208 @@
+// Parser incremental (frame_parser.h): frames quebrados entre blocos,
+// ressincronização depois de lixo e CRC inválido, JSON legado.
+// Roda no host: pio test -e native
+#include <unity.h>
+#include <string.h>
+#include "frame_parser.h"
+
+#define MAX_CAPTURED 32
+
+static ReadingFrame captured[MAX_CAPTURED];
+static bool capturedLegacy[MAX_CAPTURED];
+static size_t capturedCount;
+
+static void onFrame(const ParsedFrame &frame, void *context) {
+    TEST_ASSERT_TRUE(capturedCount < MAX_CAPTURED);
+    TEST_ASSERT_EQUAL(FRAME_OK, decodeReadingPayload(frame.header, frame.payload, captured[capturedCount]));
+    capturedLegacy[capturedCount] = frame.legacy;
+    capturedCount++;
+}
+
+static FrameParser parser(onFrame, nullptr);
+
+static size_t encodeSample(uint16_t sequence, uint8_t *out) {
+    ReadingFrame reading;
+    reading.device_addr = 2;
+    reading.sequence = sequence;
+    reading.heart_rate = (uint8_t)(70 + sequence % 10);
+    reading.oxygen_level = 97;
+    reading.temperature_centi = 3650;
+    return encodeReadingFrame(reading, out, FRAME_READING_SIZE);
+}
+
+static void feedText(const char *text) {
+    parser.feed((const uint8_t *)text, strlen(text));
+}
+
+void setUp() {
+    parser = FrameParser(onFrame, nullptr);
+    capturedCount = 0;
+}
+
+void tearDown() {}
+
+static void test_frame_fed_byte_by_byte() {
+    uint8_t frame[FRAME_READING_SIZE];
+    encodeSample(5, frame);
+    for (size_t i = 0; i < sizeof(frame); i++) {
+        TEST_ASSERT_EQUAL_size_t(0, capturedCount);
+        parser.push(frame[i]);
+    }
+    TEST_ASSERT_EQUAL_size_t(1, capturedCount);
+    TEST_ASSERT_EQUAL_UINT16(5, captured[0].sequence);
+    TEST_ASSERT_FALSE(capturedLegacy[0]);
+}
+
+static void test_frames_split_at_every_offset() {
+    // Dois frames seguidos, divididos em dois blocos em todas as posições
+    uint8_t stream[2 * FRAME_READING_SIZE];
+    encodeSample(1, stream);
+    encodeSample(2, stream + FRAME_READING_SIZE);
+    for (size_t split = 0; split <= sizeof(stream); split++) {
+        setUp();
+        parser.feed(stream, split);
+        parser.feed(stream + split, sizeof(stream) - split);
+        TEST_ASSERT_EQUAL_size_t(2, capturedCount);
+        TEST_ASSERT_EQUAL_UINT16(1, captured[0].sequence);
+        TEST_ASSERT_EQUAL_UINT16(2, captured[1].sequence);
+    }
+}
+
+static void test_resync_after_garbage() {
+    static const uint8_t garbage[] = { 0x00, 0xFF, 0x20, 0x13, 0x7F, 0x00 };
+    uint8_t stream[64];
+    size_t length = 0;
+    memcpy(stream + length, garbage, sizeof(garbage));
+    length += sizeof(garbage);
+    length += encodeSample(10, stream + length);
+    memcpy(stream + length, garbage, sizeof(garbage));
+    length += sizeof(garbage);
+    length += encodeSample(11, stream + length);
+
+    parser.feed(stream, length);
+    parser.flush();
+    TEST_ASSERT_EQUAL_size_t(2, capturedCount);
+    TEST_ASSERT_EQUAL_UINT16(10, captured[0].sequence);
+    TEST_ASSERT_EQUAL_UINT16(11, captured[1].sequence);
+    TEST_ASSERT_EQUAL_UINT32(2, parser.getStats().frames);
+    TEST_ASSERT_GREATER_OR_EQUAL(2 * sizeof(garbage) - 1, parser.getStats().discardedBytes);
+}
+
+static void test_resync_after_bad_crc() {
+    uint8_t stream[2 * FRAME_READING_SIZE];
+    encodeSample(20, stream);
+    encodeSample(21, stream + FRAME_READING_SIZE);
+    stream[FRAME_READING_SIZE - 1] ^= 0x01;
+
+    parser.feed(stream, sizeof(stream));
+    parser.flush();
+    TEST_ASSERT_EQUAL_size_t(1, capturedCount);
+    TEST_ASSERT_EQUAL_UINT16(21, captured[0].sequence);
+    TEST_ASSERT_EQUAL_UINT32(1, parser.getStats().crcErrors);
+}
+
+static void test_legacy_json_matches_binary_reading() {
+    feedText("{\"id\":\"TR-002\",\"hr\":72,\"ox\":97,\"temp\":36.5}");
+    TEST_ASSERT_EQUAL_size_t(1, capturedCount);
+    TEST_ASSERT_TRUE(capturedLegacy[0]);
+    TEST_ASSERT_EQUAL_UINT16(2, captured[0].device_addr);
+    TEST_ASSERT_EQUAL_UINT8(72, captured[0].heart_rate);
+    TEST_ASSERT_EQUAL_UINT8(97, captured[0].oxygen_level);
+    TEST_ASSERT_EQUAL_INT16(3650, captured[0].temperature_centi);
+}
+
+static void test_concatenated_json_split_across_feeds() {
+    const char *text = "{\"id\":\"TR-001\",\"hr\":70,\"ox\":98,\"temp\":36.45}{\"id\":\"TR-003\",\"hr\":80,\"ox\":95,\"temp\":-1.5}";
+    size_t length = strlen(text);
+    for (size_t split = 0; split <= length; split++) {
+        setUp();
+        parser.feed((const uint8_t *)text, split);
+        parser.feed((const uint8_t *)text + split, length - split);
+        TEST_ASSERT_EQUAL_size_t(2, capturedCount);
+        TEST_ASSERT_EQUAL_UINT16(1, captured[0].device_addr);
+        TEST_ASSERT_EQUAL_INT16(3645, captured[0].temperature_centi);
+        TEST_ASSERT_EQUAL_UINT16(3, captured[1].device_addr);
+        TEST_ASSERT_EQUAL_INT16(-150, captured[1].temperature_centi);
+    }
+}
+
+static void test_binary_frame_interrupts_truncated_json() {
+    uint8_t frame[FRAME_READING_SIZE];
+    encodeSample(30, frame);
+    feedText("{\"id\":\"TR-002\",\"hr\":7");
+    parser.feed(frame, sizeof(frame));
+    TEST_ASSERT_EQUAL_size_t(1, capturedCount);
+    TEST_ASSERT_FALSE(capturedLegacy[0]);
+    TEST_ASSERT_EQUAL_UINT16(30, captured[0].sequence);
+    TEST_ASSERT_EQUAL_UINT32(1, parser.getStats().jsonErrors);
+}
+
+static void test_malformed_json_is_dropped() {
+    feedText("{\"id\":\"TR-002\",\"hr\":\"x\"}");
+    feedText("{\"id\":\"TR-004\",\"hr\":60,\"ox\":99,\"temp\":37}");
+    TEST_ASSERT_EQUAL_size_t(1, capturedCount);
+    TEST_ASSERT_EQUAL_UINT16(4, captured[0].device_addr);
+    TEST_ASSERT_EQUAL_UINT32(1, parser.getStats().jsonErrors);
+}
+
+// Recepção por eventos: os bytes chegam em blocos a cada evento do UART
+// (linha ociosa ou limiar da FIFO) e flush() roda quando a linha fica
+// ociosa por LORA_IDLE_WAIT_MS
+
+static void test_frames_dispatched_inside_fifo_sized_chunks() {
+    // 12 frames em blocos de 120 bytes (limiar da FIFO do ESP32): cada
+    // frame sai no bloco em que chega o seu último byte, sem esperar o ocioso
+    uint8_t stream[12 * FRAME_READING_SIZE];
+    for (uint16_t i = 0; i < 12; i++) {
+        encodeSample(i, stream + i * FRAME_READING_SIZE);
+    }
+    parser.feed(stream, 120);
+    TEST_ASSERT_EQUAL_size_t(10, capturedCount);
+    parser.feed(stream + 120, sizeof(stream) - 120);
+    TEST_ASSERT_EQUAL_size_t(12, capturedCount);
+    TEST_ASSERT_EQUAL_UINT16(11, captured[11].sequence);
+}
+
+static void test_idle_flush_recovers_frame_behind_false_start() {
+    // 0x10 0x30 parece o início de um frame de 56 bytes e prende o frame
+    // real no buffer até a linha ficar ociosa
+    uint8_t stream[2 + FRAME_READING_SIZE] = { 0x10, 0x30 };
+    encodeSample(40, stream + 2);
+    parser.feed(stream, sizeof(stream));
+    TEST_ASSERT_EQUAL_size_t(0, capturedCount);
+
+    parser.flush();
+    TEST_ASSERT_EQUAL_size_t(1, capturedCount);
+    TEST_ASSERT_EQUAL_UINT16(40, captured[0].sequence);
+}
+
+static void test_idle_flush_drops_truncated_packet() {
+    // Pacote cortado: sem o flush os bytes do próximo pacote completariam
+    // o frame antigo e os dois seriam perdidos
+    uint8_t frame[FRAME_READING_SIZE];
+    encodeSample(50, frame);
+    parser.feed(frame, 7);
+    parser.flush();
+    TEST_ASSERT_EQUAL_UINT32(7, parser.getStats().discardedBytes);
+
+    encodeSample(51, frame);
+    parser.feed(frame, sizeof(frame));
+    TEST_ASSERT_EQUAL_size_t(1, capturedCount);
+    TEST_ASSERT_EQUAL_UINT16(51, captured[0].sequence);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_frame_fed_byte_by_byte);
+    RUN_TEST(test_frames_split_at_every_offset);
+    RUN_TEST(test_resync_after_garbage);
+    RUN_TEST(test_resync_after_bad_crc);
+    RUN_TEST(test_legacy_json_matches_binary_reading);
+    RUN_TEST(test_concatenated_json_split_across_feeds);
+    RUN_TEST(test_binary_frame_interrupts_truncated_json);
+    RUN_TEST(test_malformed_json_is_dropped);
+    RUN_TEST(test_frames_dispatched_inside_fifo_sized_chunks);
+    RUN_TEST(test_idle_flush_recovers_frame_behind_false_start);
+    RUN_TEST(test_idle_flush_drops_truncated_packet);
+    return UNITY_END();
+}
@@ -0,0 +1,134 @@
+// Compressor gzip (gzip.h) conferido com o zlib: toda saída tem que ser
+// descompactada pelo inflate de referência e voltar idêntica à entrada.
+// Roda no host: pio test -e native
+#include <unity.h>
+#include <string.h>
+#include <stdio.h>
+#include <zlib.h>
+#include "gzip.h"
+
+static GzipCompressor compressor;
+static uint8_t input[GZIP_MAX_INPUT];
+static uint8_t compressed[GZIP_MAX_INPUT + GZIP_MAX_INPUT / 8 + 64];
+static uint8_t inflated[GZIP_MAX_INPUT + 1];
+
+void setUp() {}
+void tearDown() {}
+
+// Inflate do zlib em modo gzip (cabeçalho, CRC-32 e ISIZE conferidos)
+static size_t zlibInflate(const uint8_t *data, size_t length) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    TEST_ASSERT_EQUAL(Z_OK, inflateInit2(&stream, 16 + MAX_WBITS));
+    stream.next_in = (Bytef *)data;
+    stream.avail_in = (uInt)length;
+    stream.next_out = inflated;
+    stream.avail_out = sizeof(inflated);
+    int status = inflate(&stream, Z_FINISH);
+    size_t produced = stream.total_out;
+    size_t consumed = stream.total_in;
+    inflateEnd(&stream);
+    TEST_ASSERT_EQUAL(Z_STREAM_END, status);
+    TEST_ASSERT_EQUAL_size_t(length, consumed);
+    return produced;
+}
+
+static size_t assertRoundTrip(const uint8_t *data, size_t length) {
+    size_t size = compressor.compress(data, length, compressed, sizeof(compressed));
+    TEST_ASSERT_GREATER_THAN(0, size);
+    TEST_ASSERT_EQUAL_HEX8(0x1f, compressed[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x8b, compressed[1]);
+    TEST_ASSERT_EQUAL_size_t(length, zlibInflate(compressed, size));
+    TEST_ASSERT_EQUAL_MEMORY(data, inflated, length);
+    return size;
+}
+
+static size_t readingsJSON(uint8_t *buffer, size_t count) {
+    size_t length = 0;
+    buffer[length++] = '[';
+    for (size_t i = 0; i < count; i++) {
+        length += (size_t)snprintf((char *)buffer + length, 128,
+                                   "%s{\"device_id\":\"TR-%03u\",\"heart_rate\":%u,\"oxygen_level\":%u,"
+                                   "\"temperature\":%.2f}",
+                                   i == 0 ? "" : ",", (unsigned)(i % 40), (unsigned)(60 + i % 30),
+                                   (unsigned)(94 + i % 5), 36.0 + (i % 15) / 10.0);
+    }
+    buffer[length++] = ']';
+    return length;
+}
+
+static void test_crc32_matches_zlib() {
+    const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, gzipCRC32(check, sizeof(check)));
+    TEST_ASSERT_EQUAL_HEX32(0, gzipCRC32(check, 0));
+
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < 4096; i++) {
+        seed = seed * 1103515245u + 12345u;
+        input[i] = (uint8_t)(seed >> 16);
+    }
+    for (size_t length = 1; length <= 4096; length = length * 3 + 1) {
+        TEST_ASSERT_EQUAL_HEX32(crc32(0, input, (uInt)length), gzipCRC32(input, length));
+    }
+}
+
+static void test_empty_and_tiny_inputs() {
+    assertRoundTrip(input, 0);
+    const uint8_t one[] = { 'x' };
+    assertRoundTrip(one, sizeof(one));
+    const uint8_t three[] = { 'a', 'b', 'a' };
+    assertRoundTrip(three, sizeof(three));
+}
+
+static void test_json_batch_compresses() {
+    size_t length = readingsJSON(input, 20);
+    size_t size = assertRoundTrip(input, length);
+    // Lote JSON típico: as chaves repetidas dão pelo menos 3:1
+    TEST_ASSERT_LESS_THAN(length / 3, size);
+}
+
+static void test_long_runs_and_far_matches() {
+    // Repetições de 258 bytes (o máximo do deflate) e na distância da janela
+    memset(input, 'A', 5000);
+    assertRoundTrip(input, 5000);
+
+    for (size_t i = 0; i < GZIP_WINDOW_SIZE; i++) {
+        input[i] = (uint8_t)(i * 7 + i / 13);
+    }
+    memcpy(input + GZIP_WINDOW_SIZE, input, GZIP_WINDOW_SIZE);
+    assertRoundTrip(input, 2 * GZIP_WINDOW_SIZE);
+}
+
+static void test_incompressible_and_max_input() {
+    uint32_t seed = 1;
+    for (size_t i = 0; i < GZIP_MAX_INPUT; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        input[i] = (uint8_t)(seed >> 24);
+    }
+    assertRoundTrip(input, 1000);
+    assertRoundTrip(input, GZIP_MAX_INPUT);
+
+    size_t length = readingsJSON(input, 600);
+    TEST_ASSERT_LESS_OR_EQUAL(GZIP_MAX_INPUT, length);
+    assertRoundTrip(input, length);
+}
+
+static void test_small_output_buffer_fails_cleanly() {
+    size_t length = readingsJSON(input, 20);
+    size_t size = compressor.compress(input, length, compressed, sizeof(compressed));
+    TEST_ASSERT_EQUAL_size_t(0, compressor.compress(input, length, compressed, size - 1));
+    TEST_ASSERT_EQUAL_size_t(0, compressor.compress(input, length, compressed, 10));
+    // O compressor continua utilizável depois da falha
+    TEST_ASSERT_EQUAL_size_t(size, assertRoundTrip(input, length));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_crc32_matches_zlib);
+    RUN_TEST(test_empty_and_tiny_inputs);
+    RUN_TEST(test_json_batch_compresses);
+    RUN_TEST(test_long_runs_and_far_matches);
+    RUN_TEST(test_incompressible_and_max_input);
+    RUN_TEST(test_small_output_buffer_fails_cleanly);
+    return UNITY_END();
+}
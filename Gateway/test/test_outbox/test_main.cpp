@@ -0,0 +1,241 @@
+// Outbox persistente (outbox.h) num diretório temporário do host:
+// peek/acknowledge sobrevivendo a um reboot, confirmação fora de ordem,
+// anel em RAM sem sistema de arquivos e escrita parcial.
+// Roda no host: pio test -e native
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include "outbox.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <signal.h>
+#include <sys/resource.h>
+#define OUTBOX_TEST_RLIMIT 1
+#endif
+
+static char directory[64];
+
+static ReadingFrame sampleReading(uint16_t sequence) {
+    ReadingFrame reading;
+    reading.device_addr = 7;
+    reading.sequence = sequence;
+    reading.heart_rate = (uint8_t)(60 + sequence % 40);
+    reading.oxygen_level = 96;
+    reading.temperature_centi = (int16_t)(3600 + sequence);
+    return reading;
+}
+
+static void appendRange(Outbox &outbox, uint16_t first, uint16_t count, uint32_t uptime) {
+    for (uint16_t i = 0; i < count; i++) {
+        outbox.append(sampleReading((uint16_t)(first + i)), uptime);
+    }
+}
+
+static void assertSequences(const OutboxRecord *records, size_t count, uint16_t first) {
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_UINT16(first + i, records[i].reading.sequence);
+        TEST_ASSERT_EQUAL_INT16(3600 + first + i, records[i].reading.temperature_centi);
+    }
+}
+
+static void removeDirectory() {
+    DIR *dir = opendir(directory);
+    if (dir == nullptr) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        char path[320];
+        snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+        unlink(path);
+    }
+    closedir(dir);
+    rmdir(directory);
+}
+
+void setUp() {
+    snprintf(directory, sizeof(directory), "/tmp/outbox_test_XXXXXX");
+    TEST_ASSERT_NOT_NULL(mkdtemp(directory));
+}
+
+void tearDown() {
+    removeDirectory();
+}
+
+static void test_peek_and_ack_survive_reboot() {
+    OutboxRecord records[32];
+    {
+        Outbox outbox;
+        TEST_ASSERT_TRUE(outbox.begin(directory, 100));
+        appendRange(outbox, 0, 40, 100);
+        TEST_ASSERT_TRUE(outbox.flush());
+        TEST_ASSERT_EQUAL_UINT32(40, outbox.flashPendingCount());
+
+        TEST_ASSERT_EQUAL_size_t(10, outbox.peek(records, 10));
+        assertSequences(records, 10, 0);
+        outbox.acknowledge(10);
+        TEST_ASSERT_EQUAL_UINT32(30, outbox.pendingCount());
+    }
+
+    // Reboot: o cursor volta do arquivo e o relógio continua à frente
+    Outbox outbox;
+    TEST_ASSERT_TRUE(outbox.begin(directory, 5));
+    TEST_ASSERT_EQUAL_UINT32(30, outbox.pendingCount());
+    TEST_ASSERT_EQUAL_size_t(30, outbox.peek(records, 32));
+    assertSequences(records, 30, 10);
+    TEST_ASSERT_EQUAL_UINT32(100, records[0].storedAt);
+
+    appendRange(outbox, 40, 2, 5);
+    TEST_ASSERT_TRUE(outbox.flush());
+    TEST_ASSERT_EQUAL_size_t(32, outbox.peek(records, 32));
+    TEST_ASSERT_GREATER_THAN(100, records[31].storedAt);
+
+    outbox.acknowledge(32);
+    TEST_ASSERT_EQUAL_UINT32(0, outbox.pendingCount());
+    TEST_ASSERT_EQUAL_size_t(0, outbox.peek(records, 32));
+}
+
+static void test_flushed_records_survive_reboot_unacknowledged() {
+    // Sem acknowledge nada se perde, nem o lote menor que OUTBOX_WRITE_BATCH
+    {
+        Outbox outbox;
+        TEST_ASSERT_TRUE(outbox.begin(directory, 0));
+        appendRange(outbox, 500, 3, 0);
+        TEST_ASSERT_TRUE(outbox.flush());
+    }
+    Outbox outbox;
+    TEST_ASSERT_TRUE(outbox.begin(directory, 0));
+    OutboxRecord records[4];
+    TEST_ASSERT_EQUAL_size_t(3, outbox.peek(records, 4));
+    assertSequences(records, 3, 500);
+}
+
+static void test_append_writes_full_batches_without_flush() {
+    Outbox outbox;
+    TEST_ASSERT_TRUE(outbox.begin(directory, 0));
+    appendRange(outbox, 0, OUTBOX_WRITE_BATCH + 1, 0);
+    TEST_ASSERT_EQUAL_UINT32(OUTBOX_WRITE_BATCH, outbox.flashPendingCount());
+    TEST_ASSERT_EQUAL_UINT32(1, outbox.ramPendingCount());
+}
+
+static void test_unmounted_outbox_is_a_ram_ring() {
+    // begin() nunca chamado: o anel guarda as OUTBOX_RAM_RECORDS mais novas
+    Outbox outbox;
+    appendRange(outbox, 0, OUTBOX_RAM_RECORDS + 10, 0);
+    TEST_ASSERT_FALSE(outbox.isMounted());
+    TEST_ASSERT_FALSE(outbox.flush());
+    TEST_ASSERT_EQUAL_UINT32(OUTBOX_RAM_RECORDS, outbox.pendingCount());
+    TEST_ASSERT_EQUAL_UINT32(10, outbox.ramDroppedCount());
+
+    OutboxRecord records[OUTBOX_RAM_RECORDS];
+    TEST_ASSERT_EQUAL_size_t(OUTBOX_RAM_RECORDS, outbox.peek(records, OUTBOX_RAM_RECORDS));
+    assertSequences(records, OUTBOX_RAM_RECORDS, 10);
+    outbox.acknowledge(5);
+    TEST_ASSERT_EQUAL_size_t(OUTBOX_RAM_RECORDS - 5, outbox.peek(records, OUTBOX_RAM_RECORDS));
+    assertSequences(records, OUTBOX_RAM_RECORDS - 5, 15);
+}
+
+static void test_partial_write_is_truncated_and_retried() {
+#if OUTBOX_TEST_RLIMIT
+    // Limita o tamanho dos arquivos para o fwrite do lote parar no meio
+    // de um registro, como um flash cheio
+    Outbox outbox;
+    TEST_ASSERT_TRUE(outbox.begin(directory, 0));
+    appendRange(outbox, 0, 2, 0);
+    TEST_ASSERT_TRUE(outbox.flush());
+
+    struct rlimit previous;
+    getrlimit(RLIMIT_FSIZE, &previous);
+    struct rlimit limit = previous;
+    limit.rlim_cur = 50;
+    signal(SIGXFSZ, SIG_IGN);
+    TEST_ASSERT_EQUAL_INT(0, setrlimit(RLIMIT_FSIZE, &limit));
+    appendRange(outbox, 2, 4, 0);
+    bool flushed = outbox.flush();
+    setrlimit(RLIMIT_FSIZE, &previous);
+
+    TEST_ASSERT_FALSE(flushed);
+    TEST_ASSERT_EQUAL_UINT32(1, outbox.writeErrorCount());
+    TEST_ASSERT_EQUAL_UINT32(2, outbox.flashPendingCount());
+    TEST_ASSERT_EQUAL_UINT32(4, outbox.ramPendingCount());
+
+    // Com espaço de novo os registros vão para o flash inteiros
+    TEST_ASSERT_TRUE(outbox.flush());
+    Outbox rebooted;
+    TEST_ASSERT_TRUE(rebooted.begin(directory, 0));
+    OutboxRecord records[8];
+    TEST_ASSERT_EQUAL_size_t(6, rebooted.peek(records, 8));
+    assertSequences(records, 6, 0);
+#endif
+}
+
+static void test_out_of_order_ack_skips_answered_records() {
+    // Dois lotes em paralelo: o primeiro para no 3º item, o segundo completa
+    Outbox outbox;
+    TEST_ASSERT_TRUE(outbox.begin(directory, 100));
+    appendRange(outbox, 0, 30, 100);
+    TEST_ASSERT_TRUE(outbox.flush());
+
+    OutboxRecord records[20];
+    bool done[20] = { false };
+    TEST_ASSERT_EQUAL_size_t(20, outbox.peek(records, 20));
+    done[0] = done[1] = true;
+    for (size_t i = 10; i < 20; i++) {
+        done[i] = true;
+    }
+    outbox.acknowledge(done, 20);
+    TEST_ASSERT_EQUAL_UINT32(28, outbox.pendingCount());
+
+    // O cursor parou no 2; do 10 ao 19 não são reenviados
+    size_t count = outbox.peek(records, 20);
+    assertSequences(records, count, 2);
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL(i >= 8 && i < 18, outbox.isAcknowledged(i));
+    }
+
+    // Respondidos os que faltavam, o cursor passa também pelos já marcados
+    bool rest[20] = { false };
+    for (size_t i = 0; i < 8; i++) {
+        rest[i] = true;
+    }
+    outbox.acknowledge(rest, count);
+    TEST_ASSERT_EQUAL_UINT32(10, outbox.pendingCount());
+    TEST_ASSERT_EQUAL_size_t(10, outbox.peek(records, 20));
+    assertSequences(records, 10, 20);
+    TEST_ASSERT_FALSE(outbox.isAcknowledged(0));
+}
+
+static void test_out_of_order_marks_follow_ram_ring_drops() {
+    // Sem flash: o mais antigo sai do anel e as marcas andam junto
+    Outbox outbox;
+    appendRange(outbox, 0, OUTBOX_RAM_RECORDS, 100);
+    OutboxRecord records[8];
+    bool done[8] = { false, false, false, true, false, false, false, false };
+    TEST_ASSERT_EQUAL_size_t(8, outbox.peek(records, 8));
+    outbox.acknowledge(done, 8);
+    TEST_ASSERT_TRUE(outbox.isAcknowledged(3));
+
+    outbox.append(sampleReading(1000), 100);
+    TEST_ASSERT_EQUAL_UINT32(1, outbox.ramDroppedCount());
+    TEST_ASSERT_FALSE(outbox.isAcknowledged(3));
+    TEST_ASSERT_TRUE(outbox.isAcknowledged(2));
+    outbox.peek(records, 8);
+    TEST_ASSERT_EQUAL_UINT16(3, records[2].reading.sequence);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_peek_and_ack_survive_reboot);
+    RUN_TEST(test_flushed_records_survive_reboot_unacknowledged);
+    RUN_TEST(test_append_writes_full_batches_without_flush);
+    RUN_TEST(test_out_of_order_ack_skips_answered_records);
+    RUN_TEST(test_out_of_order_marks_follow_ram_ring_drops);
+    RUN_TEST(test_unmounted_outbox_is_a_ram_ring);
+    RUN_TEST(test_partial_write_is_truncated_and_retried);
+    return UNITY_END();
+}
@@ -0,0 +1,168 @@
+// Remontagem de mensagens fragmentadas (reassembly.h): fora de ordem,
+// repetidos, prazo e falta de slots. Roda no host: pio test -e native
+#include <unity.h>
+#include <string.h>
+#include "reassembly.h"
+
+static uint8_t delivered[FRAME_MESSAGE_MAX_SIZE];
+static ReassembledMessage lastMessage;
+static size_t deliveries;
+
+static void onMessage(const ReassembledMessage &message, void *context) {
+    // Os dados só valem durante o callback
+    memcpy(delivered, message.data, message.length);
+    lastMessage = message;
+    lastMessage.data = delivered;
+    deliveries++;
+}
+
+static Reassembler reassembler(onMessage, nullptr);
+static uint8_t message[FRAME_MESSAGE_MAX_SIZE];
+
+void setUp() {
+    reassembler.reset();
+    deliveries = 0;
+    memset(&lastMessage, 0, sizeof(lastMessage));
+    for (size_t i = 0; i < sizeof(message); i++) {
+        message[i] = (uint8_t)(i * 7 + 1);
+    }
+}
+
+void tearDown() {}
+
+// Fragmento index de uma mensagem de length bytes, passado pelo codec como no rádio
+static FrameStatus pushFragment(uint16_t deviceAddr, uint16_t sequence, uint8_t messageId, size_t length,
+                                uint8_t index, uint32_t nowMs) {
+    uint8_t count = (uint8_t)((length + FRAME_FRAGMENT_DATA_MAX - 1) / FRAME_FRAGMENT_DATA_MAX);
+    size_t offset = (size_t)index * FRAME_FRAGMENT_DATA_MAX;
+    size_t chunk = length - offset < FRAME_FRAGMENT_DATA_MAX ? length - offset : FRAME_FRAGMENT_DATA_MAX;
+    FragmentHeader fragment = { messageId, FRAME_TYPE_BURST, index, count };
+    uint8_t frame[FRAME_MAX_SIZE];
+    size_t frameLength = encodeFragmentFrame(deviceAddr, sequence, fragment, message + offset, chunk, frame,
+                                             sizeof(frame));
+    TEST_ASSERT_GREATER_THAN(0, frameLength);
+
+    FrameHeader header;
+    const uint8_t *payload = nullptr;
+    TEST_ASSERT_EQUAL(FRAME_OK, decodeFrame(frame, frameLength, header, payload));
+    return reassembler.push(header, payload, nowMs);
+}
+
+static void test_out_of_order_and_repeated_fragments() {
+    // 4 fragmentos, o último curto, chegando 3, 1, 1, 0, 3, 2
+    const size_t length = 3 * FRAME_FRAGMENT_DATA_MAX + 10;
+    const uint8_t order[] = { 3, 1, 1, 0, 3, 2 };
+    for (size_t i = 0; i < sizeof(order); i++) {
+        TEST_ASSERT_EQUAL(0, deliveries);
+        TEST_ASSERT_EQUAL(FRAME_OK, pushFragment(0x0102, 500, 7, length, order[i], 100 + i));
+    }
+    TEST_ASSERT_EQUAL(1, deliveries);
+    TEST_ASSERT_EQUAL_UINT16(0x0102, lastMessage.device_addr);
+    TEST_ASSERT_EQUAL_UINT16(500, lastMessage.sequence);
+    TEST_ASSERT_EQUAL_UINT8(FRAME_TYPE_BURST, lastMessage.type);
+    TEST_ASSERT_EQUAL_size_t(length, lastMessage.length);
+    TEST_ASSERT_EQUAL_MEMORY(message, delivered, length);
+
+    const ReassemblyStats &stats = reassembler.getStats();
+    TEST_ASSERT_EQUAL_UINT32(4, stats.fragments);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.duplicates);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.completed);
+    TEST_ASSERT_EQUAL_size_t(0, reassembler.pendingCount());
+}
+
+static void test_late_copy_after_completion_is_duplicate() {
+    const size_t length = FRAME_FRAGMENT_DATA_MAX + 5;
+    pushFragment(9, 40, 1, length, 0, 0);
+    pushFragment(9, 40, 1, length, 1, 10);
+    TEST_ASSERT_EQUAL(1, deliveries);
+
+    // Cópia atrasada não abre slot nem entrega de novo
+    pushFragment(9, 40, 1, length, 0, 1000);
+    TEST_ASSERT_EQUAL_size_t(0, reassembler.pendingCount());
+    TEST_ASSERT_EQUAL(1, deliveries);
+    TEST_ASSERT_EQUAL_UINT32(1, reassembler.getStats().duplicates);
+}
+
+static void test_incomplete_message_expires() {
+    const size_t length = 3 * FRAME_FRAGMENT_DATA_MAX;
+    pushFragment(3, 10, 2, length, 0, 1000);
+    pushFragment(3, 10, 2, length, 2, 1500);
+    TEST_ASSERT_EQUAL_size_t(1, reassembler.pendingCount());
+
+    // O prazo conta do primeiro fragmento
+    reassembler.expire(1000 + REASSEMBLY_TIMEOUT_MS - 1);
+    TEST_ASSERT_EQUAL_size_t(1, reassembler.pendingCount());
+    reassembler.expire(1000 + REASSEMBLY_TIMEOUT_MS);
+    TEST_ASSERT_EQUAL_size_t(0, reassembler.pendingCount());
+    TEST_ASSERT_EQUAL_UINT32(1, reassembler.getStats().expired);
+
+    // O fragmento que faltava chega tarde: começa outra mensagem, que não completa
+    pushFragment(3, 10, 2, length, 1, 1000 + REASSEMBLY_TIMEOUT_MS + 1);
+    TEST_ASSERT_EQUAL(0, deliveries);
+    TEST_ASSERT_EQUAL_size_t(1, reassembler.pendingCount());
+}
+
+static void test_push_expires_before_storing() {
+    const size_t length = 2 * FRAME_FRAGMENT_DATA_MAX;
+    pushFragment(3, 10, 2, length, 0, 0);
+    pushFragment(4, 20, 5, length, 0, REASSEMBLY_TIMEOUT_MS);
+    TEST_ASSERT_EQUAL_UINT32(1, reassembler.getStats().expired);
+    TEST_ASSERT_EQUAL_size_t(1, reassembler.pendingCount());
+}
+
+static void test_oldest_message_evicted_when_slots_full() {
+    const size_t length = 2 * FRAME_FRAGMENT_DATA_MAX;
+    for (uint8_t id = 0; id < REASSEMBLY_SLOTS; id++) {
+        pushFragment(5, (uint16_t)(100 + id), id, length, 0, 10 * id);
+    }
+    TEST_ASSERT_EQUAL_size_t(REASSEMBLY_SLOTS, reassembler.pendingCount());
+
+    // Mensagem nova derruba a mais antiga (id 0); as demais ainda completam
+    pushFragment(6, 1, 0, length, 0, 100);
+    TEST_ASSERT_EQUAL_UINT32(1, reassembler.getStats().evicted);
+    pushFragment(5, 101, 1, length, 1, 110);
+    TEST_ASSERT_EQUAL(1, deliveries);
+    TEST_ASSERT_EQUAL_UINT16(101, lastMessage.sequence);
+    pushFragment(5, 100, 0, length, 1, 120);
+    TEST_ASSERT_EQUAL(1, deliveries);
+}
+
+static void test_reused_id_with_new_sequence_replaces_message() {
+    // Transmissor reiniciou: mesmo id, outra sequência
+    const size_t length = 2 * FRAME_FRAGMENT_DATA_MAX;
+    pushFragment(8, 300, 4, length, 0, 0);
+    pushFragment(8, 7, 4, length, 1, 50);
+    TEST_ASSERT_EQUAL_UINT32(1, reassembler.getStats().evicted);
+    TEST_ASSERT_EQUAL(0, deliveries);
+    pushFragment(8, 7, 4, length, 0, 60);
+    TEST_ASSERT_EQUAL(1, deliveries);
+    TEST_ASSERT_EQUAL_UINT16(7, lastMessage.sequence);
+}
+
+static void test_largest_message_and_invalid_fragment() {
+    const size_t length = FRAME_MESSAGE_MAX_SIZE;
+    for (int index = FRAME_FRAGMENT_MAX_COUNT - 1; index >= 0; index--) {
+        pushFragment(1, 0xFFFF, 255, length, (uint8_t)index, 0);
+    }
+    TEST_ASSERT_EQUAL(1, deliveries);
+    TEST_ASSERT_EQUAL_size_t(length, lastMessage.length);
+    TEST_ASSERT_EQUAL_MEMORY(message, delivered, length);
+
+    // Frame que não é fragmento
+    FrameHeader header = { FRAME_TYPE_READING, FRAME_READING_PAYLOAD, 1, 1 };
+    const uint8_t payload[FRAME_READING_PAYLOAD] = { 0 };
+    TEST_ASSERT_EQUAL(FRAME_BAD_TYPE, reassembler.push(header, payload, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, reassembler.getStats().invalid);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_out_of_order_and_repeated_fragments);
+    RUN_TEST(test_late_copy_after_completion_is_duplicate);
+    RUN_TEST(test_incomplete_message_expires);
+    RUN_TEST(test_push_expires_before_storing);
+    RUN_TEST(test_oldest_message_evicted_when_slots_full);
+    RUN_TEST(test_reused_id_with_new_sequence_replaces_message);
+    RUN_TEST(test_largest_message_and_invalid_fragment);
+    return UNITY_END();
+}
@@ -0,0 +1,112 @@
+// Serialização do uplink (uplink_codec.h): ID do transmissor enviado à API,
+// inclusive os aliases de DEVICE_ID_ALIASES, e os corpos JSON e CBOR.
+// Roda no host: pio test -e native
+#include <unity.h>
+#include <string.h>
+#include "uplink_codec.h"
+#include "frame_parser.h"
+
+#define MAX_CAPTURED 4
+
+static ReadingFrame captured[MAX_CAPTURED];
+static size_t capturedCount;
+
+static void onFrame(const ParsedFrame &frame, void *context) {
+    TEST_ASSERT_TRUE(capturedCount < MAX_CAPTURED);
+    TEST_ASSERT_EQUAL(FRAME_OK, decodeReadingPayload(frame.header, frame.payload, captured[capturedCount]));
+    capturedCount++;
+}
+
+static ReceivedData sample(uint16_t deviceAddr, int heartRate, float temperature) {
+    ReceivedData data;
+    data.device_addr = deviceAddr;
+    data.heart_rate = heartRate;
+    data.oxygen_level = 97;
+    data.temperature = temperature;
+    return data;
+}
+
+void setUp() {
+    capturedCount = 0;
+}
+
+void tearDown() {}
+
+static void test_id_from_address() {
+    char deviceId[DEVICE_ID_SIZE];
+    formatDeviceId(5, deviceId, sizeof(deviceId));
+    TEST_ASSERT_EQUAL_STRING("TR-005", deviceId);
+    formatDeviceId(0x1234, deviceId, sizeof(deviceId));
+    TEST_ASSERT_EQUAL_STRING("TR-4660", deviceId);
+    TEST_ASSERT_NULL(deviceIdAlias(5));
+}
+
+static void test_alias_keeps_the_id_the_server_knows() {
+    // 0x0002 é o Transmitter que mandava "TR-001" no JSON legado
+    char deviceId[DEVICE_ID_SIZE];
+    formatDeviceId(2, deviceId, sizeof(deviceId));
+    TEST_ASSERT_EQUAL_STRING("TR-001", deviceId);
+    TEST_ASSERT_EQUAL_STRING("TR-001", deviceIdAlias(2));
+}
+
+static void test_binary_and_legacy_readings_share_the_id() {
+    // O mesmo transmissor antes (JSON legado) e depois (frame binário de 0x0002)
+    FrameParser parser(onFrame, nullptr);
+    const char *legacy = "{\"id\":\"TR-001\",\"hr\":72,\"ox\":97,\"temp\":36.5}";
+    parser.feed((const uint8_t *)legacy, strlen(legacy));
+    ReadingFrame reading = { 2, 7, 72, 97, 3650 };
+    uint8_t frame[FRAME_READING_SIZE];
+    parser.feed(frame, encodeReadingFrame(reading, frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_size_t(2, capturedCount);
+
+    const char *expected = "{\"transmitter_id\":\"TR-001\",\"temperature\":36.5,\"heart_rate\":72,\"oxygen_level\":97}";
+    for (size_t i = 0; i < capturedCount; i++) {
+        TEST_ASSERT_EQUAL_STRING(expected, createReadingJSON(toReceivedData(captured[i])).c_str());
+    }
+}
+
+static void test_batch_json() {
+    ReceivedData items[] = { sample(2, 72, 36.5f), sample(7, 80, 37.0f), sample(9, 64, -0.05f) };
+    TEST_ASSERT_EQUAL_STRING("[{\"transmitter_id\":\"TR-001\",\"temperature\":36.5,\"heart_rate\":72,\"oxygen_level\":97},"
+                             "{\"transmitter_id\":\"TR-007\",\"temperature\":37,\"heart_rate\":80,\"oxygen_level\":97},"
+                             "{\"transmitter_id\":\"TR-009\",\"temperature\":-0.05,\"heart_rate\":64,\"oxygen_level\":97}]",
+                             createBatchJSON(items, 3).c_str());
+    TEST_ASSERT_EQUAL_STRING("[]", createBatchJSON(items, 0).c_str());
+}
+
+static void test_cbor_carries_alias_id() {
+    ReceivedData items[] = { sample(7, 72, 36.5f), sample(2, 72, 36.5f) };
+    uint8_t out[3 + 2 * CBOR_READING_MAX_SIZE];
+    size_t length = createReadingsCBOR(items, 2, true, out, sizeof(out));
+    // [{1: 7, 2: 3650, 3: 72, 4: 97}, {1: 2, 2: 3650, 3: 72, 4: 97, 5: "TR-001"}]
+    const uint8_t expected[] = {
+        0x82,
+        0xa4, 0x01, 0x07, 0x02, 0x19, 0x0e, 0x42, 0x03, 0x18, 0x48, 0x04, 0x18, 0x61,
+        0xa5, 0x01, 0x02, 0x02, 0x19, 0x0e, 0x42, 0x03, 0x18, 0x48, 0x04, 0x18, 0x61,
+        0x05, 0x66, 'T', 'R', '-', '0', '0', '1',
+    };
+    TEST_ASSERT_EQUAL_size_t(sizeof(expected), length);
+    TEST_ASSERT_EQUAL_MEMORY(expected, out, sizeof(expected));
+
+    // Não cabe: 0, sem corpo pela metade
+    TEST_ASSERT_EQUAL_size_t(0, createReadingsCBOR(items, 2, true, out, 20));
+}
+
+static void test_cbor_reading_max_size() {
+    // Leitura com alias e valores no limite dos campos do frame
+    ReceivedData data = sample(2, 255, -327.68f);
+    data.oxygen_level = 255;
+    uint8_t out[CBOR_READING_MAX_SIZE];
+    TEST_ASSERT_GREATER_THAN(0, createReadingsCBOR(&data, 1, false, out, sizeof(out)));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_id_from_address);
+    RUN_TEST(test_alias_keeps_the_id_the_server_knows);
+    RUN_TEST(test_binary_and_legacy_readings_share_the_id);
+    RUN_TEST(test_batch_json);
+    RUN_TEST(test_cbor_carries_alias_id);
+    RUN_TEST(test_cbor_reading_max_size);
+    return UNITY_END();
+}
@@ -0,0 +1,557 @@
+// Simulador do canal LoRa em tempo virtual (roda no PC, não no ESP32).
+//
+// Gera o tráfego de N transmitters no canal do Gateway (CHANNEL 0x17) e
+// passa os bytes recebidos pelo mesmo caminho de recepção do firmware
+// (FrameParser e DeviceTable de src/), com relógio virtual: 24 h de
+// tráfego rodam em segundos. Para cada quantidade de transmitters imprime
+// entregues/perdidos/duplicados e a distribuição de latência.
+//
+// Compilar e rodar a partir de Gateway/:
+//
+//   g++ -O2 -std=c++17 -Isrc -o lora_sim tools/lora_sim.cpp src/frame.cpp src/frame_parser.cpp src/device_table.cpp src/dedup.cpp src/reassembly.cpp
+//   ./lora_sim --devices 1,10,50,100,200 --hours 24 --air-rate 2400
+//
+// Modelo:
+//   - Cada transmitter envia rajadas de --burst leituras a cada --period-s
+//     segundos (fase aleatória, ±10% de variação), como o Transmitter:
+//     UART a 9600 baud até o E32, tempo no ar e --gap-ms entre envios.
+//   - --frames-per-packet junta K frames por mensagem; o E32 divide
+//     mensagens maiores que 58 bytes em subpacotes independentes no ar.
+//   - --frame burst manda a rajada em frames FRAME_TYPE_BURST (base +
+//     deltas), como o Transmitter atual: até FRAME_BURST_MAX_READINGS
+//     leituras num frame, acima disso (--burst 16 a 32) em fragmentos,
+//     uma mensagem LoRa por fragmento, remontados pelo Reassembler de src/.
+//     As leituras seguem um passeio aleatório para os deltas serem realistas.
+//   - Tempo no ar = (E32_AIR_OVERHEAD_BYTES + bytes) * 8 / taxa do ar.
+//     É uma aproximação do preâmbulo e header LoRa; calibre com medições.
+//   - Dois subpacotes que se sobrepõem no ar se perdem (sem efeito captura).
+//   - O E32 do Gateway repassa cada pacote pelo UART a 9600 baud; pacotes
+//     que não cabem no buffer de 512 bytes do módulo são descartados.
+//   - No ESP32 os bytes esperam no buffer do driver (--rx-buffer) até a
+//     tarefa de recepção ler: no modo por eventos após o UART ficar ocioso
+//     por LORA_RX_IDLE_SYMBOLS ou a cada 120 bytes (limiar da FIFO); no
+//     modo polling a cada --poll-ms. Bytes além do buffer são perdidos.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "frame.h"
+#include "frame_parser.h"
+#include "device_table.h"
+#include "reassembly.h"
+#include "lora_uart.h"
+
+#define E32_SUBPACKET_SIZE 58       // Maior pacote no ar do E32
+#define E32_BUFFER_SIZE 512         // Buffer do E32 entre o ar e o UART
+#define E32_AIR_OVERHEAD_BYTES 8    // Preâmbulo, header e CRC LoRa (aproximado)
+#define E32_FIXED_HEADER_SIZE 3     // ADDH, ADDL e CHAN na transmissão fixa
+#define E32_IDLE_BYTES 3            // O E32 transmite após 3 bytes de UART ocioso
+#define UART_FIFO_THRESHOLD 120     // Limiar da FIFO do ESP32 que gera evento
+#define LORA_BURST_MAX_READINGS 32  // Maior rajada montada pelo Transmitter
+
+struct SimConfig {
+    std::vector<int> devices;
+    double hours;
+    uint32_t airRate;           // bps
+    uint32_t uartBaud;
+    double periodS;             // Intervalo médio entre rajadas de um transmitter
+    int burst;                  // Leituras por rajada (DATA_BUFFER_SIZE)
+    int framesPerPacket;
+    bool burstFrames;           // FRAME_TYPE_BURST em vez de um frame por leitura
+    int repeats;                // Cópias extras de cada mensagem
+    double gapMs;               // delay() entre envios no Transmitter
+    size_t rxBuffer;            // Buffer do driver UART no ESP32
+    bool polling;
+    double pollMs;
+    double wakeMs;              // Latência para a tarefa lora_rx acordar
+    uint32_t seed;
+};
+
+// Um subpacote no ar
+struct AirPacket {
+    int64_t start;              // us
+    int64_t end;
+    uint32_t offset;            // Bytes no pool de mensagens
+    uint16_t length;
+    bool collided;
+};
+
+struct SimResult {
+    uint64_t sent;              // Leituras distintas enviadas
+    uint64_t delivered;         // Leituras distintas aceitas pelo Gateway
+    uint64_t duplicates;
+    uint64_t packets;
+    uint64_t collisions;        // Subpacotes perdidos por colisão
+    uint64_t moduleOverruns;    // Subpacotes descartados pelo buffer do E32
+    uint64_t uartOverruns;      // Bytes perdidos no buffer do driver
+    uint64_t crcErrors;
+    uint64_t discardedBytes;
+    uint64_t messagesLost;      // Mensagens fragmentadas que não completaram
+    int64_t airtimeUs;
+    uint64_t wakeups;           // Vezes que a tarefa de recepção acordou
+    std::vector<double> latencyMs;
+    std::vector<double> rxLatencyMs;    // Último byte do pacote até a entrega (lora.rx_latency_us)
+};
+
+static int64_t byteTimeUs(uint32_t baud, size_t bytes) {
+    return (int64_t)bytes * 10 * 1000000 / baud;    // 8N1
+}
+
+static int64_t airtimeUs(uint32_t rate, size_t bytes) {
+    return (int64_t)(E32_AIR_OVERHEAD_BYTES + bytes) * 8 * 1000000 / rate;
+}
+
+static uint64_t frameKey(uint16_t deviceAddr, uint16_t sequence) {
+    return ((uint64_t)deviceAddr << 16) | sequence;
+}
+
+// Lado do Gateway: buffer do driver UART, tarefa de recepção, parser e
+// tabela de transmissores
+class GatewayModel {
+private:
+    const SimConfig &config;
+    SimResult &result;
+    FrameParser parser;
+    DeviceTable devices;
+    Reassembler reassembler;
+    std::unordered_map<uint64_t, int64_t> &firstSent;
+    std::vector<uint8_t> driver;
+    int64_t now;
+    int64_t lastByte;
+    int64_t idleRead;
+    int64_t thresholdRead;
+    int64_t pollRead;
+
+    static const int64_t NEVER = INT64_MAX;
+
+public:
+    GatewayModel(const SimConfig &config, SimResult &result, std::unordered_map<uint64_t, int64_t> &firstSent)
+        : config(config), result(result), parser(onFrame, this), reassembler(onMessage, this), firstSent(firstSent),
+          now(0), lastByte(-1), idleRead(NEVER), thresholdRead(NEVER), pollRead(NEVER) {
+        driver.reserve(config.rxBuffer);
+    }
+
+    void arrive(uint8_t byte, int64_t time) {
+        serviceUntil(time);
+        if (lastByte >= 0 && time - lastByte >= (int64_t)LORA_IDLE_WAIT_MS * 1000) {
+            parser.flush();
+        }
+        lastByte = time;
+
+        if (driver.size() >= config.rxBuffer) {
+            result.uartOverruns++;
+            return;
+        }
+        driver.push_back(byte);
+
+        int64_t wake = (int64_t)(config.wakeMs * 1000);
+        if (config.polling) {
+            if (pollRead == NEVER) {
+                int64_t poll = (int64_t)(config.pollMs * 1000);
+                pollRead = (time / poll + 1) * poll;
+            }
+        } else {
+            idleRead = time + byteTimeUs(config.uartBaud, LORA_RX_IDLE_SYMBOLS) + wake;
+            if (driver.size() >= UART_FIFO_THRESHOLD && thresholdRead == NEVER) {
+                thresholdRead = time + wake;
+            }
+        }
+    }
+
+    void finish() {
+        serviceUntil(NEVER - 1);
+        parser.flush();
+        const ParserStats &stats = parser.getStats();
+        result.crcErrors = stats.crcErrors;
+        result.discardedBytes = stats.discardedBytes;
+        reassembler.expire((uint32_t)(now / 1000) + REASSEMBLY_TIMEOUT_MS);
+        result.messagesLost = reassembler.getStats().expired + reassembler.getStats().evicted;
+        if (config.polling) {
+            // O polling acorda a cada --poll-ms com ou sem bytes
+            result.wakeups = (uint64_t)(config.hours * 3600e3 / config.pollMs);
+        }
+    }
+
+private:
+    void serviceUntil(int64_t time) {
+        for (;;) {
+            int64_t next = std::min(pollRead, std::min(idleRead, thresholdRead));
+            if (next > time) {
+                return;
+            }
+            read(next);
+        }
+    }
+
+    void read(int64_t time) {
+        now = time;
+        uint64_t delivered = result.delivered;
+        parser.feed(driver.data(), driver.size());
+        driver.clear();
+        result.wakeups++;
+        if (result.delivered != delivered) {
+            result.rxLatencyMs.push_back((now - lastByte) / 1000.0);
+        }
+        if (pollRead <= time) pollRead = NEVER;
+        if (idleRead <= time) idleRead = NEVER;
+        if (thresholdRead <= time) thresholdRead = NEVER;
+    }
+
+    static void onFrame(const ParsedFrame &frame, void *context) {
+        GatewayModel *gateway = static_cast<GatewayModel *>(context);
+        if (frame.header.type == FRAME_TYPE_FRAGMENT) {
+            gateway->reassembler.push(frame.header, frame.payload, (uint32_t)(gateway->now / 1000));
+            return;
+        }
+        if (frame.header.type == FRAME_TYPE_BURST) {
+            ReadingFrame readings[FRAME_BURST_MAX_READINGS];
+            size_t count = 0;
+            if (decodeBurstPayload(frame.header, frame.payload, readings, FRAME_BURST_MAX_READINGS, count) == FRAME_OK) {
+                for (size_t i = 0; i < count; i++) {
+                    gateway->deliver(readings[i], false);
+                }
+            }
+            return;
+        }
+        ReadingFrame reading;
+        if (decodeReadingPayload(frame.header, frame.payload, reading) != FRAME_OK) {
+            return;
+        }
+        gateway->deliver(reading, frame.legacy);
+    }
+
+    static void onMessage(const ReassembledMessage &message, void *context) {
+        GatewayModel *gateway = static_cast<GatewayModel *>(context);
+        if (message.type != FRAME_TYPE_BURST) {
+            return;
+        }
+        ReadingFrame readings[LORA_BURST_MAX_READINGS];
+        size_t count = 0;
+        if (decodeBurstReadings(message.device_addr, message.sequence, message.data, message.length, readings,
+                                LORA_BURST_MAX_READINGS, count) == FRAME_OK) {
+            for (size_t i = 0; i < count; i++) {
+                gateway->deliver(readings[i], false);
+            }
+        }
+    }
+
+    void deliver(const ReadingFrame &reading, bool legacy) {
+        if (!devices.record(reading, !legacy, (uint32_t)(now / 1000))) {
+            result.duplicates++;
+            return;
+        }
+        result.delivered++;
+        auto sent = firstSent.find(frameKey(reading.device_addr, reading.sequence));
+        if (sent != firstSent.end()) {
+            result.latencyMs.push_back((now - sent->second) / 1000.0);
+            firstSent.erase(sent);
+        }
+    }
+};
+
+// Como LoRaManager::sendPayload do Transmitter: um frame se couber, senão
+// fragmentos
+static void splitPayload(uint16_t deviceAddr, uint16_t sequence, const uint8_t *data, size_t length,
+                         uint8_t &messageId, std::vector<std::vector<uint8_t>> &messages) {
+    uint8_t bytes[FRAME_MAX_SIZE];
+    if (length <= FRAME_MAX_PAYLOAD) {
+        FrameHeader header;
+        header.type = FRAME_TYPE_BURST;
+        header.payload_length = (uint8_t)length;
+        header.device_addr = deviceAddr;
+        header.sequence = sequence;
+        size_t frameLength = encodeFrame(header, data, bytes, sizeof(bytes));
+        messages.emplace_back(bytes, bytes + frameLength);
+        return;
+    }
+    FragmentHeader fragment;
+    fragment.message_id = messageId++;
+    fragment.message_type = FRAME_TYPE_BURST;
+    fragment.count = (uint8_t)((length + FRAME_FRAGMENT_DATA_MAX - 1) / FRAME_FRAGMENT_DATA_MAX);
+    for (uint8_t index = 0; index < fragment.count; index++) {
+        fragment.index = index;
+        size_t offset = (size_t)index * FRAME_FRAGMENT_DATA_MAX;
+        size_t chunk = std::min<size_t>(length - offset, FRAME_FRAGMENT_DATA_MAX);
+        size_t frameLength = encodeFragmentFrame(deviceAddr, sequence, fragment, data + offset, chunk, bytes,
+                                                 sizeof(bytes));
+        messages.emplace_back(bytes, bytes + frameLength);
+    }
+}
+
+static SimResult simulate(const SimConfig &config, int deviceCount) {
+    SimResult result = {};
+    std::mt19937 random(config.seed + deviceCount);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_int_distribution<int> heartRate(55, 120);
+    std::uniform_int_distribution<int> oxygen(90, 100);
+    std::uniform_int_distribution<int> temperature(3550, 3800);
+    std::uniform_int_distribution<int> step(-3, 3);
+
+    int64_t duration = (int64_t)(config.hours * 3600e6);
+    int64_t period = (int64_t)(config.periodS * 1e6);
+    int64_t gap = (int64_t)(config.gapMs * 1000);
+
+    std::vector<uint8_t> pool;
+    std::vector<AirPacket> air;
+    std::unordered_map<uint64_t, int64_t> firstSent;
+
+    // Tráfego de cada transmitter
+    for (int device = 0; device < deviceCount; device++) {
+        uint16_t address = (uint16_t)(device + 2);  // 0x0001 é o Gateway
+        uint16_t sequence = 0;
+        uint8_t messageId = 0;
+        int64_t burstStart = (int64_t)(unit(random) * period);
+        while (burstStart < duration) {
+            int64_t time = burstStart;
+
+            // Leituras da rajada: passeio aleatório a partir de um valor sorteado
+            std::vector<ReadingFrame> readings(config.burst);
+            int hr = heartRate(random);
+            int spo2 = oxygen(random);
+            int temp = temperature(random);
+            for (int i = 0; i < config.burst; i++) {
+                readings[i].device_addr = address;
+                readings[i].sequence = sequence++;
+                readings[i].heart_rate = (uint8_t)std::min(std::max(hr += step(random), 40), 200);
+                readings[i].oxygen_level = (uint8_t)std::min(std::max(spo2 += step(random) / 2, 80), 100);
+                readings[i].temperature_centi = (int16_t)(temp += step(random) * 2);
+                firstSent[frameKey(address, readings[i].sequence)] = time;
+                result.sent++;
+            }
+
+            // Mensagens LoRa da rajada, já codificadas: um frame de rajada ou
+            // um fragmento cada, ou até framesPerPacket frames de leitura
+            std::vector<std::vector<uint8_t>> messages;
+            int next = 0;
+            while (next < config.burst) {
+                uint8_t bytes[FRAME_MAX_SIZE];
+                if (config.burstFrames) {
+                    uint8_t payload[FRAME_BURST_BASE_SIZE + (LORA_BURST_MAX_READINGS - 1) * FRAME_BURST_DELTA_SIZE];
+                    size_t encoded = 0;
+                    size_t length = encodeBurstPayload(&readings[next], std::min(config.burst - next, LORA_BURST_MAX_READINGS),
+                                                       payload, sizeof(payload), encoded);
+                    splitPayload(address, readings[next].sequence, payload, length, messageId, messages);
+                    next += (int)encoded;
+                } else {
+                    messages.emplace_back();
+                    int frames = std::min(config.framesPerPacket, config.burst - next);
+                    for (int i = 0; i < frames; i++) {
+                        size_t length = encodeReadingFrame(readings[next++], bytes, sizeof(bytes));
+                        messages.back().insert(messages.back().end(), bytes, bytes + length);
+                    }
+                }
+            }
+
+            for (const std::vector<uint8_t> &message : messages) {
+                uint32_t offset = (uint32_t)pool.size();
+                pool.insert(pool.end(), message.begin(), message.end());
+                uint32_t length = (uint32_t)message.size();
+
+                for (int copy = 0; copy <= config.repeats; copy++) {
+                    // UART do Transmitter até o E32, depois os subpacotes no ar
+                    time += byteTimeUs(config.uartBaud, std::min<uint32_t>(length, E32_SUBPACKET_SIZE) + E32_FIXED_HEADER_SIZE);
+                    time += byteTimeUs(config.uartBaud, E32_IDLE_BYTES);
+                    for (uint32_t sent = 0; sent < length; sent += E32_SUBPACKET_SIZE) {
+                        AirPacket packet;
+                        packet.length = (uint16_t)std::min<uint32_t>(length - sent, E32_SUBPACKET_SIZE);
+                        packet.offset = offset + sent;
+                        packet.start = time;
+                        packet.end = time + airtimeUs(config.airRate, packet.length);
+                        packet.collided = false;
+                        air.push_back(packet);
+                        time = packet.end;
+                    }
+                    time += gap;
+                }
+            }
+            double jitter = 0.9 + 0.2 * unit(random);
+            burstStart += (int64_t)(period * jitter);
+        }
+    }
+    result.packets = air.size();
+
+    // Colisões: subpacotes que se sobrepõem no ar se perdem
+    std::sort(air.begin(), air.end(), [](const AirPacket &a, const AirPacket &b) { return a.start < b.start; });
+    std::vector<size_t> active;
+    for (size_t i = 0; i < air.size(); i++) {
+        active.erase(std::remove_if(active.begin(), active.end(),
+                                    [&](size_t j) { return air[j].end <= air[i].start; }),
+                     active.end());
+        for (size_t j : active) {
+            air[j].collided = true;
+            air[i].collided = true;
+        }
+        active.push_back(i);
+        result.airtimeUs += air[i].end - air[i].start;
+    }
+
+    // E32 do Gateway -> UART -> ESP32, na ordem em que os pacotes terminam
+    std::sort(air.begin(), air.end(), [](const AirPacket &a, const AirPacket &b) { return a.end < b.end; });
+    GatewayModel gateway(config, result, firstSent);
+    int64_t moduleFreeAt = 0;
+    for (const AirPacket &packet : air) {
+        if (packet.collided) {
+            result.collisions++;
+            continue;
+        }
+        int64_t queuedUs = moduleFreeAt > packet.end ? moduleFreeAt - packet.end : 0;
+        size_t queued = (size_t)(queuedUs * config.uartBaud / 10 / 1000000);
+        if (queued + packet.length > E32_BUFFER_SIZE) {
+            result.moduleOverruns++;
+            continue;
+        }
+        int64_t start = std::max(packet.end, moduleFreeAt);
+        for (uint16_t i = 0; i < packet.length; i++) {
+            gateway.arrive(pool[packet.offset + i], start + byteTimeUs(config.uartBaud, i + 1));
+        }
+        moduleFreeAt = start + byteTimeUs(config.uartBaud, packet.length);
+    }
+    gateway.finish();
+    return result;
+}
+
+static double percentile(const std::vector<double> &sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+static void printResult(const SimConfig &config, int deviceCount, SimResult &result, double wallMs) {
+    std::sort(result.latencyMs.begin(), result.latencyMs.end());
+    std::sort(result.rxLatencyMs.begin(), result.rxLatencyMs.end());
+    uint64_t lost = result.sent - result.delivered;
+    printf("devices=%d sent=%llu delivered=%llu lost=%llu loss_pct=%.2f duplicates=%llu packets=%llu "
+           "collisions=%llu module_overruns=%llu uart_overruns=%llu crc_errors=%llu messages_lost=%llu airtime_pct=%.2f "
+           "lat_p50_ms=%.1f lat_p95_ms=%.1f lat_p99_ms=%.1f lat_max_ms=%.1f rx_p50_ms=%.2f rx_p95_ms=%.2f "
+           "rx_max_ms=%.2f wakeups=%llu wall_ms=%.0f\n",
+           deviceCount, (unsigned long long)result.sent, (unsigned long long)result.delivered,
+           (unsigned long long)lost, result.sent ? 100.0 * lost / result.sent : 0.0,
+           (unsigned long long)result.duplicates, (unsigned long long)result.packets,
+           (unsigned long long)result.collisions, (unsigned long long)result.moduleOverruns,
+           (unsigned long long)result.uartOverruns, (unsigned long long)result.crcErrors,
+           (unsigned long long)result.messagesLost,
+           100.0 * result.airtimeUs / (config.hours * 3600e6),
+           percentile(result.latencyMs, 0.50), percentile(result.latencyMs, 0.95),
+           percentile(result.latencyMs, 0.99), result.latencyMs.empty() ? 0.0 : result.latencyMs.back(),
+           percentile(result.rxLatencyMs, 0.50), percentile(result.rxLatencyMs, 0.95),
+           result.rxLatencyMs.empty() ? 0.0 : result.rxLatencyMs.back(), (unsigned long long)result.wakeups, wallMs);
+    fflush(stdout);
+}
+
+static void usage() {
+    fprintf(stderr,
+            "uso: lora_sim [opções]\n"
+            "  --devices 1,10,50      quantidades de transmitters simuladas\n"
+            "  --hours 24             duração simulada\n"
+            "  --air-rate 2400        taxa do ar em bps (300, 1200, 2400, 4800, 9600, 19200)\n"
+            "  --period-s 600         intervalo médio entre rajadas de um transmitter\n"
+            "  --burst 10             leituras por rajada\n"
+            "  --frames-per-packet 1  frames por mensagem LoRa\n"
+            "  --frame reading        reading (um frame por leitura) ou burst (base + deltas)\n"
+            "  --repeats 0            cópias extras de cada mensagem\n"
+            "  --gap-ms 100           pausa entre envios no Transmitter\n"
+            "  --rx-buffer 1024       buffer do driver UART no ESP32 (bytes, padrão LORA_UART_RX_BUFFER_SIZE;\n"
+            "                         256 compara com o padrão do Arduino)\n"
+            "  --rx-mode event        event ou polling\n"
+            "  --poll-ms 50           intervalo do modo polling\n"
+            "  --wake-ms 0.5          latência para a tarefa de recepção acordar\n"
+            "  --seed 1\n");
+}
+
+static std::vector<int> parseList(const char *text) {
+    std::vector<int> values;
+    std::string list(text);
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+        int value = atoi(list.substr(start, end - start).c_str());
+        if (value > 0) values.push_back(value);
+        start = end + 1;
+    }
+    return values;
+}
+
+int main(int argc, char **argv) {
+    SimConfig config;
+    config.devices = { 1, 5, 10, 20, 50, 100, 200 };
+    config.hours = 24;
+    config.airRate = 2400;
+    config.uartBaud = 9600;
+    config.periodS = 600;
+    config.burst = 10;
+    config.framesPerPacket = 1;
+    config.burstFrames = false;
+    config.repeats = 0;
+    config.gapMs = 100;
+    config.rxBuffer = LORA_UART_RX_BUFFER_SIZE;
+    config.polling = false;
+    config.pollMs = 50;
+    config.wakeMs = 0.5;
+    config.seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        const char *option = argv[i];
+        if (strcmp(option, "--help") == 0) {
+            usage();
+            return 0;
+        }
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value == nullptr) {
+            usage();
+            return 1;
+        }
+        i++;
+        if (strcmp(option, "--devices") == 0) config.devices = parseList(value);
+        else if (strcmp(option, "--hours") == 0) config.hours = atof(value);
+        else if (strcmp(option, "--air-rate") == 0) config.airRate = (uint32_t)atoi(value);
+        else if (strcmp(option, "--period-s") == 0) config.periodS = atof(value);
+        else if (strcmp(option, "--burst") == 0) config.burst = atoi(value);
+        else if (strcmp(option, "--frames-per-packet") == 0) config.framesPerPacket = atoi(value);
+        else if (strcmp(option, "--frame") == 0) config.burstFrames = strcmp(value, "burst") == 0;
+        else if (strcmp(option, "--repeats") == 0) config.repeats = atoi(value);
+        else if (strcmp(option, "--gap-ms") == 0) config.gapMs = atof(value);
+        else if (strcmp(option, "--rx-buffer") == 0) config.rxBuffer = (size_t)atoi(value);
+        else if (strcmp(option, "--rx-mode") == 0) config.polling = strcmp(value, "polling") == 0;
+        else if (strcmp(option, "--poll-ms") == 0) config.pollMs = atof(value);
+        else if (strcmp(option, "--wake-ms") == 0) config.wakeMs = atof(value);
+        else if (strcmp(option, "--seed") == 0) config.seed = (uint32_t)atoi(value);
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (config.devices.empty() || config.hours <= 0 || config.airRate == 0 || config.periodS <= 0 ||
+        config.burst <= 0 || config.framesPerPacket <= 0 || config.repeats < 0 || config.rxBuffer == 0 ||
+        config.pollMs <= 0) {
+        usage();
+        return 1;
+    }
+
+    double framesPerDevice = config.hours * 3600 / config.periodS * config.burst;
+    if (framesPerDevice > 32768) {
+        fprintf(stderr, "aviso: ~%.0f leituras por transmitter; a sequência de 16 bits dá a volta e a "
+                        "latência das leituras perdidas pode ser atribuída errado\n", framesPerDevice);
+    }
+
+    printf("# lora_sim hours=%.1f air_rate=%u period_s=%.0f burst=%d frame=%s frames_per_packet=%d repeats=%d "
+           "rx_mode=%s rx_buffer=%zu seed=%u\n",
+           config.hours, config.airRate, config.periodS, config.burst, config.burstFrames ? "burst" : "reading",
+           config.framesPerPacket, config.repeats, config.polling ? "polling" : "event", config.rxBuffer, config.seed);
+    for (int deviceCount : config.devices) {
+        auto start = std::chrono::steady_clock::now();
+        SimResult result = simulate(config, deviceCount);
+        double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        printResult(config, deviceCount, result, wallMs);
+    }
+    return 0;
+}
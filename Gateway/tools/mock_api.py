@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""API falsa para medir o reaproveitamento de conexões HTTP do Gateway.
+
+Aceita qualquer POST, responde 200 e conta as conexões TCP e as
+requisições de cada rajada (requisições separadas por mais de --burst-gap
+segundos de silêncio). Com a conexão keep-alive do NetworkManager uma
+rajada de N leituras deve aparecer com connections=1; sem ela, com N.
+
+    python3 tools/mock_api.py --port 3001
+    # no platformio.ini: -DAPI_ENDPOINT='"http://<ip do PC>:3001/gateway/vitals"'
+
+Saída, uma linha por rajada:
+
+    burst=3 requests=10 connections=1 bytes=1187
+"""
+
+import argparse
+import http.server
+import socketserver
+import threading
+import time
+
+
+class BurstCounter:
+    def __init__(self, gap):
+        self.gap = gap
+        self.lock = threading.Lock()
+        self.bursts = 0
+        self.reset()
+        self.last = 0.0
+
+    def reset(self):
+        self.requests = 0
+        self.connections = 0
+        self.bytes = 0
+
+    def connection(self):
+        with self.lock:
+            self.roll()
+            self.connections += 1
+
+    def request(self, length):
+        with self.lock:
+            self.roll()
+            self.requests += 1
+            self.bytes += length
+
+    def roll(self):
+        # Chamado com o lock: fecha a rajada anterior depois do silêncio
+        now = time.monotonic()
+        if self.requests > 0 and now - self.last > self.gap:
+            self.report()
+        self.last = now
+
+    def report(self):
+        self.bursts += 1
+        print(f"burst={self.bursts} requests={self.requests} connections={self.connections} bytes={self.bytes}",
+              flush=True)
+        self.reset()
+
+    def idle_check(self):
+        while True:
+            time.sleep(self.gap / 2)
+            with self.lock:
+                if self.requests > 0 and time.monotonic() - self.last > self.gap:
+                    self.report()
+
+
+def make_handler(counter):
+    class Handler(http.server.BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"    # Mantém a conexão aberta entre requisições
+
+        def setup(self):
+            super().setup()
+            counter.connection()
+
+        def do_POST(self):
+            length = int(self.headers.get("Content-Length", 0))
+            self.rfile.read(length)
+            counter.request(length)
+            body = b'{"ok":true}'
+            self.send_response(200)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+
+        def log_message(self, format, *args):
+            pass
+
+    return Handler
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", type=int, default=3001)
+    parser.add_argument("--burst-gap", type=float, default=2.0, help="silêncio (s) que separa as rajadas")
+    args = parser.parse_args()
+
+    counter = BurstCounter(args.burst_gap)
+    threading.Thread(target=counter.idle_check, daemon=True).start()
+    socketserver.ThreadingTCPServer.allow_reuse_address = True
+    with socketserver.ThreadingTCPServer(("", args.port), make_handler(counter)) as server:
+        server.daemon_threads = True
+        print(f"# mock_api porta={args.port} burst_gap_s={args.burst_gap}", flush=True)
+        server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
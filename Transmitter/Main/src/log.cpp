@@ -0,0 +1,152 @@
+#include "log.h"
+
+static LogRecord logRing[LOG_RING_SIZE];
+static size_t logHead = 0;     // Próxima escrita
+static size_t logTail = 0;     // Próxima leitura
+static uint32_t logDropped = 0;
+static uint32_t logDroppedReported = 0;
+static portMUX_TYPE logMux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char LOG_LEVEL_TAGS[] = { '-', 'E', 'W', 'I', 'D' };
+
+void logWrite(uint8_t level, const char *format, const uint32_t *args, uint8_t argCount) {
+    uint32_t timestamp = millis();
+
+    // Seção crítica curta: vários produtores (tarefas em núcleos diferentes)
+    portENTER_CRITICAL(&logMux);
+    if (logHead - logTail >= LOG_RING_SIZE) {
+        logDropped++;
+        portEXIT_CRITICAL(&logMux);
+        return;
+    }
+    LogRecord &record = logRing[logHead & (LOG_RING_SIZE - 1)];
+    record.format = format;
+    record.timestamp = timestamp;
+    record.level = level;
+    record.argCount = argCount;
+    for (uint8_t i = 0; i < argCount; i++) {
+        record.args[i] = args[i];
+    }
+    logHead++;
+    portEXIT_CRITICAL(&logMux);
+}
+
+static bool popRecord(LogRecord &record) {
+    portENTER_CRITICAL(&logMux);
+    if (logHead == logTail) {
+        portEXIT_CRITICAL(&logMux);
+        return false;
+    }
+    record = logRing[logTail & (LOG_RING_SIZE - 1)];
+    logTail++;
+    portEXIT_CRITICAL(&logMux);
+    return true;
+}
+
+// Formata um registro: cada especificador "%..." consome um argumento e é
+// formatado isoladamente com snprintf, de acordo com o tipo de conversão
+static size_t formatRecord(const LogRecord &record, char *line, size_t capacity) {
+    size_t length = snprintf(line, capacity, "[%lu] %c: ", (unsigned long)record.timestamp,
+                             LOG_LEVEL_TAGS[record.level < sizeof(LOG_LEVEL_TAGS) ? record.level : 0]);
+    const char *p = record.format;
+    uint8_t argIndex = 0;
+
+    while (*p != '\0' && length < capacity - 1) {
+        if (*p != '%') {
+            line[length++] = *p++;
+            continue;
+        }
+
+        // Copia o especificador (flags, largura, precisão) sem modificadores de tamanho
+        char spec[12];
+        size_t specLength = 0;
+        spec[specLength++] = *p++;
+        while (*p != '\0' && strchr("-+ #0123456789.lhz", *p) != nullptr) {
+            if (*p != 'l' && *p != 'h' && *p != 'z' && specLength < sizeof(spec) - 2) {
+                spec[specLength++] = *p;
+            }
+            p++;
+        }
+        if (*p == '\0') break;
+        char conversion = *p++;
+        spec[specLength++] = conversion;
+        spec[specLength] = '\0';
+
+        if (conversion == '%') {
+            line[length++] = '%';
+            continue;
+        }
+        if (argIndex >= record.argCount) {
+            break;
+        }
+
+        uint32_t arg = record.args[argIndex++];
+        size_t room = capacity - length;
+        int written = 0;
+        switch (conversion) {
+            case 'd': case 'i': case 'c':
+                written = snprintf(line + length, room, spec, (int)arg);
+                break;
+            case 'u': case 'x': case 'X':
+                written = snprintf(line + length, room, spec, (unsigned int)arg);
+                break;
+            case 'f': case 'g': case 'e': {
+                float value;
+                memcpy(&value, &arg, sizeof(value));
+                written = snprintf(line + length, room, spec, (double)value);
+                break;
+            }
+            case 's':
+                written = snprintf(line + length, room, spec, (const char *)(uintptr_t)arg);
+                break;
+            default:
+                break;
+        }
+        if (written > 0) {
+            length += ((size_t)written < room) ? (size_t)written : room - 1;
+        }
+    }
+
+    line[length] = '\0';
+    return length;
+}
+
+static void drainRecords() {
+    LogRecord record;
+    char line[LOG_LINE_SIZE];
+
+    while (popRecord(record)) {
+        size_t length = formatRecord(record, line, sizeof(line));
+        Serial.write((const uint8_t *)line, length);
+        Serial.write((const uint8_t *)"\r\n", 2);
+    }
+
+    uint32_t dropped = logDroppedCount();
+    if (dropped != logDroppedReported) {
+        Serial.printf("[LOG] %lu registros descartados (buffer cheio)\r\n",
+                      (unsigned long)(dropped - logDroppedReported));
+        logDroppedReported = dropped;
+    }
+}
+
+static void logTask(void *parameter) {
+    for (;;) {
+        drainRecords();
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL_MS));
+    }
+}
+
+void logInit(UBaseType_t priority, BaseType_t core) {
+    xTaskCreatePinnedToCore(logTask, "log", 3072, nullptr, priority, nullptr, core);
+}
+
+void logFlush() {
+    drainRecords();
+}
+
+uint32_t logDroppedCount() {
+    portENTER_CRITICAL(&logMux);
+    uint32_t dropped = logDropped;
+    portEXIT_CRITICAL(&logMux);
+    return dropped;
+}
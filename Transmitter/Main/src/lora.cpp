@@ -1,6 +1,8 @@
 #include "lora.h"
+#include "log.h"
 
-LoRaManager::LoRaManager() : loraHardwareSerial(2), e32ttl(&loraHardwareSerial, LORA_AUX_PIN, LORA_M0_PIN, LORA_M1_PIN), isInitialized(false) {
+LoRaManager::LoRaManager() : loraHardwareSerial(2), e32ttl(&loraHardwareSerial, LORA_AUX_PIN, LORA_M0_PIN, LORA_M1_PIN), isInitialized(false), sequence(0),
+    sequenceLimit(0), sequenceLoaded(false), messageId(0), rxLength(0) {
     // Construtor
 }
 
@@ -12,6 +14,7 @@ bool LoRaManager::initLoRa() {
     
     
     printConfiguration();
+    loadSequence();
     
     isInitialized = true;
     return true;
@@ -19,53 +22,277 @@ bool LoRaManager::initLoRa() {
 
 bool LoRaManager::sendSensorData(const SensorData &data) {
     if (!isInitialized) {
-        Serial.println("Nao foi possível enviar dados");
-        Serial.println("ERRO: Módulo LoRa não inicializado!");
+        LOG_ERROR("ERRO: Módulo LoRa não inicializado, dados não enviados!");
         return false;
     }
     
-    // Cria JSON com os dados dos sensores
-    String jsonData = createJSON(data);
+    // Cria frame binário com os dados dos sensores
+    uint8_t frame[FRAME_MAX_SIZE];
+    size_t frameLength = createFrame(data, frame, sizeof(frame));
     
-    if (jsonData.length() == 0) {
+    if (frameLength == 0) {
         return false;
     }
-    Serial.println("JSON criado: " + jsonData);
     
-    bool success = sendMessage(jsonData);    
+    bool success = sendMessage(frame, frameLength);    
     return success;
 }
 
+size_t LoRaManager::sendSensorBurst(const SensorData *data, size_t count) {
+    if (!isInitialized) {
+        LOG_ERROR("ERRO: Módulo LoRa não inicializado, dados não enviados!");
+        return 0;
+    }
+    
+    // Janelas de até LORA_BURST_MAX_READINGS leituras com sequências
+    // consecutivas, reservadas ao entrar na janela. Retorna as confirmadas
+    // pelo Gateway (ou só as enviadas, sem LORA_ACK_ENABLED)
+    ReadingFrame window[LORA_BURST_MAX_READINGS];
+    size_t next = 0;
+    size_t delivered = 0;
+    while (next < count) {
+        size_t windowCount = 0;
+        while (windowCount < LORA_BURST_MAX_READINGS && next < count) {
+            window[windowCount++] = createReading(data[next++]);
+        }
+        delivered += sendWindow(window, windowCount);
+    }
+    return delivered;
+}
+
+size_t LoRaManager::sendWindow(const ReadingFrame *readings, size_t count) {
+#if LORA_ACK_ENABLED
+    // Bit i = readings[i] confirmada; o ack é só positivo, então uma
+    // confirmação perdida custa um reenvio, nunca uma leitura
+    uint32_t confirmed = 0;
+    uint32_t all = count >= 32 ? 0xFFFFFFFFu : ((uint32_t)1 << count) - 1;
+    ReadingFrame missing[LORA_BURST_MAX_READINGS];
+    for (int attempt = 0; attempt <= LORA_ACK_RETRIES && confirmed != all; attempt++) {
+        size_t missingCount = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (!(confirmed & ((uint32_t)1 << i))) {
+                missing[missingCount++] = readings[i];
+            }
+        }
+        if (attempt > 0) {
+            LOG_INFO("Reenviando %u de %u leitura(s) sem confirmação (tentativa %d)", missingCount, count, attempt);
+            delay(random(LORA_RETRY_JITTER_MS));
+        }
+        
+        // Descarta bytes velhos (ack atrasado de outra janela) antes de ouvir
+        while (loraHardwareSerial.available() > 0) {
+            loraHardwareSerial.read();
+        }
+        rxLength = 0;
+        
+        if (sendReadings(missing, missingCount) == 0) {
+            continue;
+        }
+        
+        // Espera o ack; um bitmap ainda incompleto já dispara o reenvio
+        AckFrame ack;
+        if (!waitForAck(ack, LORA_ACK_TIMEOUT_MS)) {
+            LOG_WARN("Sem confirmação do Gateway em %d ms", LORA_ACK_TIMEOUT_MS);
+            continue;
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (ackHas(ack, readings[i].sequence)) {
+                confirmed |= (uint32_t)1 << i;
+            }
+        }
+    }
+    
+    size_t delivered = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (confirmed & ((uint32_t)1 << i)) {
+            delivered++;
+        }
+    }
+    if (delivered < count) {
+        LOG_WARN("%u de %u leitura(s) sem confirmação após %d reenvio(s)", count - delivered, count, LORA_ACK_RETRIES);
+    }
+    return delivered;
+#else
+    return sendReadings(readings, count);
+#endif
+}
+
+size_t LoRaManager::sendReadings(const ReadingFrame *readings, size_t count) {
+    // Leituras em rajadas (ver frame.h): até FRAME_BURST_MAX_READINGS num
+    // frame só, acima disso em fragmentos. Uma lacuna de sequência (leitura
+    // já confirmada no meio) fecha a rajada e a seguinte abre outra
+    uint8_t message[FRAME_BURST_BASE_SIZE + (LORA_BURST_MAX_READINGS - 1) * FRAME_BURST_DELTA_SIZE];
+    size_t next = 0;
+    size_t sent = 0;
+    while (next < count) {
+        size_t remaining = count - next;
+        size_t encoded = 0;
+        size_t length = encodeBurstPayload(readings + next, remaining < LORA_BURST_MAX_READINGS ? remaining :
+                                           LORA_BURST_MAX_READINGS, message, sizeof(message), encoded);
+        if (length == 0) {
+            break;
+        }
+        
+        LOG_DEBUG("Rajada: seq=%u, %u leitura(s) (%u bytes)", readings[next].sequence, encoded, length);
+        if (sendPayload(FRAME_TYPE_BURST, readings[next].sequence, message, length)) {
+            sent += encoded;
+        } else {
+            LOG_WARN("Falha no envio da rajada seq=%u", readings[next].sequence);
+        }
+        next += encoded;
+    }
+    return sent;
+}
+
+bool LoRaManager::waitForAck(AckFrame &ack, uint32_t timeoutMs) {
+    // O E32 entrega o ack do Gateway (endereço fixo deste Transmitter) no
+    // UART; procura um frame válido nos bytes que chegarem até o prazo
+    uint16_t deviceAddr = frameAddress(TRANSMITTER_ADDH, TRANSMITTER_ADDL);
+    unsigned long start = millis();
+    while (millis() - start < timeoutMs) {
+        while (loraHardwareSerial.available() > 0 && rxLength < sizeof(rxBuffer)) {
+            rxBuffer[rxLength++] = (uint8_t)loraHardwareSerial.read();
+        }
+        
+        while (rxLength >= 2) {
+            size_t total = frameTotalSize(rxBuffer, rxLength);
+            if (total != 0 && rxLength < total) {
+                break;
+            }
+            
+            FrameHeader header;
+            const uint8_t *payload = nullptr;
+            size_t skip = 1;
+            if (total != 0 && decodeFrame(rxBuffer, total, header, payload) == FRAME_OK) {
+                skip = total;
+                if (decodeAckPayload(header, payload, ack) == FRAME_OK && ack.device_addr == deviceAddr) {
+                    memmove(rxBuffer, rxBuffer + skip, rxLength - skip);
+                    rxLength -= skip;
+                    LOG_DEBUG("Ack do Gateway: base=%u bitmap=%08lx", ack.base, (unsigned long)ack.bitmap);
+                    return true;
+                }
+            }
+            // Byte solto ou frame que não é ack para este Transmitter
+            memmove(rxBuffer, rxBuffer + skip, rxLength - skip);
+            rxLength -= skip;
+        }
+        delay(10);
+    }
+    return false;
+}
+
+bool LoRaManager::sendPayload(uint8_t type, uint16_t sequence, const uint8_t *data, size_t length) {
+    if (!isInitialized) {
+        LOG_ERROR("ERRO: Módulo LoRa não inicializado, dados não enviados!");
+        return false;
+    }
+    
+    uint8_t frame[FRAME_MAX_SIZE];
+    uint16_t deviceAddr = frameAddress(TRANSMITTER_ADDH, TRANSMITTER_ADDL);
+    
+    // Cabe num frame: vai direto, sem o header de fragmento
+    if (length <= FRAME_MAX_PAYLOAD) {
+        FrameHeader header;
+        header.type = type;
+        header.payload_length = (uint8_t)length;
+        header.device_addr = deviceAddr;
+        header.sequence = sequence;
+        size_t frameLength = encodeFrame(header, data, frame, sizeof(frame));
+        return frameLength > 0 && sendMessage(frame, frameLength);
+    }
+    if (length > FRAME_MESSAGE_MAX_SIZE) {
+        LOG_ERROR("ERRO: Mensagem de %u bytes excede o limite de %u bytes!", length, FRAME_MESSAGE_MAX_SIZE);
+        return false;
+    }
+    
+    // Fragmentos numerados; sem um deles o Gateway descarta a mensagem, então
+    // a primeira falha encerra o envio
+    FragmentHeader fragment;
+    fragment.message_id = messageId++;
+    fragment.message_type = type;
+    fragment.count = (uint8_t)((length + FRAME_FRAGMENT_DATA_MAX - 1) / FRAME_FRAGMENT_DATA_MAX);
+    for (uint8_t index = 0; index < fragment.count; index++) {
+        fragment.index = index;
+        size_t offset = (size_t)index * FRAME_FRAGMENT_DATA_MAX;
+        size_t chunk = length - offset < FRAME_FRAGMENT_DATA_MAX ? length - offset : FRAME_FRAGMENT_DATA_MAX;
+        size_t frameLength = encodeFragmentFrame(deviceAddr, sequence, fragment, data + offset, chunk, frame,
+                                                 sizeof(frame));
+        if (frameLength == 0 || !sendMessage(frame, frameLength)) {
+            return false;
+        }
+    }
+    LOG_DEBUG("Mensagem %u: %u bytes em %u fragmento(s)", fragment.message_id, length, fragment.count);
+    return true;
+}
+
 void LoRaManager::shutdownLoRa() {
     isInitialized = false;
-    Serial.println("Módulo LoRa desligado!");
+    LOG_INFO("Módulo LoRa desligado!");
+}
+
+ReadingFrame LoRaManager::createReading(const SensorData &data) {
+    ReadingFrame reading;
+    reading.device_addr = frameAddress(TRANSMITTER_ADDH, TRANSMITTER_ADDL);
+    reading.sequence = nextSequence();
+    reading.heart_rate = frameClampU8(data.heart_rate);
+    reading.oxygen_level = frameClampU8(data.oxygen_level);
+    reading.temperature_centi = frameTemperatureToCenti(data.temperature);
+    return reading;
 }
 
-String LoRaManager::createJSON(const SensorData &data) {
+size_t LoRaManager::createFrame(const SensorData &data, uint8_t *out, size_t capacity) {
     
-    // Cria documento JSON COMPACTO (máximo 58 bytes)
-    JsonDocument doc;
+    // Frame binário de leitura (12 bytes, ver frame.h)
+    ReadingFrame reading = createReading(data);
     
-    doc["id"] = TRANSMITTER_ID;         // ID do transmitter definido no header
-    doc["hr"] = data.heart_rate;        // heart_rate -> hr
-    doc["ox"] = data.oxygen_level;      // oxygen_level -> ox  
-    doc["temp"] = data.temperature;     // temperature -> temp
+    size_t frameLength = encodeReadingFrame(reading, out, capacity);
+
+    LOG_DEBUG("Frame criado: seq=%u (%u bytes)", reading.sequence, frameLength);
+    return frameLength;
+}
+
+void LoRaManager::loadSequence() {
+    if (sequenceLoaded) {
+        return;
+    }
     
-    // Serializa para string
-    String jsonString;
-    serializeJson(doc, jsonString);
+    // Continua do início do bloco reservado antes do reinício
+    Preferences prefs;
+    if (prefs.begin("lora", true)) {
+        sequence = prefs.getUShort("seq", 0);
+        prefs.end();
+    }
+    reserveSequenceBlock();
+    sequenceLoaded = true;
+    LOG_INFO("Sequência LoRa inicial: %u", sequence);
+}
 
-    Serial.println("JSON compacto criado: " + jsonString + " (" + String(jsonString.length()) + " bytes)");
-    return jsonString;
+uint16_t LoRaManager::nextSequence() {
+    if (sequence == sequenceLimit) {
+        reserveSequenceBlock();
+    }
+    return sequence++;
+}
+
+void LoRaManager::reserveSequenceBlock() {
+    // Uma escrita no NVS a cada SEQUENCE_PERSIST_BLOCK frames
+    sequenceLimit = (uint16_t)(sequence + SEQUENCE_PERSIST_BLOCK);
+    Preferences prefs;
+    if (prefs.begin("lora", false)) {
+        prefs.putUShort("seq", sequenceLimit);
+        prefs.end();
+    } else {
+        LOG_WARN("Falha ao gravar a sequência LoRa no NVS");
+    }
 }
 
-bool LoRaManager::sendMessage(const String &message) {
-    if (message.length() > 58) {
-        Serial.println("ERRO: Mensagem muito longa para transmissão LoRa!");
+bool LoRaManager::sendMessage(const uint8_t *message, size_t length) {
+    if (length > 58) {
+        LOG_ERROR("ERRO: Mensagem muito longa para transmissão LoRa (%u bytes)!", length);
         return false;
     }
 
-    ResponseStatus rs = e32ttl.sendFixedMessage(GATEWAY_ADDH, GATEWAY_ADDL, CHANNEL, message);
+    ResponseStatus rs = e32ttl.sendFixedMessage(GATEWAY_ADDH, GATEWAY_ADDL, CHANNEL, message, (uint8_t)length);
 
     return (rs.code == 1);
 }
@@ -87,8 +314,8 @@ void LoRaManager::configureLoRaModule()
     Serial.println("Configuração atual obtida com sucesso!");
 
     // Define configurações específicas
-    configuration.ADDH = 0x00; // Endereço alto do Transmitter
-    configuration.ADDL = 0x02; // Endereço baixo do Transmitter
+    configuration.ADDH = TRANSMITTER_ADDH; // O mesmo endereço dos frames e dos acks do Gateway
+    configuration.ADDL = TRANSMITTER_ADDL;
     configuration.CHAN = 23;
     configuration.OPTION.fixedTransmission = FT_FIXED_TRANSMISSION;
     configuration.OPTION.ioDriveMode = IO_D_MODE_PUSH_PULLS_PULL_UPS;
@@ -3,8 +3,9 @@
 
 #include <Arduino.h>
 #include <LoRa_E32.h>
+#include <Preferences.h>
 
-#include <ArduinoJson.h>
+#include "frame.h"
 #include "sensors.h"
 
 // Definições de pinos para conexao com E32
@@ -20,27 +21,80 @@
 #define CHANNEL 0x17         // Canal 23 (0x17 em hex)
 
 // Endereço do próprio Transmitter (único para cada device)
+// O Gateway identifica o dispositivo por este endereço ("TR-%03u", exceto
+// os de DEVICE_ID_ALIASES: 0x0002 -> "TR-001", o ID do JSON legado)
 #define TRANSMITTER_ADDH 0x00  // Endereço alto do Transmitter
 #define TRANSMITTER_ADDL 0x02  // Endereço baixo do Transmitter (0x0002)
 
+// A sequência dos frames sobrevive a reinícios: o NVS guarda o início do
+// próximo bloco de SEQUENCE_PERSIST_BLOCK números, gravado só quando o bloco
+// atual se esgota. Após um reinício a numeração pula o resto do bloco, mas
+// nunca repete um número já enviado.
+#ifndef SEQUENCE_PERSIST_BLOCK
+#define SEQUENCE_PERSIST_BLOCK 32
+#endif
+
+// Maior rajada montada de uma vez; acima de FRAME_BURST_MAX_READINGS
+// leituras a mensagem sai em fragmentos (ver frame.h)
+#ifndef LORA_BURST_MAX_READINGS
+#define LORA_BURST_MAX_READINGS 32
+#endif
+
+// Confirmação do Gateway (FRAME_TYPE_ACK, ver frame.h): depois de cada
+// janela de até LORA_BURST_MAX_READINGS leituras o Transmitter espera o
+// bitmap do Gateway e reenvia só as leituras sem confirmação, no máximo
+// LORA_ACK_RETRIES vezes. O Gateway responde LORA_ACK_DELAY_MS (400 ms)
+// depois do último frame; o prazo cobre isso e o ack no ar. Antes de cada
+// reenvio uma espera aleatória de até LORA_RETRY_JITTER_MS evita repetir a
+// colisão com outro transmissor. Com LORA_ACK_ENABLED 0 o envio volta a ser
+// sem confirmação (Gateway sem suporte a ack)
+#ifndef LORA_ACK_ENABLED
+#define LORA_ACK_ENABLED 1
+#endif
+#ifndef LORA_ACK_TIMEOUT_MS
+#define LORA_ACK_TIMEOUT_MS 1500
+#endif
+#ifndef LORA_ACK_RETRIES
+#define LORA_ACK_RETRIES 3
+#endif
+#ifndef LORA_RETRY_JITTER_MS
+#define LORA_RETRY_JITTER_MS 500
+#endif
+
+static_assert(LORA_BURST_MAX_READINGS <= FRAME_ACK_WINDOW, "a janela de envio precisa caber no bitmap do ack");
 
 class LoRaManager {
 private:
     HardwareSerial loraHardwareSerial;
     LoRa_E32 e32ttl;
     bool isInitialized;
+    uint16_t sequence;     // Sequência do próximo frame enviado
+    uint16_t sequenceLimit; // Primeiro número ainda não reservado no NVS
+    bool sequenceLoaded;
+    uint8_t messageId;     // Id da próxima mensagem fragmentada
+    uint8_t rxBuffer[FRAME_MAX_SIZE]; // Bytes recebidos do Gateway (acks)
+    size_t rxLength;
     
 public:
     LoRaManager();
     bool initLoRa();
     bool sendSensorData(const SensorData &data);
+    size_t sendSensorBurst(const SensorData *data, size_t count);
+    bool sendPayload(uint8_t type, uint16_t sequence, const uint8_t *data, size_t length);
     void shutdownLoRa();
     
 private:
     void configureLoRaModule();
     void printConfiguration();
-    String createJSON(const SensorData &data);
-    bool sendMessage(const String &message);
+    void loadSequence();
+    uint16_t nextSequence();
+    void reserveSequenceBlock();
+    ReadingFrame createReading(const SensorData &data);
+    size_t createFrame(const SensorData &data, uint8_t *out, size_t capacity);
+    size_t sendReadings(const ReadingFrame *readings, size_t count);
+    size_t sendWindow(const ReadingFrame *readings, size_t count);
+    bool waitForAck(AckFrame &ack, uint32_t timeoutMs);
+    bool sendMessage(const uint8_t *message, size_t length);
 };
 
 #endif
@@ -16,6 +16,7 @@
 #include <Arduino.h>
 #include "sensors.h"
 #include "lora.h"
+#include "log.h"
 #define BUTTON_PIN 18
 #define DATA_BUFFER_SIZE 10
 
@@ -31,7 +32,8 @@ void setup() {
     delay(1000);
 
     Serial.begin(115200);
-    Serial.println("Iniciando sistema VitalSync - Transmitter");
+    logInit(1, 0);
+    LOG_INFO("Iniciando sistema VitalSync - Transmitter");
 }
 
 void loop() {
@@ -43,12 +45,12 @@ void loop() {
     isSendingData = true;
     
     // SENSORES
-    Serial.println("Iniciando leitura dos sensores");
+    LOG_INFO("Iniciando leitura dos sensores");
 
     sensorManager.initSensors();
 
     // Aguardando estabilização do sensor
-    Serial.println("1. Aguardando estabilização do sensor");
+    LOG_INFO("1. Aguardando estabilização do sensor");
     SensorData dataTemp;
     for(int i = 0; i < 200; i++)
     {
@@ -57,42 +59,43 @@ void loop() {
     }
 
     // Fazendo a leitura dos dados
-    Serial.println("2. Lendo dados do oxímetro");
+    LOG_INFO("2. Lendo dados do oxímetro");
 
     for(int i = 0; i < DATA_BUFFER_SIZE; i++) {
         sensorManager.readOximeter(sensorDataBuffer[i]);
         delay(100);
     }
 
-    Serial.println("OK! Aguardando 10 segundos para leitura do termômetro");
+    LOG_INFO("OK! Aguardando 10 segundos para leitura do termômetro");
 
     delay(10000);
     
-    Serial.println("3. Lendo dados do termômetro");
+    LOG_INFO("3. Lendo dados do termômetro");
     for(int i = 0; i < DATA_BUFFER_SIZE; i++) {
         sensorManager.readTemperature(sensorDataBuffer[i]);
         delay(100);
     }
 
-    Serial.println("OK!");
+    LOG_INFO("OK!");
 
     // LORA
-    Serial.println("Iniciando transmissão via LoRa"); 
+    LOG_INFO("Iniciando transmissão via LoRa");
 
     // inicializando o módulo
     loraManager.initLoRa();
 
-    // enviando os dados
     for(int i = 0; i < DATA_BUFFER_SIZE; i++) {
-        Serial.println("DADO N" + String(i+1) + 
-        ": Temp=" + String(sensorDataBuffer[i].temperature) + 
-        "C, HR=" + String(sensorDataBuffer[i].heart_rate) + 
-        "bpm, SpO2=" + String(sensorDataBuffer[i].oxygen_level) + "%");
-
+        LOG_INFO("DADO N%d: Temp=%.2fC, HR=%dbpm, SpO2=%d%%", i + 1, sensorDataBuffer[i].temperature,
+                 sensorDataBuffer[i].heart_rate, sensorDataBuffer[i].oxygen_level);
+    }
 
-        int res = loraManager.sendSensorData(sensorDataBuffer[i]);
-        Serial.println(res ? "Enviado com sucesso!" : "Falha no envio!");
-        delay(100);
+    // enviando os dados: o buffer inteiro num frame de rajada (base + deltas),
+    // com reenvio das leituras que o Gateway não confirmar
+    size_t confirmed = loraManager.sendSensorBurst(sensorDataBuffer, DATA_BUFFER_SIZE);
+    if (confirmed == DATA_BUFFER_SIZE) {
+        LOG_INFO("Enviado com sucesso! Gateway confirmou as %d leituras", DATA_BUFFER_SIZE);
+    } else {
+        LOG_WARN("Falha no envio! %u de %d leituras confirmadas pelo Gateway", confirmed, DATA_BUFFER_SIZE);
     }
 
     isSendingData = false;
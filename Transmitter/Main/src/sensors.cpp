@@ -1,4 +1,5 @@
 #include "sensors.h"
+#include "log.h"
 #include <WiFi.h>
 
 // Variável global estática para callback
@@ -6,7 +7,7 @@ static SensorManager* instance = nullptr;
 
 // Callback para detecção de batimento cardíaco
 void SensorManager::onBeatDetected() {
-    Serial.println("Batimento cardíaco detectado!");
+    LOG_DEBUG("Batimento cardíaco detectado!");
 }
 
 SensorManager::SensorManager() : tsLastReport(0) {
@@ -26,7 +27,7 @@ bool SensorManager::initSensors() {
     // Inicializa o oxímetro MAX30100
     // if (!pox.begin(PULSEOXIMETER_DEBUGGINGMODE_PULSEDETECT)) {
     if (!pox.begin()) {
-        Serial.println("ERRO: Falha ao inicializar o oxímetro MAX30100");
+        LOG_ERROR("ERRO: Falha ao inicializar o oxímetro MAX30100");
         return false;
     }
     